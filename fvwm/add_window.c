@@ -47,8 +47,11 @@
 #include "config.h"
 
 #include <stdio.h>
+#include <time.h>
+#include <X11/Xatom.h>
 
 #include "libs/fvwmlib.h"
+#include "libs/ftime.h"
 #include "libs/FShape.h"
 #include "libs/Picture.h"
 #include "libs/PictureUtils.h"
@@ -57,6 +60,7 @@
 #include "libs/Grab.h"
 #include "libs/Strings.h"
 #include "libs/XResource.h"
+#include "libs/FProperty.h"
 #include "fvwm.h"
 #include "externs.h"
 #include "cursor.h"
@@ -86,6 +90,7 @@
 #include "decorations.h"
 #include "functions.h"
 #include "virtual.h"
+#include "geom_index.h"
 
 /* ---------------------------- local definitions -------------------------- */
 
@@ -93,6 +98,8 @@
 
 /* ---------------------------- imports ------------------------------------ */
 
+extern Atom _XA_MwmAtom;
+
 /* ---------------------------- included code files ------------------------ */
 
 /* ---------------------------- local types -------------------------------- */
@@ -101,6 +108,15 @@
 
 /* ---------------------------- local variables ---------------------------- */
 
+/* timing of the last CaptureAllWindows */
+static struct
+{
+	long msecs;
+	unsigned int n_children;
+	unsigned int n_managed;
+	Bool is_recapture;
+} capture_stats;
+
 /* ---------------------------- exported variables (globals) --------------- */
 
 char NoName[] = "Untitled"; /* name if no name in XA_WM_NAME */
@@ -116,11 +132,9 @@ static void delete_client_context(FvwmWindow *fw)
 	/* We can not simply delete the context.  X might have reused the
 	 * window structure so we would delete the context that was established
 	 * by another FvwmWindow structure in the mean time. */
-	if (XFindContext(
-		    dpy, FW_W(fw), FvwmContext, (caddr_t *)&cw) !=
-	    XCNOENT && cw == fw)
+	if (wintable_find(FvwmWindowTable, FW_W(fw), (void **)&cw) && cw == fw)
 	{
-		XDeleteContext(dpy, FW_W(fw), FvwmContext);
+		wintable_remove(FvwmWindowTable, FW_W(fw));
 	}
 
 	return;
@@ -136,6 +150,41 @@ static void delete_client_context(FvwmWindow *fw)
  *
  */
 
+/* Send the requests for everything AddWindow reads while the server is
+ * grabbed at once, see FPropertyPrefetch.  With is_capture the WM_STATE read
+ * by MappedNotOverride is fetched too. */
+static void prefetch_window_properties(
+	Window *windows, int n_windows, Bool is_capture)
+{
+	Atom atoms[32];
+	int n = 0;
+
+	atoms[n++] = XA_WM_NAME;
+	atoms[n++] = XA_WM_ICON_NAME;
+	atoms[n++] = XA_WM_CLASS;
+	atoms[n++] = XA_WM_HINTS;
+	atoms[n++] = XA_WM_NORMAL_HINTS;
+	atoms[n++] = XA_WM_TRANSIENT_FOR;
+	atoms[n++] = XA_WM_COMMAND;
+	atoms[n++] = _XA_WM_PROTOCOLS;
+	atoms[n++] = _XA_WM_COLORMAP_WINDOWS;
+	atoms[n++] = _XA_WM_CLIENT_LEADER;
+	atoms[n++] = _XA_WM_WINDOW_ROLE;
+	atoms[n++] = _XA_WINDOW_ROLE;
+	atoms[n++] = _XA_MwmAtom;
+	atoms[n++] = _XA_OL_WIN_ATTR;
+	atoms[n++] = _XA_OL_DECOR_ADD;
+	atoms[n++] = _XA_OL_DECOR_DEL;
+	if (is_capture)
+	{
+		atoms[n++] = _XA_WM_STATE;
+	}
+	n += EWMH_GetPrefetchAtoms(atoms + n, sizeof(atoms) / sizeof(Atom) - n);
+	FPropertyPrefetch(dpy, windows, n_windows, atoms, n);
+
+	return;
+}
+
 static void CaptureOneWindow(
 	const exec_context_t *exc, FvwmWindow *fw, Window window,
 	Window keep_on_top_win, Window parent_win, Bool is_recapture)
@@ -174,7 +223,7 @@ static void CaptureOneWindow(
 		MyXUngrabServer(dpy);
 		return;
 	}
-	if (XFindContext(dpy, window, FvwmContext, (caddr_t *)&fw) != XCNOENT)
+	if (wintable_find(FvwmWindowTable, window, (void **)&fw))
 	{
 		Bool is_mapped = IS_MAPPED(fw);
 
@@ -356,11 +405,11 @@ static int MappedNotOverride(
 	unsigned char *prop;
 
 	win_opts->initial_state = DontCareState;
-	if ((w==Scr.NoFocusWin)||(!XGetWindowAttributes(dpy, w, &wa)))
+	if ((w==Scr.NoFocusWin)||(!FGetWindowAttributes(dpy, w, &wa)))
 	{
 		return 0;
 	}
-	if (XGetWindowProperty(
+	if (FGetWindowProperty(
 		    dpy,w,_XA_WM_STATE,0L,3L,False,_XA_WM_STATE,
 		    &atype,&aformat,&nitems,&bytes_remain,&prop)==Success)
 	{
@@ -373,6 +422,7 @@ static int MappedNotOverride(
 	if (wa.override_redirect == True)
 	{
 		XSelectInput(dpy, w, XEVMASK_ORW);
+		FPropertyInvalidate(w, None);
 		XFlush(dpy);
 	}
 
@@ -717,7 +767,7 @@ static void setup_class_and_resource(FvwmWindow *fw)
 	/* removing NoClass change for now... */
 	fw->class.res_name = NoResource;
 	fw->class.res_class = NoClass;
-	XGetClassHint(dpy, FW_W(fw), &fw->class);
+	FGetClassHint(dpy, FW_W(fw), &fw->class);
 	if (fw->class.res_name == NULL)
 	{
 		fw->class.res_name = NoResource;
@@ -735,7 +785,7 @@ static void setup_class_and_resource(FvwmWindow *fw)
 static void setup_window_attr(
 	FvwmWindow *fw, XWindowAttributes *ret_attr)
 {
-	if (XGetWindowAttributes(dpy, FW_W(fw), ret_attr) == 0)
+	if (FGetWindowAttributes(dpy, FW_W(fw), ret_attr) == 0)
 	{
 		/* can't happen because fvwm has grabbed the server and does
 		 * not destroy the window itself */
@@ -996,8 +1046,8 @@ static void setup_frame_window(
 		dpy, Scr.Root, fw->g.frame.x, fw->g.frame.y,
 		fw->g.frame.width, fw->g.frame.height, 0, depth,
 		InputOutput, visual, valuemask, &attributes);
-	XSaveContext(dpy, FW_W(fw), FvwmContext, (caddr_t) fw);
-	XSaveContext(dpy, FW_W_FRAME(fw), FvwmContext, (caddr_t) fw);
+	wintable_insert(FvwmWindowTable, FW_W(fw), fw);
+	wintable_insert(FvwmWindowTable, FW_W_FRAME(fw), fw);
 
 	return;
 }
@@ -1012,7 +1062,7 @@ static void setup_title_window(
 	FW_W_TITLE(fw) = XCreateWindow(
 		dpy, FW_W_FRAME(fw), 0, 0, 1, 1, 0, Pdepth, InputOutput,
 		Pvisual, valuemask, pattributes);
-	XSaveContext(dpy, FW_W_TITLE(fw), FvwmContext, (caddr_t) fw);
+	wintable_insert(FvwmWindowTable, FW_W_TITLE(fw), fw);
 
 	return;
 }
@@ -1024,7 +1074,7 @@ static void destroy_title_window(FvwmWindow *fw, Bool do_only_delete_context)
 		XDestroyWindow(dpy, FW_W_TITLE(fw));
 		FW_W_TITLE(fw) = None;
 	}
-	XDeleteContext(dpy, FW_W_TITLE(fw), FvwmContext);
+	wintable_remove(FvwmWindowTable, FW_W_TITLE(fw));
 	XFlush(dpy);
 	FW_W_TITLE(fw) = None;
 
@@ -1070,15 +1120,14 @@ static void setup_button_windows(
 					dpy, FW_W_FRAME(fw), 0, 0, 1, 1, 0,
 					Pdepth, InputOutput, Pvisual,
 					valuemask, pattributes);
-			XSaveContext(
-				dpy, FW_W_BUTTON(fw, i), FvwmContext,
-				(caddr_t)fw);
+			wintable_insert(
+				FvwmWindowTable, FW_W_BUTTON(fw, i), fw);
 		}
 		else if (FW_W_BUTTON(fw, i) != None && !has_button)
 		{
 			/* destroy the current button window */
 			XDestroyWindow(dpy, FW_W_BUTTON(fw, i));
-			XDeleteContext(dpy, FW_W_BUTTON(fw, i), FvwmContext);
+			wintable_remove(FvwmWindowTable, FW_W_BUTTON(fw, i));
 			is_deleted = True;
 			FW_W_BUTTON(fw, i) = None;
 		}
@@ -1105,7 +1154,7 @@ static void destroy_button_windows(FvwmWindow *fw, Bool do_only_delete_context)
 				XDestroyWindow(dpy, FW_W_BUTTON(fw, i));
 				FW_W_BUTTON(fw, i) = None;
 			}
-			XDeleteContext(dpy, FW_W_BUTTON(fw, i), FvwmContext);
+			wintable_remove(FvwmWindowTable, FW_W_BUTTON(fw, i));
 			is_deleted = True;
 			FW_W_BUTTON(fw, i) = None;
 		}
@@ -1160,7 +1209,7 @@ static void setup_parent_window(FvwmWindow *fw)
 		0, CopyFromParent, InputOutput, CopyFromParent, valuemask,
 		&attributes);
 
-	XSaveContext(dpy, FW_W_PARENT(fw), FvwmContext, (caddr_t) fw);
+	wintable_insert(FvwmWindowTable, FW_W_PARENT(fw), fw);
 
 	return;
 }
@@ -1234,13 +1283,12 @@ static void setup_resize_handle_windows(FvwmWindow *fw)
 		FW_W_CORNER(fw, i) = XCreateWindow(
 			dpy, FW_W_FRAME(fw), -1, -1, 1, 1, 0, Pdepth,
 			InputOutput, Pvisual, valuemask, &attributes);
-		XSaveContext(
-			dpy, FW_W_CORNER(fw, i), FvwmContext, (caddr_t)fw);
+		wintable_insert(FvwmWindowTable, FW_W_CORNER(fw, i), fw);
 		attributes.win_gravity = s_grav[i];
 		FW_W_SIDE(fw, i) = XCreateWindow(
 			dpy, FW_W_FRAME(fw), -1, -1, 1, 1, 0, Pdepth,
 			InputOutput, Pvisual, valuemask, &attributes);
-		XSaveContext(dpy, FW_W_SIDE(fw, i), FvwmContext, (caddr_t)fw);
+		wintable_insert(FvwmWindowTable, FW_W_SIDE(fw, i), fw);
 	}
 	setup_resize_handle_cursors(fw);
 
@@ -1254,8 +1302,8 @@ static void destroy_resize_handle_windows(
 
 	for (i = 0; i < 4 ; i++)
 	{
-		XDeleteContext(dpy, FW_W_SIDE(fw, i), FvwmContext);
-		XDeleteContext(dpy, FW_W_CORNER(fw, i), FvwmContext);
+		wintable_remove(FvwmWindowTable, FW_W_SIDE(fw, i));
+		wintable_remove(FvwmWindowTable, FW_W_CORNER(fw, i));
 		if (!do_only_delete_context)
 		{
 			XDestroyWindow(dpy, FW_W_SIDE(fw, i));
@@ -1402,8 +1450,8 @@ static void destroy_auxiliary_windows(
 {
 	if (destroy_frame_and_parent)
 	{
-		XDeleteContext(dpy, FW_W_FRAME(fw), FvwmContext);
-		XDeleteContext(dpy, FW_W_PARENT(fw), FvwmContext);
+		wintable_remove(FvwmWindowTable, FW_W_FRAME(fw));
+		wintable_remove(FvwmWindowTable, FW_W_PARENT(fw));
 		delete_client_context(fw);
 		XDestroyWindow(dpy, FW_W_FRAME(fw));
 	}
@@ -1495,7 +1543,7 @@ static void setup_icon(FvwmWindow *fw, window_style *pstyle)
 		fw->icon_name.name = NoName;
 		fw->icon_name.name_list = NULL;
 		FlocaleGetNameProperty(
-			XGetWMIconName, dpy, FW_W(fw), &(fw->icon_name));
+			FGetWMIconName, dpy, FW_W(fw), &(fw->icon_name));
 	}
 	if (fw->icon_name.name == NoName)
 	{
@@ -1554,7 +1602,7 @@ static void destroy_icon(FvwmWindow *fw)
 	if (FW_W_ICON_TITLE(fw))
 	{
 		XDestroyWindow(dpy, FW_W_ICON_TITLE(fw));
-		XDeleteContext(dpy, FW_W_ICON_TITLE(fw), FvwmContext);
+		wintable_remove(FvwmWindowTable, FW_W_ICON_TITLE(fw));
 		XFlush(dpy);
 	}
 	if (FW_W_ICON_PIXMAP(fw) != None)
@@ -1567,7 +1615,7 @@ static void destroy_icon(FvwmWindow *fw)
 		{
 			XUnmapWindow(dpy, FW_W_ICON_PIXMAP(fw));
 		}
-		XDeleteContext(dpy, FW_W_ICON_PIXMAP(fw), FvwmContext);
+		wintable_remove(FvwmWindowTable, FW_W_ICON_PIXMAP(fw));
 	}
 	clear_icon(fw);
 	XFlush(dpy);
@@ -1685,7 +1733,7 @@ static void __add_window_handle_x_resources(FvwmWindow *fw)
 	/* Find out if the client requested a specific style on the command
 	 * line.
 	 */
-	if (XGetCommand(dpy, FW_W(fw), &client_argv, &client_argc))
+	if (FGetCommand(dpy, FW_W(fw), &client_argv, &client_argc))
 	{
 		if (client_argc > 0 && client_argv != NULL)
 		{
@@ -1898,7 +1946,7 @@ void setup_window_name(FvwmWindow *fw)
 	{
 		fw->name.name = NoName;
 		fw->name.name_list = NULL;
-		FlocaleGetNameProperty(XGetWMName, dpy, FW_W(fw), &(fw->name));
+		FlocaleGetNameProperty(FGetWMName, dpy, FW_W(fw), &(fw->name));
 	}
 
 	return;
@@ -1906,7 +1954,7 @@ void setup_window_name(FvwmWindow *fw)
 
 void setup_wm_hints(FvwmWindow *fw)
 {
-	fw->wmhints = XGetWMHints(dpy, FW_W(fw));
+	fw->wmhints = FGetWMHints(dpy, FW_W(fw));
 	set_focus_model(fw);
 
 	return;
@@ -2289,7 +2337,7 @@ Bool validate_transientfor(FvwmWindow *fw)
 		FW_W_TRANSIENTFOR(fw) = Scr.Root;
 		return False;
 	}
-	else if (XFindContext(dpy, w, FvwmContext, (caddr_t *)&cw) != XCNOENT)
+	else if (wintable_find(FvwmWindowTable, w, (void **)&cw))
 	{
 		if (cw == fw)
 		{
@@ -2298,9 +2346,9 @@ Bool validate_transientfor(FvwmWindow *fw)
 			return False;
 		}
 		/* Check for transient loops */
-		while (XFindContext(
-			       dpy, FW_W_TRANSIENTFOR(cw), FvwmContext,
-			       (caddr_t *)&cw) != XCNOENT &&
+		while (wintable_find(
+			       FvwmWindowTable, FW_W_TRANSIENTFOR(cw),
+			       (void **)&cw) &&
 		       IS_TRANSIENT(cw))
 		{
 			if (FW_W_TRANSIENTFOR(cw) == FW_W(fw) || cw == fw)
@@ -2326,7 +2374,7 @@ Bool setup_transientfor(FvwmWindow *fw)
 {
 	Bool rc;
 
-	rc = XGetTransientForHint(dpy, FW_W(fw), &FW_W_TRANSIENTFOR(fw));
+	rc = FGetTransientForHint(dpy, FW_W(fw), &FW_W_TRANSIENTFOR(fw));
 	SET_TRANSIENT(fw, rc);
 	if (rc == False)
 	{
@@ -2380,7 +2428,8 @@ FvwmWindow *AddWindow(
 	 * reparented, so we'll get a DestroyNotify for it.  We won't have
 	 * gotten one for anything up to here, however. ******/
 	MyXGrabServer(dpy);
-	if (XGetGeometry(
+	prefetch_window_properties(&w, 1, False);
+	if (FGetGeometry(
 		    dpy, w, &JunkRoot, &JunkX, &JunkY,
 		    (unsigned int*)&JunkWidth, (unsigned int*)&JunkHeight,
 		    (unsigned int*)&JunkBW, (unsigned int*)&JunkDepth) == 0)
@@ -2390,6 +2439,7 @@ FvwmWindow *AddWindow(
 			fvwm_msg(INFO, "AddWindow", "new window disappeared");
 		}
 		free(fw);
+		FPropertyDrop(w);
 		MyXUngrabServer(dpy);
 		return NULL;
 	}
@@ -2422,6 +2472,7 @@ FvwmWindow *AddWindow(
 			free(fw->style_name);
 		}
 		free(fw);
+		FPropertyDrop(w);
 		MyXUngrabServer(dpy);
 		return AW_UNMANAGED;
 	}
@@ -2629,6 +2680,9 @@ FvwmWindow *AddWindow(
 	}
 
 	/****** now we can sefely ungrab the server ******/
+	/* The prefetched properties are kept until EWMH_WindowInit has run.
+	 * Changes after the grab generate PropertyNotify events that are
+	 * handled later with fresh data. */
 	MyXUngrabServer(dpy);
 
 	/* need to set up the mini icon before drawing */
@@ -2661,6 +2715,9 @@ FvwmWindow *AddWindow(
 	/****** grab keys and buttons ******/
 	setup_key_and_button_grabs(fw);
 
+	/****** spatial index ******/
+	geom_index_add(fw);
+
 	/****** inform modules of new window ******/
 	UPDATE_FVWM_SCREEN(fw);
 	BroadcastConfig(M_ADD_WINDOW,fw);
@@ -2730,6 +2787,8 @@ FvwmWindow *AddWindow(
 	{
 		XEvent e;
 
+		/* the interactive resize handles events */
+		FPropertyDrop(w);
 		memset(&e, 0, sizeof(e));
 		FWarpPointer(
 			dpy, Scr.Root, Scr.Root, 0, 0,
@@ -2761,6 +2820,7 @@ FvwmWindow *AddWindow(
 
 	/****** ewmh setup *******/
 	EWMH_WindowInit(fw);
+	FPropertyDrop(w);
 
 	/****** windowshade ******/
 	if (state_args.do_shade || SDO_START_SHADED(sflags))
@@ -2868,7 +2928,7 @@ void FetchWmProtocols(FvwmWindow *tmp)
 	}
 	/* First, try the Xlib function to read the protocols.
 	 * This is what Twm uses. */
-	if (XGetWMProtocols (dpy, FW_W(tmp), &protocols, &n))
+	if (FGetWMProtocols(dpy, FW_W(tmp), &protocols, &n))
 	{
 		for (i = 0, ap = protocols; i < n; i++, ap++)
 		{
@@ -2891,7 +2951,7 @@ void FetchWmProtocols(FvwmWindow *tmp)
 	{
 		/* Next, read it the hard way. mosaic from Coreldraw needs to
 		 * be read in this way. */
-		if ((XGetWindowProperty(
+		if ((FGetWindowProperty(
 			     dpy, FW_W(tmp), _XA_WM_PROTOCOLS, 0L, 10L, False,
 			     _XA_WM_PROTOCOLS, &atype, &aformat, &nitems,
 			     &bytes_remain,
@@ -2931,7 +2991,8 @@ void GetWindowSizeHintsWithCheck(
 	Status rc;
 
 	new_hints = fw->hints;
-	rc = FGetWMNormalHints(dpy, FW_W(fw), &orig_hints, &supplied);
+	rc = FGetWMSizeHints(
+		dpy, FW_W(fw), &orig_hints, &supplied, XA_WM_NORMAL_HINTS);
 	if (rc == 0)
 	{
 		new_hints.flags = 0;
@@ -3410,6 +3471,7 @@ void destroy_window(FvwmWindow *fw)
 		}
 		fw->next = NULL;
 		fw->prev = NULL;
+		geom_index_remove(fw);
 
 		/****** also remove it from the stack ring ******/
 
@@ -3725,10 +3787,14 @@ void CaptureAllWindows(const exec_context_t *exc, Bool is_recapture)
 {
 	int i,j;
 	unsigned int nchildren;
+	unsigned int n_managed = 0;
 	Window root, parent, *children;
 	initial_window_options_t win_opts;
 	FvwmWindow *fw;
+	struct timespec start;
+	struct timespec end;
 
+	clock_gettime(CLOCK_MONOTONIC, &start);
 	MyXGrabServer(dpy);
 	if (!XQueryTree(dpy, Scr.Root, &root, &parent, &children, &nchildren))
 	{
@@ -3744,12 +3810,16 @@ void CaptureAllWindows(const exec_context_t *exc, Bool is_recapture)
 		exec_context_changes_t ecc;
 		XEvent e;
 
+		/* Fetch everything MappedNotOverride and AddWindow need for
+		 * all windows in one go instead of one round trip per request;
+		 * the server is grabbed until all windows are captured. */
+		prefetch_window_properties(children, nchildren, True);
 		/* weed out icon windows */
 		for (i = 0; i < nchildren; i++)
 		{
 			if (children[i])
 			{
-				XWMHints *wmhintsp = XGetWMHints(
+				XWMHints *wmhintsp = FGetWMHints(
 					dpy, children[i]);
 
 				if (wmhintsp &&
@@ -3781,6 +3851,8 @@ void CaptureAllWindows(const exec_context_t *exc, Bool is_recapture)
 			    MappedNotOverride(children[i], &win_opts))
 			{
 				XUnmapWindow(dpy, children[i]);
+				FPropertyInvalidate(children[i], None);
+				n_managed++;
 				e.xmaprequest.window = children[i];
 				e.xmaprequest.parent = Scr.Root;
 				ecc.w.fw = NULL;
@@ -3809,13 +3881,13 @@ void CaptureAllWindows(const exec_context_t *exc, Bool is_recapture)
 		/* reborder all windows */
 		for (i=0;i<nchildren;i++)
 		{
-			if (XFindContext(
-				    dpy, children[i], FvwmContext,
-				    (caddr_t *)&fw) != XCNOENT)
+			if (wintable_find(
+				    FvwmWindowTable, children[i], (void **)&fw))
 			{
 				CaptureOneWindow(
 					exc, fw, children[i], keep_on_top_win,
 					parent_win, is_recapture);
+				n_managed++;
 			}
 		}
 		hide_screen(False, NULL, NULL);
@@ -3837,7 +3909,45 @@ void CaptureAllWindows(const exec_context_t *exc, Bool is_recapture)
 	{
 		XFree((char *)children);
 	}
+	/* icon windows, unmapped and override redirect windows */
+	FPropertyDropAll();
 	MyXUngrabServer(dpy);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	capture_stats.is_recapture = is_recapture;
+	capture_stats.n_children = nchildren;
+	capture_stats.n_managed = n_managed;
+	capture_stats.msecs =
+		(end.tv_sec - start.tv_sec) * 1000 +
+		(end.tv_nsec - start.tv_nsec) / 1000000;
+
+	return;
+}
+
+/* Prints how long the last (re)capture of all windows took. */
+void print_capture_info(int verbose)
+{
+	fflush(stderr);
+	fflush(stdout);
+	fprintf(stderr, "fvwm info on window capture:\n");
+	if (capture_stats.n_children == 0 && capture_stats.msecs == 0)
+	{
+		fprintf(stderr, "  no capture yet\n");
+	}
+	else
+	{
+		fprintf(stderr,
+			"  last %s: %u of %u top level windows in %ld ms\n",
+			capture_stats.is_recapture ? "recapture" :
+			"initial capture", capture_stats.n_managed,
+			capture_stats.n_children, capture_stats.msecs);
+		if (verbose > 0 && capture_stats.n_managed > 0)
+		{
+			fprintf(stderr, "  %.2f ms per window\n",
+				(double)capture_stats.msecs /
+				capture_stats.n_managed);
+		}
+	}
+	fflush(stderr);
 
 	return;
 }
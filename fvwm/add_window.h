@@ -74,5 +74,6 @@ void RestoreWithdrawnLocation(
 	FvwmWindow *tmp, Bool is_restart_or_recapture, Window parent);
 void Reborder(void);
 void CaptureAllWindows(const exec_context_t *exc, Bool is_recapture);
+void print_capture_info(int verbose);
 
 #endif /* ADD_WINDOW_H */
@@ -42,6 +42,7 @@
 #include "libs/wcontext.h"
 #include "libs/Flocale.h"
 #include "libs/Ficonv.h"
+#include "libs/FProperty.h"
 #include "fvwm.h"
 #include "externs.h"
 #include "colorset.h"
@@ -53,6 +54,7 @@
 #include "screen.h"
 #include "builtins.h"
 #include "module_interface.h"
+#include "module_list.h"
 #include "borders.h"
 #include "frame.h"
 #include "events.h"
@@ -121,6 +123,9 @@ static char *button_states[BS_MaxButtonStateName + 1] =
 
 char *ModulePath = FVWM_MODULEDIR;
 int moduleTimeout = DEFAULT_MODULE_TIMEOUT;
+/* soft limits after which a lagging module is warned about; 0 is off */
+int moduleWarnTimeout = 0;
+int moduleWarnQueueSize = 0;
 
 /* ---------------------------- local functions ---------------------------- */
 
@@ -2533,9 +2538,9 @@ void CMD_Wait(F_CMD_ARGS)
 		if (My_XNextEvent(dpy, &e))
 		{
 			dispatch_event(&e);
-			if (XFindContext(
-				    dpy, e.xmap.window, FvwmContext,
-				    (caddr_t *)&t) == XCNOENT)
+			if (!wintable_find(
+				    FvwmWindowTable, e.xmap.window,
+				    (void **)&t))
 			{
 				t = NULL;
 			}
@@ -2691,6 +2696,44 @@ void CMD_PrintInfo(F_CMD_ARGS)
 	{
 		print_infostore();
 	}
+	else if (StrEquals(subject, "PropertyCache"))
+	{
+		FPropertyPrintInfo(verbose);
+	}
+	else if (StrEquals(subject, "Capture"))
+	{
+		print_capture_info(verbose);
+	}
+	else if (StrEquals(subject, "WindowTable"))
+	{
+		wintable_print_info(FvwmWindowTable, "fvwm windows", verbose);
+	}
+	else if (StrEquals(subject, "Modules"))
+	{
+		print_module_info(verbose);
+	}
+	else if (StrEquals(subject, "EventStats"))
+	{
+		char *option;
+
+		option = PeekToken(rest, NULL);
+		if (StrEquals(option, "On"))
+		{
+			event_stats_enable(True);
+		}
+		else if (StrEquals(option, "Off"))
+		{
+			event_stats_enable(False);
+		}
+		else if (StrEquals(option, "Reset"))
+		{
+			event_stats_reset();
+		}
+		else
+		{
+			print_event_stats(verbose);
+		}
+	}
 	else
 	{
 		fvwm_msg(ERR, "PrintInfo",
@@ -2793,12 +2836,24 @@ void CMD_ModulePath(F_CMD_ARGS)
 
 void CMD_ModuleTimeout(F_CMD_ARGS)
 {
-	int timeout;
+	int val[3];
+	int n;
 
 	moduleTimeout = DEFAULT_MODULE_TIMEOUT;
-	if (GetIntegerArguments(action, NULL, &timeout, 1) == 1 && timeout > 0)
+	moduleWarnTimeout = 0;
+	moduleWarnQueueSize = 0;
+	n = GetIntegerArguments(action, NULL, val, 3);
+	if (n >= 1 && val[0] > 0)
+	{
+		moduleTimeout = val[0];
+	}
+	if (n >= 2 && val[1] > 0)
+	{
+		moduleWarnTimeout = val[1];
+	}
+	if (n >= 3 && val[2] > 0)
 	{
-		moduleTimeout = timeout;
+		moduleWarnQueueSize = val[2] * 1024;
 	}
 
 	return;
@@ -3722,6 +3777,27 @@ void CMD_BugOpts(F_CMD_ARGS)
 			}
 			monitor_dump_state(NULL);
 		}
+		else if (StrEquals(opt, "DebugFrameRate"))
+		{
+			switch (toggle)
+			{
+			case -1:
+				Scr.bo.do_debug_frame_rate ^= 1;
+				break;
+			case 0:
+			case 1:
+				Scr.bo.do_debug_frame_rate = toggle;
+				break;
+			default:
+				Scr.bo.do_debug_frame_rate = 0;
+				break;
+			}
+			/* make room for the numbers */
+			if (Scr.SizeWindow != None)
+			{
+				resize_geometry_window();
+			}
+		}
 		else if (StrEquals(opt, "TransliterateUtf8"))
 		{
 			FiconvSetTransliterateUtf8(toggle);
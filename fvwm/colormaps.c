@@ -20,6 +20,7 @@
 #include <stdio.h>
 
 #include "libs/fvwmlib.h"
+#include "libs/FProperty.h"
 #include "fvwm.h"
 #include "externs.h"
 #include "cursor.h"
@@ -103,9 +104,8 @@ void colormap_handle_colormap_notify(const evh_args_t *ea)
 
 	while (FCheckTypedEvent(dpy, ColormapNotify, &evdummy))
 	{
-		if (XFindContext(
-			    dpy, cevent->window, FvwmContext,
-			    (caddr_t *) &fw) == XCNOENT)
+		if (!wintable_find(
+			    FvwmWindowTable, cevent->window, (void **)&fw))
 		{
 			fw = NULL;
 		}
@@ -349,7 +349,7 @@ void FetchWmColormapWindows (FvwmWindow *fw)
 		XFree((void *)fw->cmap_windows);
 	}
 
-	if (!XGetWMColormapWindows (dpy, FW_W(fw), &(fw->cmap_windows),
+	if (!FGetWMColormapWindows(dpy, FW_W(fw), &(fw->cmap_windows),
 				   &(fw->number_cmap_windows)))
 	{
 		fw->number_cmap_windows = 0;
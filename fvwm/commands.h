@@ -96,8 +96,10 @@ enum
 	F_NEXT,
 	F_NONE,
 	F_OPAQUE,
+	F_OPAQUE_FRAME_RATE,
 	F_PICK,
 	F_PIXMAP_PATH,
+	F_PLACEMENT_THREADS,
 	F_POINTERKEY,
 	F_POINTERWINDOW,
 	F_POPUP,
@@ -120,9 +122,13 @@ enum
 	F_SETDESK,
 	F_SETENV,
 	F_SET_ANIMATION,
+	F_SET_COALESCE_MASK,
+	F_SET_FILTER,
 	F_SET_MASK,
 	F_SET_NOGRAB_MASK,
+	F_SET_RING,
 	F_SET_SYNC_MASK,
+	F_SET_SYNC_TIMEOUT,
 	F_SHADE_ANIMATE,
 	F_SILENT,
 	F_SNAP_ATT,
@@ -198,7 +204,9 @@ enum
 
 	/* Functions for use by modules only! */
 	F_SEND_WINDOW_LIST = 1000,
-	F_SEND_REPLY
+	F_SEND_REPLY,
+	F_SEND_MODULE_STATS,
+	F_SEND_EVENT_STATS
 };
 
 /* ---------------------------- exported variables (globals) --------------- */
@@ -313,11 +321,13 @@ void CMD_Next(F_CMD_ARGS);
 void CMD_None(F_CMD_ARGS);
 void CMD_Nop(F_CMD_ARGS);
 void CMD_NoWindow(F_CMD_ARGS);
+void CMD_OpaqueFrameRate(F_CMD_ARGS);
 void CMD_OpaqueMoveSize(F_CMD_ARGS);
 void CMD_Pick(F_CMD_ARGS);
 void CMD_PipeRead(F_CMD_ARGS);
 void CMD_PixmapPath(F_CMD_ARGS);
 void CMD_PlaceAgain(F_CMD_ARGS);
+void CMD_PlacementThreads(F_CMD_ARGS);
 void CMD_PointerKey(F_CMD_ARGS);
 void CMD_PointerWindow(F_CMD_ARGS);
 void CMD_Popup(F_CMD_ARGS);
@@ -348,12 +358,18 @@ void CMD_ScanForWindow(F_CMD_ARGS);
 void CMD_Schedule(F_CMD_ARGS);
 void CMD_Scroll(F_CMD_ARGS);
 void CMD_Send_ConfigInfo(F_CMD_ARGS);
+void CMD_Send_EventStats(F_CMD_ARGS);
+void CMD_Send_ModuleStats(F_CMD_ARGS);
 void CMD_Send_Reply(F_CMD_ARGS);
 void CMD_Send_WindowList(F_CMD_ARGS);
 void CMD_SendToModule(F_CMD_ARGS);
+void CMD_set_coalesce_mask(F_CMD_ARGS);
+void CMD_set_filter(F_CMD_ARGS);
 void CMD_set_mask(F_CMD_ARGS);
 void CMD_set_nograb_mask(F_CMD_ARGS);
+void CMD_set_ring(F_CMD_ARGS);
 void CMD_set_sync_mask(F_CMD_ARGS);
+void CMD_set_sync_timeout(F_CMD_ARGS);
 void CMD_SetAnimation(F_CMD_ARGS);
 void CMD_SetEnv(F_CMD_ARGS);
 void CMD_Silent(F_CMD_ARGS);
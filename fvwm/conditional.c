@@ -390,6 +390,7 @@ void FreeConditionMask(WindowConditionMask *mask)
 		for (p=pp->namelist; p; )
 		{
 			p2=p->next;
+			wild_free(p->pattern);
 			if(!p2)
 			{
 				free(p->name);
@@ -706,11 +707,13 @@ void CreateConditionMask(char *flags, WindowConditionMask *mask)
 			}
 			mask->my_flags.do_check_cond_desk = on;
 		}
-		else if (StrEquals(cond, "Screen"))
+		else if (
+			StrEquals(cond, "Screen") || StrEquals(cond, "Monitor"))
 		{
-			char	*scr_name = NULL;
-			if (sscanf(tmp, "%s", scr_name)) {
-				tmp = SkipNTokens(tmp, 1);
+			char	*scr_name;
+
+			scr_name = PeekToken(tmp, &tmp);
+			if (scr_name != NULL) {
 				mask->screen = monitor_by_name(scr_name);
 			}
 			mask->my_flags.do_check_screen = 1;
@@ -745,6 +748,11 @@ void CreateConditionMask(char *flags, WindowConditionMask *mask)
 				}
 				*condp++='\0';
 			}
+			/* the names are matched against every window */
+			for (p = pp->namelist; p; p = p->next)
+			{
+				p->pattern = wild_compile(p->name);
+			}
 		}
 
 		if (tmp && *tmp)
@@ -788,7 +796,6 @@ Bool MatchesConditionMask(FvwmWindow *fw, WindowConditionMask *mask)
 	struct name_condition *pp;
 	struct namelist *p;
 	struct monitor	*m = fw->m;
-	char *name;
 
 	/* match FixedSize conditional */
 	/* special treatment for FixedSize, because more than just
@@ -975,14 +982,14 @@ Bool MatchesConditionMask(FvwmWindow *fw, WindowConditionMask *mask)
 		does_match = 0;
 		for (p = pp->namelist; p; p = p->next)
 		{
-			name=p->name;
-			does_match |= matchWildcards(name, fw->name.name);
-			does_match |= matchWildcards(name, fw->icon_name.name);
+			does_match |= wild_match(p->pattern, fw->name.name);
+			does_match |= wild_match(
+				p->pattern, fw->icon_name.name);
 			if(fw->class.res_class)
-				does_match |= matchWildcards(name,
+				does_match |= wild_match(p->pattern,
 					fw->class.res_class);
 			if(fw->class.res_name)
-				does_match |= matchWildcards(name,
+				does_match |= wild_match(p->pattern,
 					fw->class.res_name);
 		}
 		if(( pp->invert &&  does_match) ||
@@ -1094,17 +1101,9 @@ Bool MatchesConditionMask(FvwmWindow *fw, WindowConditionMask *mask)
 			return False;
 		}
 	}
-	if (mask->my_flags.do_check_cond_desk)
+	if (mask->my_flags.do_check_cond_desk && fw->Desk != mask->desk)
 	{
-		if (fw->Desk == mask->desk)
-			return True;
-		else
-			return False;
-
-		if (fw->Desk != mask->desk)
-			return True;
-		else
-			return False;
+		return False;
 	}
 	if (mask->my_flags.do_check_screen)
 	{
@@ -23,6 +23,7 @@
 
 #include "libs/fvwmlib.h"
 #include "libs/FShape.h"
+#include "libs/FProperty.h"
 #include "libs/Parse.h"
 #include "libs/lang-strings.h"
 #include "fvwm.h"
@@ -122,7 +123,7 @@ void GetMwmHints(FvwmWindow *t)
 		XFree((char *)t->mwm_hints);
 		t->mwm_hints = NULL;
 	}
-	if (XGetWindowProperty(
+	if (FGetWindowProperty(
 		    dpy, FW_W(t), _XA_MwmAtom, 0L, 32L, False,
 		    _XA_MwmAtom, &actual_type, &actual_format, &nitems,
 		    &bytesafter,(unsigned char **)&t->mwm_hints)==Success)
@@ -176,7 +177,7 @@ void GetOlHints(FvwmWindow *t)
 
 	t->ol_hints = OL_DECOR_ALL;
 
-	if (XGetWindowProperty(
+	if (FGetWindowProperty(
 		    dpy, FW_W(t), _XA_OL_WIN_ATTR, 0L, 32L, False,
 		    _XA_OL_WIN_ATTR, &actual_type, &actual_format,
 		    &nitems, &bytesafter, (unsigned char **)&hints) == Success)
@@ -236,7 +237,7 @@ void GetOlHints(FvwmWindow *t)
 		}
 	}
 
-	if (XGetWindowProperty(
+	if (FGetWindowProperty(
 		    dpy, FW_W(t), _XA_OL_DECOR_ADD, 0L, 32L, False,
 		    XA_ATOM, &actual_type, &actual_format, &nitems,
 		    &bytesafter,(unsigned char **)&hints)==Success)
@@ -267,7 +268,7 @@ void GetOlHints(FvwmWindow *t)
 		}
 	}
 
-	if (XGetWindowProperty(
+	if (FGetWindowProperty(
 		    dpy, FW_W(t), _XA_OL_DECOR_DEL, 0L, 32L, False,
 		    XA_ATOM, &actual_type, &actual_format, &nitems,
 		    &bytesafter,(unsigned char **)&hints)==Success)
@@ -46,6 +46,12 @@ void HandlePropertyNotify(const evh_args_t *ea);
 void HandleKeyPress(const evh_args_t *ea);
 void HandleKeyRelease(const evh_args_t *ea);
 void HandleVisibilityNotify(const evh_args_t *ea);
+void HandleColormapNotify(const evh_args_t *ea);
+void HandleSelectionClear(const evh_args_t *ea);
+void HandleSelectionRequest(const evh_args_t *ea);
+void HandleReparentNotify(const evh_args_t *ea);
+void HandleMappingNotify(const evh_args_t *ea);
+void HandleShapeNotify(const evh_args_t *ea);
 STROKE_CODE(void HandleButtonRelease(const evh_args_t *ea));
 STROKE_CODE(void HandleMotionNotify(const evh_args_t *ea));
 
@@ -52,6 +52,7 @@
 
 #include <stdio.h>
 #include <unistd.h>
+#include <time.h>
 #include <assert.h>
 #include <X11/Xatom.h>
 
@@ -78,6 +79,7 @@
 #include "eventhandler.h"
 #include "eventmask.h"
 #include "libs/fvwmsignal.h"
+#include "libs/fpoll.h"
 #include "module_list.h"
 #include "module_interface.h"
 #include "session.h"
@@ -98,6 +100,7 @@
 #include "menus.h"
 #include "colormaps.h"
 #include "colorset.h"
+#include "geom_index.h"
 #ifdef HAVE_STROKE
 #include "stroke.h"
 #endif /* HAVE_STROKE */
@@ -114,6 +117,13 @@
 #define DEBUG_GLOBALLY_ACTIVE 1
 
 #define MAX_NUM_WEED_EVENT_TYPES 40
+#define MAX_POLL_EVENTS 64
+
+/* event types are seven bits, the eighth bit is the send_event flag */
+#define EVENT_STATS_NUM_TYPES 128
+/* bucket i counts handler calls that took less than 2^i microseconds, the
+ * last one everything that took longer */
+#define EVENT_STATS_NUM_BUCKETS 24
 
 /* ---------------------------- local macros ------------------------------- */
 
@@ -159,6 +169,15 @@ typedef struct
 	int event_types[MAX_NUM_WEED_EVENT_TYPES];
 } _weed_event_type_arg;
 
+typedef struct
+{
+	PFEH handler;
+	unsigned long count;
+	unsigned long total_usec;
+	unsigned long max_usec;
+	unsigned long buckets[EVENT_STATS_NUM_BUCKETS];
+} event_stats_t;
+
 typedef struct
 {
 	long event_mask;
@@ -180,6 +199,58 @@ static const FvwmWindow *xcrossing_last_grab_window = NULL;
 STROKE_CODE(static int send_motion);
 STROKE_CODE(static char sequence[STROKE_MAX_SEQUENCE + 1]);
 static event_group_t *base_event_group = NULL;
+/* allocated when the statistics are switched on for the first time */
+static event_stats_t *event_stats = NULL;
+static Bool is_event_stats_enabled = False;
+static const char *event_names[LASTEvent] =
+{
+	NULL, NULL, "KeyPress", "KeyRelease", "ButtonPress",
+	"ButtonRelease", "MotionNotify", "EnterNotify", "LeaveNotify",
+	"FocusIn", "FocusOut", "KeymapNotify", "Expose", "GraphicsExpose",
+	"NoExpose", "VisibilityNotify", "CreateNotify", "DestroyNotify",
+	"UnmapNotify", "MapNotify", "MapRequest", "ReparentNotify",
+	"ConfigureNotify", "ConfigureRequest", "GravityNotify",
+	"ResizeRequest", "CirculateNotify", "CirculateRequest",
+	"PropertyNotify", "SelectionClear", "SelectionRequest",
+	"SelectionNotify", "ColormapNotify", "ClientMessage",
+	"MappingNotify", "GenericEvent"
+};
+static const struct
+{
+	PFEH handler;
+	const char *name;
+} event_handler_names[] =
+{
+	{ HandleButtonPress, "HandleButtonPress" },
+#ifdef HAVE_STROKE
+	{ HandleButtonRelease, "HandleButtonRelease" },
+#endif /* HAVE_STROKE */
+	{ HandleClientMessage, "HandleClientMessage" },
+	{ HandleColormapNotify, "HandleColormapNotify" },
+	{ HandleConfigureRequest, "HandleConfigureRequest" },
+	{ HandleDestroyNotify, "HandleDestroyNotify" },
+	{ HandleEnterNotify, "HandleEnterNotify" },
+	{ HandleExpose, "HandleExpose" },
+	{ HandleFocusIn, "HandleFocusIn" },
+	{ HandleFocusOut, "HandleFocusOut" },
+	{ HandleKeyPress, "HandleKeyPress" },
+	{ HandleKeyRelease, "HandleKeyRelease" },
+	{ HandleLeaveNotify, "HandleLeaveNotify" },
+	{ HandleMapNotify, "HandleMapNotify" },
+	{ HandleMappingNotify, "HandleMappingNotify" },
+	{ HandleMapRequest, "HandleMapRequest" },
+#ifdef HAVE_STROKE
+	{ HandleMotionNotify, "HandleMotionNotify" },
+#endif /* HAVE_STROKE */
+	{ HandlePropertyNotify, "HandlePropertyNotify" },
+	{ HandleReparentNotify, "HandleReparentNotify" },
+	{ HandleSelectionClear, "HandleSelectionClear" },
+	{ HandleSelectionRequest, "HandleSelectionRequest" },
+	{ HandleShapeNotify, "HandleShapeNotify" },
+	{ HandleUnmapNotify, "HandleUnmapNotify" },
+	{ HandleVisibilityNotify, "HandleVisibilityNotify" },
+	{ NULL, NULL }
+};
 
 /* ---------------------------- exported variables (globals) --------------- */
 
@@ -473,9 +544,7 @@ static inline void _handle_cr_restack(
 
 	if (cre->value_mask & CWSibling)
 	{
-		if (XFindContext(
-			    dpy, cre->above, FvwmContext,
-			    (caddr_t *)&fw2) == XCNOENT)
+		if (!wintable_find(FvwmWindowTable, cre->above, (void **)&fw2))
 		{
 			fw2 = NULL;
 		}
@@ -1787,6 +1856,126 @@ static void __refocus_stolen_focus_win(const evh_args_t *ea)
 	return;
 }
 
+static void event_stats_record(
+	int type, PFEH handler, const struct timespec *start)
+{
+	struct timespec end;
+	event_stats_t *es;
+	unsigned long usec;
+	int b;
+
+	/* a monotonic clock, so setting the time does not show up here */
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	usec = (end.tv_sec - start->tv_sec) * 1000000 +
+		(end.tv_nsec - start->tv_nsec) / 1000;
+	es = &event_stats[type & (EVENT_STATS_NUM_TYPES - 1)];
+	es->handler = handler;
+	es->count++;
+	es->total_usec += usec;
+	if (usec > es->max_usec)
+	{
+		es->max_usec = usec;
+	}
+	for (b = 0; b < EVENT_STATS_NUM_BUCKETS - 1 && (usec >> b) != 0; b++)
+	{
+		/* nothing */
+	}
+	es->buckets[b]++;
+
+	return;
+}
+
+static const char *event_stats_type_name(int type, char *buf)
+{
+	if (type < LASTEvent && event_names[type] != NULL)
+	{
+		return event_names[type];
+	}
+	if (FShapesSupported && type == FShapeEventBase + FShapeNotify)
+	{
+		return "ShapeNotify";
+	}
+	sprintf(buf, "Event%d", type);
+
+	return buf;
+}
+
+static const char *event_stats_handler_name(PFEH handler)
+{
+	int i;
+
+	for (i = 0; event_handler_names[i].handler != NULL; i++)
+	{
+		if (event_handler_names[i].handler == handler)
+		{
+			return event_handler_names[i].name;
+		}
+	}
+
+	return "?";
+}
+
+/* Returns the upper bound in microseconds of the bucket that contains the
+ * given fraction of the calls. */
+static unsigned long event_stats_percentile(
+	const event_stats_t *es, double fraction)
+{
+	unsigned long n;
+	unsigned long limit;
+	int b;
+
+	limit = (unsigned long)(es->count * fraction);
+	for (b = 0, n = 0; b < EVENT_STATS_NUM_BUCKETS - 1; b++)
+	{
+		n += es->buckets[b];
+		if (n > limit)
+		{
+			break;
+		}
+	}
+	if (b == EVENT_STATS_NUM_BUCKETS - 1)
+	{
+		return es->max_usec;
+	}
+
+	return 1ul << b;
+}
+
+static void event_stats_print_line(
+	const char *name, const char *handler, const event_stats_t *es,
+	int verbose)
+{
+	int b;
+
+	fprintf(stderr, "  %-18s %-24s %8lu %8lu %8lu %8lu %8lu\n", name,
+		handler, es->count, es->total_usec / es->count,
+		event_stats_percentile(es, 0.5),
+		event_stats_percentile(es, 0.99), es->max_usec);
+	if (verbose < 2)
+	{
+		return;
+	}
+	for (b = 0; b < EVENT_STATS_NUM_BUCKETS; b++)
+	{
+		if (es->buckets[b] == 0)
+		{
+			continue;
+		}
+		if (b < EVENT_STATS_NUM_BUCKETS - 1)
+		{
+			fprintf(stderr, "    < %8lu us: %lu\n", 1ul << b,
+				es->buckets[b]);
+		}
+		else
+		{
+			fprintf(stderr, "    >=%8lu us: %lu\n", 1ul << (b - 1),
+				es->buckets[b]);
+		}
+	}
+
+	return;
+}
+
 /* ---------------------------- event handlers ----------------------------- */
 
 #ifdef HAVE_XRANDR
@@ -1823,6 +2012,8 @@ void HandleRRScreenChangeNotify(void)
 
 		update_relative_geometry(t);
 		update_absolute_geometry(t);
+		/* the frame geometry has changed */
+		geom_index_update(t);
 		UPDATE_FVWM_SCREEN(t);
 
 		if (t->m_prev != NULL) {
@@ -2007,8 +2198,7 @@ void HandleConfigureRequest(const evh_args_t *ea)
 	cre = &te->xconfigurerequest;
 	/* te->xany.window is te->.xconfigurerequest.parent, so the context
 	 * window may be wrong. */
-	if (XFindContext(dpy, cre->window, FvwmContext, (caddr_t *)&fw) ==
-	    XCNOENT)
+	if (!wintable_find(FvwmWindowTable, cre->window, (void **)&fw))
 	{
 		fw = NULL;
 	}
@@ -2490,7 +2680,7 @@ void HandleFocusIn(const evh_args_t *ea)
 		return;
 	}
 	/**/
-	if (XFindContext(dpy, w, FvwmContext, (caddr_t *) &fw) == XCNOENT)
+	if (!wintable_find(FvwmWindowTable, w, (void **)&fw))
 	{
 		fw = NULL;
 	}
@@ -3005,6 +3195,7 @@ void HandleMapNotify(const evh_args_t *ea)
 	SET_MAPPED(fw, 1);
 	SET_ICONIFIED(fw, 0);
 	SET_ICON_UNMAPPED(fw, 0);
+	geom_index_update(fw);
 	if (DO_ICONIFY_AFTER_MAP(fw))
 	{
 		initial_window_options_t win_opts;
@@ -3067,8 +3258,7 @@ void HandleMapRequestKeepRaised(
 	ew = ea->exc->w.w;
 	if (ReuseWin == NULL)
 	{
-		if (XFindContext(dpy, ew, FvwmContext, (caddr_t *)&fw) ==
-		    XCNOENT)
+		if (!wintable_find(FvwmWindowTable, ew, (void **)&fw))
 		{
 			fw = NULL;
 		}
@@ -3880,13 +4070,12 @@ void HandleUnmapNotify(const evh_args_t *ea)
 	 * to WithdrawnState should send a synthetic UnmapNotify with the
 	 * event field set to (pseudo-)root, in case the window is already
 	 * unmapped (which is the case for fvwm for IconicState).
-	 * Unfortunately, we looked for the FvwmContext using that field, so
+	 * Unfortunately, we looked up the fvwm window using that field, so
 	 * try the window field also. */
 	if (!fw)
 	{
-		if (XFindContext(
-			    dpy, te->xunmap.window, FvwmContext,
-			    (caddr_t *)&fw) == XCNOENT)
+		if (!wintable_find(
+			    FvwmWindowTable, te->xunmap.window, (void **)&fw))
 		{
 			return;
 		}
@@ -4239,7 +4428,7 @@ void dispatch_event(XEvent *e)
 		}
 	}
 	if (w == Scr.Root ||
-	    XFindContext(dpy, w, FvwmContext, (caddr_t *)&fw) == XCNOENT)
+	    !wintable_find(FvwmWindowTable, w, (void **)&fw))
 	{
 		fw = NULL;
 	}
@@ -4266,6 +4455,7 @@ void dispatch_event(XEvent *e)
 		evh_args_t ea;
 		exec_context_changes_t ecc;
 		Window dummyw;
+		PFEH handler;
 
 		ecc.type = EXCT_EVENT;
 		ecc.x.etrigger = e;
@@ -4275,7 +4465,19 @@ void dispatch_event(XEvent *e)
 		ea.exc = exc_create_context(
 			&ecc, ECC_TYPE | ECC_ETRIGGER | ECC_FW | ECC_W |
 			ECC_WCONTEXT);
-		(*event_group->jump_table[e->type - event_group->base])(&ea);
+		handler = event_group->jump_table[e->type - event_group->base];
+		if (is_event_stats_enabled)
+		{
+			struct timespec start;
+
+			clock_gettime(CLOCK_MONOTONIC, &start);
+			(*handler)(&ea);
+			event_stats_record(e->type, handler, &start);
+		}
+		else
+		{
+			(*handler)(&ea);
+		}
 		exc_destroy_context(ea.exc);
 	}
 
@@ -4290,6 +4492,155 @@ void dispatch_event(XEvent *e)
 	return;
 }
 
+void event_stats_enable(Bool on)
+{
+	if (on && event_stats == NULL)
+	{
+		event_stats = fxcalloc(
+			EVENT_STATS_NUM_TYPES, sizeof(event_stats_t));
+	}
+	is_event_stats_enabled = on;
+
+	return;
+}
+
+void event_stats_reset(void)
+{
+	if (event_stats != NULL)
+	{
+		memset(event_stats, 0,
+		       EVENT_STATS_NUM_TYPES * sizeof(event_stats_t));
+	}
+
+	return;
+}
+
+void print_event_stats(int verbose)
+{
+	char buf[16];
+	int i;
+	int j;
+
+	fflush(stderr);
+	fprintf(stderr, "Event statistics are %s\n",
+		(is_event_stats_enabled) ? "on" : "off");
+	if (event_stats == NULL)
+	{
+		fflush(stderr);
+		return;
+	}
+	fprintf(stderr, "  %-18s %-24s %8s %8s %8s %8s %8s\n", "event",
+		"handler", "count", "avg us", "p50 us", "p99 us", "max us");
+	for (i = 0; i < EVENT_STATS_NUM_TYPES; i++)
+	{
+		if (event_stats[i].count == 0)
+		{
+			continue;
+		}
+		event_stats_print_line(
+			event_stats_type_name(i, buf),
+			event_stats_handler_name(event_stats[i].handler),
+			&event_stats[i], verbose);
+	}
+	if (verbose > 0)
+	{
+		fprintf(stderr, "Per handler:\n");
+		for (i = 0; i < EVENT_STATS_NUM_TYPES; i++)
+		{
+			event_stats_t sum;
+			int b;
+
+			if (event_stats[i].count == 0)
+			{
+				continue;
+			}
+			for (j = 0; j < i; j++)
+			{
+				if (
+					event_stats[j].count != 0 &&
+					event_stats[j].handler ==
+					event_stats[i].handler)
+				{
+					break;
+				}
+			}
+			if (j < i)
+			{
+				/* already printed */
+				continue;
+			}
+			memset(&sum, 0, sizeof(sum));
+			for (j = i; j < EVENT_STATS_NUM_TYPES; j++)
+			{
+				const event_stats_t *es = &event_stats[j];
+
+				if (
+					es->count == 0 ||
+					es->handler != event_stats[i].handler)
+				{
+					continue;
+				}
+				sum.count += es->count;
+				sum.total_usec += es->total_usec;
+				if (es->max_usec > sum.max_usec)
+				{
+					sum.max_usec = es->max_usec;
+				}
+				for (b = 0; b < EVENT_STATS_NUM_BUCKETS; b++)
+				{
+					sum.buckets[b] += es->buckets[b];
+				}
+			}
+			event_stats_print_line(
+				event_stats_handler_name(
+					event_stats[i].handler), "", &sum,
+				verbose);
+		}
+	}
+	fflush(stderr);
+
+	return;
+}
+
+/* Sends one MX_REPLY message per event type to the module:
+ *
+ *   EventStats <event> <handler> <count> <total us> <max us> <buckets...>
+ *
+ * followed by "EventStats End".  The first data word of each message is the
+ * event type. */
+void send_event_stats(fmodule *module)
+{
+	char buf[16];
+	char line[128 + 12 * EVENT_STATS_NUM_BUCKETS];
+	int i;
+
+	for (i = 0; event_stats != NULL && i < EVENT_STATS_NUM_TYPES; i++)
+	{
+		const event_stats_t *es = &event_stats[i];
+		int len;
+		int b;
+
+		if (es->count == 0)
+		{
+			continue;
+		}
+		len = sprintf(
+			line, "EventStats %s %s %lu %lu %lu",
+			event_stats_type_name(i, buf),
+			event_stats_handler_name(es->handler), es->count,
+			es->total_usec, es->max_usec);
+		for (b = 0; b < EVENT_STATS_NUM_BUCKETS; b++)
+		{
+			len += sprintf(line + len, " %lu", es->buckets[b]);
+		}
+		SendName(module, MX_REPLY, i, 0, 0, line);
+	}
+	SendName(module, MX_REPLY, 0, 0, 0, "EventStats End");
+	FlushMessageQueue(module);
+
+	return;
+}
+
 /* ewmh configure request */
 void events_handle_configure_request(
 	XEvent *cre, FvwmWindow *fw, Bool force, int force_gravity)
@@ -4346,13 +4697,15 @@ void HandleEvents(void)
  */
 int My_XNextEvent(Display *dpy, XEvent *event)
 {
-	fd_set in_fdset, out_fdset;
+	fpoll_event_t events[MAX_POLL_EVENTS];
 	int num_fd;
+	int i;
+	Bool has_timed_out;
 	fmodule_list_itr moditr;
 	fmodule *module;
 	fmodule_input *input;
-	static struct timeval timeout;
-	static struct timeval *timeoutP = &timeout;
+	static int timeout_ms = 42000;
+	static int polled_sm_fd = -1;
 
 	DBUG("My_XNextEvent", "Routine Entered");
 
@@ -4390,7 +4743,7 @@ int My_XNextEvent(Display *dpy, XEvent *event)
 				"My_XNextEvent",
 				"Starting up after command lines modules");
 			/* set an infinite timeout to stop ticking */
-			timeoutP = NULL;
+			timeout_ms = -1;
 			/* This may cause X requests to be sent */
 			StartupStuff();
 
@@ -4398,6 +4751,20 @@ int My_XNextEvent(Display *dpy, XEvent *event)
 		}
 	}
 
+	/* The X connection and the module pipes stay registered with the
+	 * event loop; only the session manager connection comes and goes
+	 * (nothing is done here if fvwm was compiled without session
+	 * support). */
+	if (sm_fd != polled_sm_fd)
+	{
+		fpoll_remove(polled_sm_fd);
+		if (sm_fd >= 0)
+		{
+			fpoll_add(sm_fd, FPOLL_IN, NULL);
+		}
+		polled_sm_fd = sm_fd;
+	}
+
 	/* Some signals can interrupt us while we wait for any action
 	 * on our descriptors. While some of these signals may be asking
 	 * fvwm to die, some might be harmless. Harmless interruptions
@@ -4405,11 +4772,7 @@ int My_XNextEvent(Display *dpy, XEvent *event)
 	do
 	{
 		int ms;
-		Bool is_waiting_for_scheduled_command = False;
-		static struct timeval *old_timeoutP = NULL;
 
-		/* The timeouts become undefined whenever the select returns,
-		 * and so we have to reinitialise them */
 		ms = squeue_get_next_ms();
 		if (ms == 0)
 		{
@@ -4424,51 +4787,11 @@ int My_XNextEvent(Display *dpy, XEvent *event)
 				ms = 1;
 			}
 		}
-		if (ms < 0)
-		{
-			timeout.tv_sec = 42;
-			timeout.tv_usec = 0;
-		}
-		else
-		{
-			/* scheduled commands are pending - don't wait too
-			 * long */
-			timeout.tv_sec = ms / 1000;
-			timeout.tv_usec = 1000 * (ms % 1000);
-			old_timeoutP = timeoutP;
-			timeoutP = &timeout;
-			is_waiting_for_scheduled_command = True;
-		}
-
-		FD_ZERO(&in_fdset);
-		FD_ZERO(&out_fdset);
-		FD_SET(x_fd, &in_fdset);
-
-		/* nothing is done here if fvwm was compiled without session
-		 * support */
-		if (sm_fd >= 0)
-		{
-			FD_SET(sm_fd, &in_fdset);
-		}
-
-		module_list_itr_init(&moditr);
-		while ( (module = module_list_itr_next(&moditr)) != NULL)
-		{
-			FD_SET(MOD_READFD(module), &in_fdset);
-
-			if (!FQUEUE_IS_EMPTY(&MOD_PIPEQUEUE(module)))
-			{
-				FD_SET(MOD_WRITEFD(module), &out_fdset);
-			}
-		}
+		/* scheduled commands are pending - don't wait too long */
+		fpoll_set_timer(ms);
 
 		DBUG("My_XNextEvent", "waiting for module input/output");
-		num_fd = fvwmSelect(
-			fvwmlib_max_fd, &in_fdset, &out_fdset, 0, timeoutP);
-		if (is_waiting_for_scheduled_command)
-		{
-			timeoutP = old_timeoutP;
-		}
+		num_fd = fpoll_wait(events, MAX_POLL_EVENTS, timeout_ms);
 
 		/* Express route out of fvwm ... */
 		if (isTerminated)
@@ -4477,28 +4800,39 @@ int My_XNextEvent(Display *dpy, XEvent *event)
 		}
 	} while (num_fd < 0);
 
-	if (num_fd > 0)
+	has_timed_out = (num_fd == 0);
+	for (i = 0; i < num_fd; i++)
 	{
+		if (events[i].events & FPOLL_TIMER)
+		{
+			has_timed_out = True;
+		}
+		if (events[i].fd < 0 || events[i].fd == polled_sm_fd)
+		{
+			continue;
+		}
+		/* NULL if the module has been killed in the mean time */
+		module = fpoll_get_data(events[i].fd);
+		if (module == NULL)
+		{
+			continue;
+		}
 		/* Check for module input. */
-		module_list_itr_init(&moditr);
-		while ( (module = module_list_itr_next(&moditr)) != NULL)
+		if (events[i].fd == MOD_READFD(module))
 		{
-			if (FD_ISSET(MOD_READFD(module), &in_fdset))
-			{
-				input = module_receive(module);
-				/* enqueue the received command */
-				module_input_enqueue(input);
-			}
-			if (
-				MOD_WRITEFD(module) >= 0 &&
-				FD_ISSET(MOD_WRITEFD(module), &out_fdset))
-			{
-				DBUG("My_XNextEvent",
-				     "calling FlushMessageQueue");
-				FlushMessageQueue(module);
-			}
+			input = module_receive(module);
+			/* enqueue the received command */
+			module_input_enqueue(input);
 		}
-
+		else
+		{
+			/* the write pipe, or the ring that has room again */
+			DBUG("My_XNextEvent", "calling FlushMessageQueue");
+			FlushMessageQueue(module);
+		}
+	}
+	if (num_fd > 0)
+	{
 		/* execute any commands queued up */
 		DBUG("My_XNextEvent", "executing module comand queue");
 		ExecuteCommandQueue();
@@ -4506,25 +4840,25 @@ int My_XNextEvent(Display *dpy, XEvent *event)
 		/* cleanup dead modules */
 		module_cleanup();
 
-		/* nothing is done here if fvwm was compiled without session
-		 * support */
-		if ((sm_fd >= 0) && (FD_ISSET(sm_fd, &in_fdset)))
+		for (i = 0; i < num_fd; i++)
 		{
-			ProcessICEMsgs();
+			if (events[i].fd >= 0 && events[i].fd == polled_sm_fd)
+			{
+				ProcessICEMsgs();
+			}
 		}
-
 	}
-	else
+	if (has_timed_out)
 	{
 		/* select has timed out, things must have calmed down so let's
 		 * decorate */
-		if (fFvwmInStartup)
+		if (fFvwmInStartup && num_fd == 0)
 		{
 			fvwm_msg(ERR, "My_XNextEvent",
 				 "Some command line modules have not quit, "
 				 "Starting up after timeout.\n");
 			StartupStuff();
-			timeoutP = NULL; /* set an infinite timeout to stop
+			timeout_ms = -1; /* set an infinite timeout to stop
 					  * ticking */
 			reset_style_changes();
 			Scr.flags.do_need_window_update = 0;
@@ -4579,7 +4913,7 @@ int GetContext(FvwmWindow **ret_fw, FvwmWindow *t, const XEvent *e, Window *w)
 			win = subw;
 			XTranslateCoordinates(
 				dpy, Scr.Root, subw, x, y, &x, &y, &subw);
-			XFindContext(dpy, win, FvwmContext, (caddr_t *) &t);
+			wintable_find(FvwmWindowTable, win, (void **)&t);
 		}
 		is_key_event = True;
 		/* fall through */
@@ -4608,7 +4942,7 @@ int GetContext(FvwmWindow **ret_fw, FvwmWindow *t, const XEvent *e, Window *w)
 		}
 		break;
 	default:
-		XFindContext(dpy, win, FvwmContext, (caddr_t *)&t);
+		wintable_find(FvwmWindowTable, win, (void **)&t);
 		break;
 	}
 	if (ret_fw != NULL)
@@ -4696,7 +5030,7 @@ void CoerceEnterNotifyOnCurrentWindow(void)
 	e.xcrossing.mode = NotifyNormal;
 	e.xcrossing.detail = NotifyAncestor;
 	e.xcrossing.same_screen = True;
-	if (XFindContext(dpy, child, FvwmContext, (caddr_t *)&fw) == XCNOENT)
+	if (!wintable_find(FvwmWindowTable, child, (void **)&fw))
 	{
 		fw = NULL;
 	}
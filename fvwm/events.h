@@ -22,6 +22,8 @@ typedef struct
 
 /* ---------------------------- forward declarations ----------------------- */
 
+struct fmodule;
+
 /* ---------------------------- exported variables (globals) --------------- */
 
 /* ---------------------------- interface functions ------------------------ */
@@ -47,5 +49,10 @@ Bool is_resizing_event_pending(FvwmWindow *fw);
 void events_handle_configure_request(
 	XEvent *e, FvwmWindow *fw, Bool force_use_grav, int force_gravity);
 Bool test_typed_window_event(Display *display, XEvent *event, char *arg);
+/* per event type statistics about the time spent in the event handlers */
+void event_stats_enable(Bool on);
+void event_stats_reset(void);
+void print_event_stats(int verbose);
+void send_event_stats(struct fmodule *module);
 
 #endif /* EVENTS_H */
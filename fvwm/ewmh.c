@@ -56,6 +56,7 @@
 #include <X11/Xatom.h>
 
 #include "libs/fvwmlib.h"
+#include "libs/FProperty.h"
 #include "fvwm.h"
 #include "execcontext.h"
 #include "functions.h"
@@ -333,6 +334,57 @@ ewmh_atom *ewmh_GetEwmhAtomByAtom(Atom atom, ewmh_atom_list_name list_name)
 	return NULL;
 }
 
+/* Collects the atoms of the properties that are read while a new window is
+ * set up, for FPropertyPrefetch.  _NET_WM_ICON is left out as it can be huge
+ * and is only read after the server grab. */
+int EWMH_GetPrefetchAtoms(Atom *ret_atoms, int max_atoms)
+{
+	static const ewmh_atom_list_name lists[] =
+	{
+		EWMH_ATOM_LIST_FIXED_PROPERTY,
+		EWMH_ATOM_LIST_PROPERTY_NOTIFY,
+		EWMH_ATOM_LIST_END
+	};
+	ewmh_atom *a;
+	int n = 0;
+	int i;
+
+	if ((a = get_ewmh_atom_by_name(
+		     "_NET_WM_DESKTOP", EWMH_ATOM_LIST_CLIENT_WIN)) != NULL &&
+	    n < max_atoms)
+	{
+		ret_atoms[n++] = a->atom;
+	}
+	if ((a = get_ewmh_atom_by_name(
+		     "_NET_WM_STATE", EWMH_ATOM_LIST_CLIENT_WIN)) != NULL &&
+	    n < max_atoms)
+	{
+		ret_atoms[n++] = a->atom;
+	}
+	for (i = 0; lists[i] != EWMH_ATOM_LIST_END; i++)
+	{
+		int j;
+
+		for (j = 0; atom_list[j].name != EWMH_ATOM_LIST_END; j++)
+		{
+			if (atom_list[j].name == lists[i])
+			{
+				break;
+			}
+		}
+		for (a = atom_list[j].list; a != NULL && a->name != NULL; a++)
+		{
+			if (n < max_atoms && a->atom != None &&
+			    strcmp(a->name, "_NET_WM_ICON") != 0)
+			{
+				ret_atoms[n++] = a->atom;
+			}
+		}
+	}
+
+	return n;
+}
+
 static int atom_size(int format)
 {
 	if (format == 32)
@@ -380,6 +432,7 @@ void ewmh_ChangeProperty(
 		XChangeProperty(
 			dpy, w, a->atom, a->atom_type , format,
 			PropModeReplace, data, length);
+		FPropertyInvalidate(w, a->atom);
 
 		if (free_data)
 		{
@@ -398,6 +451,7 @@ void ewmh_DeleteProperty(
 	if ((a = get_ewmh_atom_by_name(atom_name, list)) != NULL)
 	{
 		XDeleteProperty(dpy, w, a->atom);
+		FPropertyInvalidate(w, a->atom);
 	}
 
 	return;
@@ -416,7 +470,7 @@ void *atom_get(Window win, Atom to_get, Atom type, int *size)
 
 	retval = NULL;
 	length = 0x7fffffff;
-	ok = XGetWindowProperty(
+	ok = FGetWindowProperty(
 		dpy, win, to_get, 0L, length, False, type, &type_ret,
 		&format_ret, &num_ret, &bytes_after, &retval);
 
@@ -1137,13 +1191,12 @@ float get_intersection(
 
 static
 float ewmh_GetStrutIntersection(
-	int x11, int y11, int x12, int y12,
+	struct monitor *m, int x11, int y11, int x12, int y12,
 	int left, int right, int top, int bottom,
 	Bool use_percent)
 {
 	float ret = 0;
 	int x21, y21, x22, y22;
-	struct monitor	*m = monitor_get_current();
 
 	/* FIXME: needs broadcast if global monitor in use. */
 
@@ -1180,19 +1233,20 @@ float ewmh_GetStrutIntersection(
 }
 
 float EWMH_GetBaseStrutIntersection(
-	int x11, int y11, int x12, int y12, Bool use_percent)
+	struct monitor *m, int x11, int y11, int x12, int y12,
+	Bool use_percent)
 {
 	return ewmh_GetStrutIntersection(
-		x11, y11, x12, y12, ewmhc.BaseStrut.left,
+		m, x11, y11, x12, y12, ewmhc.BaseStrut.left,
 		ewmhc.BaseStrut.right, ewmhc.BaseStrut.top,
 		ewmhc.BaseStrut.bottom, use_percent);
 }
 
 float EWMH_GetStrutIntersection(
-	int x11, int y11, int x12, int y12, Bool use_percent)
+	struct monitor *m, int x11, int y11, int x12, int y12,
+	Bool use_percent)
 {
 	int left, right, top, bottom;
-	struct monitor	*m = monitor_get_current();
 
 	/* FIXME: needs broadcast if global monitor in use. */
 
@@ -1206,7 +1260,7 @@ float EWMH_GetStrutIntersection(
 		 + m->Desktops->ewmh_working_area.height);
 
 	return ewmh_GetStrutIntersection(
-		x11, y11, x12, y12, left, right, top, bottom, use_percent);
+		m, x11, y11, x12, y12, left, right, top, bottom, use_percent);
 }
 
 /*
@@ -39,16 +39,20 @@ void EWMH_SetClientListStacking(struct monitor *);
 void EWMH_UpdateWorkArea(struct monitor *);
 void EWMH_GetWorkAreaIntersection(
 	FvwmWindow *fw, int *x, int *y, int *w, int *h, int type);
+/* the intersection with the struts on the monitor m */
 float EWMH_GetBaseStrutIntersection(
-	int x11, int y11, int x12, int y12, Bool use_percent);
+	struct monitor *m, int x11, int y11, int x12, int y12,
+	Bool use_percent);
 float EWMH_GetStrutIntersection(
-	int x11, int y11, int x12, int y12, Bool use_percent);
+	struct monitor *m, int x11, int y11, int x12, int y12,
+	Bool use_percent);
 void EWMH_SetFrameStrut(FvwmWindow *fw);
 void EWMH_SetAllowedActions(FvwmWindow *fw);
 
 void EWMH_GetIconGeometry(FvwmWindow *fw, rectangle *icon_rect);
 
 void EWMH_GetStyle(FvwmWindow *fw, window_style *style);
+int EWMH_GetPrefetchAtoms(Atom *ret_atoms, int max_atoms);
 void EWMH_WindowInit(FvwmWindow *fw);
 void EWMH_RestoreInitialStates(FvwmWindow *fw, int event_type);
 void EWMH_DestroyWindow(FvwmWindow *fw);
@@ -29,6 +29,8 @@
 #ifndef EXTERNS_H
 #define EXTERNS_H
 
+#include "libs/wintable.h"
+
 void Done(int, char *) __attribute__((__noreturn__));
 void set_init_function_name(int n, const char *name);
 const char *get_init_function_name(int n);
@@ -41,7 +43,7 @@ extern unsigned long Globalgcm;
 extern int master_pid;
 extern Display *dpy;
 extern int x_fd;
-extern XContext FvwmContext;
+extern wintable_t *FvwmWindowTable;
 extern Bool fFvwmInStartup;
 extern Bool DoingCommandLine;
 extern Bool debugging;
@@ -1072,7 +1072,7 @@ void focus_grab_buttons_on_pointer_window(void)
 		/* pointer is not on this screen */
 		return;
 	}
-	if (XFindContext(dpy, w, FvwmContext, (caddr_t *) &fw) == XCNOENT)
+	if (!wintable_find(FvwmWindowTable, w, (void **)&fw))
 	{
 		/* pointer is not over a window */
 		return;
@@ -37,6 +37,7 @@
 #include "borders.h"
 #include "frame.h"
 #include "ewmh.h"
+#include "geom_index.h"
 
 /* ---------------------------- local definitions -------------------------- */
 
@@ -430,6 +431,7 @@ static void __frame_setup_window(
 			fw, new_g.x, new_g.y, new_g.width, new_g.height, 0,
 			True);
 	}
+	geom_index_update(fw);
 	/* get things updated */
 	XFlush(dpy);
 	if (is_moved || is_resized)
@@ -1129,6 +1131,7 @@ static void frame_move_resize_step(
 	frame_mrs_resize_move_windows(fw, mra);
 	frame_mrs_hide_unhide_parent2(fw, mra);
 	fw->g.frame = mra->next_g;
+	geom_index_update(fw);
 
 	return;
 }
@@ -1924,6 +1927,7 @@ void frame_free_move_resize_args(
 	mra = (mr_args_internal *)mr_args;
 	SET_HAS_HANDLES(fw, mra->flags.had_handles);
 	fw->g.frame = mra->end_g;
+	geom_index_update(fw);
 	if (mra->flags.is_lazy_shading)
 	{
 		border_draw_decorations(
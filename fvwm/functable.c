@@ -411,6 +411,10 @@ const func_t func_table[] =
 	CMD_ENT("nowindow", CMD_NoWindow, F_NOP, 0, 0),
 	/* - Prefix that runs a command without a window context */
 
+	CMD_ENT("opaqueframerate", CMD_OpaqueFrameRate, F_OPAQUE_FRAME_RATE,
+		0, 0),
+	/* - Limit the updates per second of opaque moves and resizes */
+
 	CMD_ENT("opaquemovesize", CMD_OpaqueMoveSize, F_OPAQUE, 0, 0),
 	/* - Set maximum size window fvwm should move opaquely */
 
@@ -427,6 +431,10 @@ const func_t func_table[] =
 		FUNC_NEEDS_WINDOW, CRS_SELECT),
 	/* - Replace a window using initial window placement logic */
 
+	CMD_ENT("placementthreads", CMD_PlacementThreads,
+		F_PLACEMENT_THREADS, 0, 0),
+	/* - Set the number of threads used for window placement */
+
 	CMD_ENT("pointerkey", CMD_PointerKey, F_POINTERKEY, 0, 0),
 	/* - Bind an action to a key based on pointer not focus */
 
@@ -528,6 +536,14 @@ const func_t func_table[] =
 		FUNC_DONT_REPEAT, 0),
 	/* - Internal, used for module communication */
 
+	CMD_ENT("send_eventstats", CMD_Send_EventStats,
+		F_SEND_EVENT_STATS, FUNC_DONT_REPEAT, 0),
+	/* - Internal, used for module communication */
+
+	CMD_ENT("send_modulestats", CMD_Send_ModuleStats,
+		F_SEND_MODULE_STATS, FUNC_DONT_REPEAT, 0),
+	/* - Internal, used for module communication */
+
 	CMD_ENT("send_reply", CMD_Send_Reply, F_SEND_REPLY,
 		FUNC_DONT_REPEAT, 0),
 	/* - Internal, used for module communication */
@@ -540,6 +556,14 @@ const func_t func_table[] =
 		FUNC_DONT_REPEAT, 0),
 	/* - Send a string (action) to a module */
 
+	CMD_ENT("set_coalesce_mask", CMD_set_coalesce_mask, F_SET_COALESCE_MASK,
+		FUNC_DONT_REPEAT, 0),
+	/* - Internal, used for module communication */
+
+	CMD_ENT("set_filter", CMD_set_filter, F_SET_FILTER, FUNC_DONT_REPEAT,
+		0),
+	/* - Internal, used for module communication */
+
 	CMD_ENT("set_mask", CMD_set_mask, F_SET_MASK, FUNC_DONT_REPEAT, 0),
 	/* - Internal, used for module communication */
 
@@ -547,10 +571,17 @@ const func_t func_table[] =
 		FUNC_DONT_REPEAT, 0),
 	/* - Internal, used for module communication */
 
+	CMD_ENT("set_ring", CMD_set_ring, F_SET_RING, FUNC_DONT_REPEAT, 0),
+	/* - Internal, used for module communication */
+
 	CMD_ENT("set_sync_mask", CMD_set_sync_mask, F_SET_SYNC_MASK,
 		FUNC_DONT_REPEAT, 0),
 	/* - Internal, used for module communication */
 
+	CMD_ENT("set_sync_timeout", CMD_set_sync_timeout, F_SET_SYNC_TIMEOUT,
+		FUNC_DONT_REPEAT, 0),
+	/* - Internal, used for module communication */
+
 	CMD_ENT("setanimation", CMD_SetAnimation, F_SET_ANIMATION, 0, 0),
 	/* - Control animated moves and menus */
 
@@ -50,6 +50,9 @@
 
 /* ---------------------------- local definitions -------------------------- */
 
+/* must be a power of two */
+#define FUNCTION_HASH_MIN_BUCKETS 64
+
 /* ---------------------------- local macros ------------------------------- */
 
 /* ---------------------------- imports ------------------------------------ */
@@ -76,6 +79,7 @@ typedef struct FvwmFunction
 	FunctionItem *last_item;         /* last item in function */
 	char *name;                      /* function name */
 	int use_depth;
+	struct FvwmFunction *next_in_bucket;
 } FvwmFunction;
 
 /* Types of events for the FUNCTION builtin */
@@ -98,6 +102,26 @@ static void execute_complex_function(
 
 /* ---------------------------- local variables ---------------------------- */
 
+/* case insensitive hash table of the complex functions */
+static struct
+{
+	FvwmFunction **buckets;
+	unsigned int n_buckets;
+	unsigned int n_functions;
+} function_hash;
+
+/* Perfect hash of the builtin commands, built from func_table on first use.
+ * A key is hashed into one of the buckets first; each bucket has its own
+ * seed for a second hash that puts its keys into distinct slots. */
+static struct
+{
+	Bool is_initialised;
+	unsigned short *seeds;
+	short *slots;
+	unsigned int n_buckets;
+	unsigned int n_slots;
+} builtin_hash;
+
 /* ---------------------------- exported variables (globals) --------------- */
 
 /* ---------------------------- local functions ---------------------------- */
@@ -246,7 +270,7 @@ static Bool DeferExecution(
 		return True;
 	}
 	*ret_mask |= ECC_FW;
-	if (XFindContext(dpy, w, FvwmContext, (caddr_t *)&fw) == XCNOENT)
+	if (!wintable_find(FvwmWindowTable, w, (void **)&fw))
 	{
 		ret_ecc->w.fw = NULL;
 		ret_ecc->w.w = w;
@@ -294,53 +318,201 @@ static Bool DeferExecution(
 	return False;
 }
 
-/*
-** do binary search on func list
-*/
-static int func_comp(const void *a, const void *b)
+/* FNV-1a on the lower case characters of the string */
+static unsigned int function_name_hash(
+	unsigned int seed, const char *name, int len)
+{
+	unsigned int h = 2166136261u ^ (seed * 16777619u);
+	int i;
+
+	for (i = 0; i < len; i++)
+	{
+		h ^= (unsigned char)tolower((unsigned char)name[i]);
+		h *= 16777619u;
+	}
+
+	return h;
+}
+
+static int builtin_hash_cmp_bucket_size(const void *a, const void *b)
 {
-	return (strcmp((char *)a, ((func_t *)b)->keyword));
+	return ((const int *)b)[1] - ((const int *)a)[1];
 }
 
-static const func_t *find_builtin_function(char *func)
+static Bool builtin_hash_build(void)
 {
-	static int nfuncs = 0;
-	func_t *ret_func;
-	char *temp;
-	char *s;
+	int n_keys;
+	int *key_bucket;
+	/* pairs of bucket number and bucket size */
+	int *order;
+	int *slots;
+	unsigned int i;
+	int k;
+	int j;
+	Bool ret = True;
 
-	if (!func || func[0] == 0)
+	for (n_keys = 0; func_table[n_keys].keyword[0] != 0; n_keys++)
 	{
-		return NULL;
+		/* nothing */
+	}
+	for (
+		builtin_hash.n_slots = 1; builtin_hash.n_slots < n_keys;
+		builtin_hash.n_slots *= 2)
+	{
+		/* nothing */
+	}
+	builtin_hash.n_buckets = builtin_hash.n_slots / 2;
+	builtin_hash.seeds = fxcalloc(
+		builtin_hash.n_buckets, sizeof(unsigned short));
+	builtin_hash.slots = fxmalloc(builtin_hash.n_slots * sizeof(short));
+	key_bucket = fxmalloc(n_keys * sizeof(int));
+	order = fxcalloc(2 * builtin_hash.n_buckets, sizeof(int));
+	slots = fxmalloc(n_keys * sizeof(int));
+	for (i = 0; i < builtin_hash.n_slots; i++)
+	{
+		builtin_hash.slots[i] = -1;
+	}
+	for (i = 0; i < builtin_hash.n_buckets; i++)
+	{
+		order[2 * i] = i;
 	}
+	for (k = 0; k < n_keys; k++)
+	{
+		const char *kw = func_table[k].keyword;
 
-	/* since a lot of lines in a typical rc are probably menu/func
-	 * continues: */
-	if (func[0]=='+' || (func[0] == ' ' && func[1] == '+'))
+		key_bucket[k] = function_name_hash(0, kw, strlen(kw)) &
+			(builtin_hash.n_buckets - 1);
+		order[2 * key_bucket[k] + 1]++;
+	}
+	/* place the largest buckets first */
+	qsort(order, builtin_hash.n_buckets, 2 * sizeof(int),
+	      builtin_hash_cmp_bucket_size);
+	for (i = 0; i < builtin_hash.n_buckets && order[2 * i + 1] > 0; i++)
 	{
-		return &(func_table[0]);
+		int b = order[2 * i];
+		unsigned int seed;
+
+		for (seed = 1; seed <= 0xffff; seed++)
+		{
+			int n = 0;
+
+			for (k = 0; k < n_keys; k++)
+			{
+				const char *kw = func_table[k].keyword;
+				int slot;
+
+				if (key_bucket[k] != b)
+				{
+					continue;
+				}
+				slot = function_name_hash(seed, kw, strlen(kw)) &
+					(builtin_hash.n_slots - 1);
+				if (builtin_hash.slots[slot] >= 0)
+				{
+					break;
+				}
+				for (j = 0; j < n && slots[j] != slot; j++)
+				{
+					/* nothing */
+				}
+				if (j < n)
+				{
+					break;
+				}
+				slots[n++] = slot;
+			}
+			if (k == n_keys)
+			{
+				break;
+			}
+		}
+		if (seed > 0xffff)
+		{
+			ret = False;
+			break;
+		}
+		builtin_hash.seeds[b] = seed;
+		for (k = 0, j = 0; k < n_keys; k++)
+		{
+			if (key_bucket[k] == b)
+			{
+				builtin_hash.slots[slots[j++]] = k;
+			}
+		}
 	}
+	free(key_bucket);
+	free(order);
+	free(slots);
 
-	temp = fxstrdup(func);
-	for (s = temp; *s != 0; s++)
+	return ret;
+}
+
+/* Find the builtin command with the given name, ignoring case; the name need
+ * not be terminated. */
+static const func_t *find_builtin_function_len(const char *name, int len)
+{
+	unsigned int b;
+	int slot;
+	int i;
+
+	if (!builtin_hash.is_initialised)
 	{
-		if (isupper(*s))
+		builtin_hash.is_initialised = True;
+		if (!builtin_hash_build())
 		{
-			*s = tolower(*s);
+			fvwm_msg(ERR, "find_builtin_function_len",
+				 "Failed to build the command hash table");
+			free(builtin_hash.seeds);
+			free(builtin_hash.slots);
+			builtin_hash.seeds = NULL;
+			builtin_hash.slots = NULL;
 		}
 	}
-	if (nfuncs == 0)
+	if (builtin_hash.slots == NULL)
 	{
-		for ( ; (func_table[nfuncs]).action != NULL; nfuncs++)
+		/* should never happen */
+		for (i = 0; func_table[i].keyword[0] != 0; i++)
 		{
-			/* nothing to do here */
+			if (
+				strlen(func_table[i].keyword) == len &&
+				strncasecmp(
+					name, func_table[i].keyword, len) == 0)
+			{
+				return &func_table[i];
+			}
 		}
+
+		return NULL;
+	}
+	b = function_name_hash(0, name, len) & (builtin_hash.n_buckets - 1);
+	slot = function_name_hash(builtin_hash.seeds[b], name, len) &
+		(builtin_hash.n_slots - 1);
+	i = builtin_hash.slots[slot];
+	if (
+		i < 0 || strlen(func_table[i].keyword) != len ||
+		strncasecmp(name, func_table[i].keyword, len) != 0)
+	{
+		return NULL;
 	}
-	ret_func = (func_t *)bsearch(
-		temp, func_table, nfuncs, sizeof(func_t), func_comp);
-	free(temp);
 
-	return ret_func;
+	return &func_table[i];
+}
+
+static const func_t *find_builtin_function(char *func)
+{
+	if (!func || func[0] == 0)
+	{
+		return NULL;
+	}
+
+	/* since a lot of lines in a typical rc are probably menu/func
+	 * continues: */
+	if (func[0]=='+' || (func[0] == ' ' && func[1] == '+'))
+	{
+		return &(func_table[0]);
+	}
+
+	return find_builtin_function_len(func, strlen(func));
 }
 
 static void __execute_function(
@@ -433,9 +605,7 @@ static void __execute_function(
 		tw = NULL;
 		if (w != None)
 		{
-			if (XFindContext(
-				 dpy, w, FvwmContext, (caddr_t *)&tw) ==
-			    XCNOENT)
+			if (!wintable_find(FvwmWindowTable, w, (void **)&tw))
 			{
 				tw = NULL;
 			}
@@ -701,25 +871,108 @@ static void __execute_function(
 static FvwmFunction *find_complex_function(const char *function_name)
 {
 	FvwmFunction *func;
+	unsigned int h;
 
-	if (function_name == NULL || *function_name == 0)
+	if (
+		function_name == NULL || *function_name == 0 ||
+		function_hash.n_functions == 0)
 	{
 		return NULL;
 	}
-	func = Scr.functions;
-	while (func != NULL)
+	h = function_name_hash(0, function_name, strlen(function_name)) &
+		(function_hash.n_buckets - 1);
+	for (
+		func = function_hash.buckets[h]; func != NULL;
+		func = func->next_in_bucket)
+	{
+		if (strcasecmp(function_name, func->name) == 0)
+		{
+			return func;
+		}
+	}
+
+	return NULL;
+}
+
+static void function_hash_insert(FvwmFunction *func)
+{
+	unsigned int h;
+
+	func->next_in_bucket = NULL;
+	if (func->name == NULL)
 	{
-		if (func->name != NULL)
+		return;
+	}
+	if (function_hash.n_functions + 1 > function_hash.n_buckets)
+	{
+		FvwmFunction **old = function_hash.buckets;
+		unsigned int n_old = function_hash.n_buckets;
+		unsigned int i;
+
+		function_hash.n_buckets = (n_old == 0) ?
+			FUNCTION_HASH_MIN_BUCKETS : 2 * n_old;
+		function_hash.buckets = fxcalloc(
+			function_hash.n_buckets, sizeof(FvwmFunction *));
+		function_hash.n_functions = 0;
+		/* rehash the old entries; the order of each chain is kept,
+		 * so the newest of several functions with the same name is
+		 * still found first */
+		for (i = 0; i < n_old; i++)
 		{
-			if (strcasecmp(function_name, func->name) == 0)
+			FvwmFunction *f;
+			FvwmFunction *next;
+			FvwmFunction *rev = NULL;
+
+			for (f = old[i]; f != NULL; f = next)
 			{
-				return func;
+				next = f->next_in_bucket;
+				f->next_in_bucket = rev;
+				rev = f;
 			}
+			for (f = rev; f != NULL; f = next)
+			{
+				next = f->next_in_bucket;
+				function_hash_insert(f);
+			}
+		}
+		if (old != NULL)
+		{
+			free(old);
 		}
-		func = func->next_func;
 	}
+	h = function_name_hash(0, func->name, strlen(func->name)) &
+		(function_hash.n_buckets - 1);
+	func->next_in_bucket = function_hash.buckets[h];
+	function_hash.buckets[h] = func;
+	function_hash.n_functions++;
 
-	return NULL;
+	return;
+}
+
+static void function_hash_remove(FvwmFunction *func)
+{
+	FvwmFunction **pf;
+	unsigned int h;
+
+	if (func->name == NULL || function_hash.n_functions == 0)
+	{
+		return;
+	}
+	h = function_name_hash(0, func->name, strlen(func->name)) &
+		(function_hash.n_buckets - 1);
+	for (
+		pf = &function_hash.buckets[h]; *pf != NULL;
+		pf = &(*pf)->next_in_bucket)
+	{
+		if (*pf == func)
+		{
+			*pf = func->next_in_bucket;
+			function_hash.n_functions--;
+			break;
+		}
+	}
+
+	return;
 }
 
 /*
@@ -1221,6 +1474,7 @@ static FvwmFunction *NewFvwmFunction(const char *name)
 	tmp->name = stripcpy(name);
 	tmp->use_depth = 0;
 	Scr.functions = tmp;
+	function_hash_insert(tmp);
 
 	return tmp;
 }
@@ -1264,6 +1518,7 @@ static void DestroyFunction(FvwmFunction *func)
 	{
 		prev->next_func = func->next_func;
 	}
+	function_hash_remove(func);
 
 	free(func->name);
 
@@ -1355,12 +1610,11 @@ void execute_function_override_window(
 	return;
 }
 
-void find_func_t(char *action, short *func_t, unsigned char *flags)
+void find_func_t(char *action, short *ret_func_t, unsigned char *flags)
 {
-	int j, len = 0;
+	int len = 0;
 	char *endtok = action;
-	Bool matched;
-	int mlen;
+	const func_t *bif;
 
 	if (action)
 	{
@@ -1369,36 +1623,25 @@ void find_func_t(char *action, short *func_t, unsigned char *flags)
 			++endtok;
 		}
 		len = endtok - action;
-		j=0;
-		matched = False;
-		while (!matched && (mlen = strlen(func_table[j].keyword)) > 0)
+		bif = (len > 0) ? find_builtin_function_len(action, len) : NULL;
+		if (bif != NULL)
 		{
-			if (mlen == len &&
-			    strncasecmp(action,func_table[j].keyword,mlen) ==
-			    0)
+			/* found key word */
+			if (ret_func_t)
 			{
-				matched=True;
-				/* found key word */
-				if (func_t)
-				{
-					*func_t = func_table[j].func_t;
-				}
-				if (flags)
-				{
-					*flags = func_table[j].flags;
-				}
-				return;
+				*ret_func_t = bif->func_t;
 			}
-			else
+			if (flags)
 			{
-				j++;
+				*flags = bif->flags;
 			}
+			return;
 		}
 		/* No clue what the function is. Just return "BEEP" */
 	}
-	if (func_t)
+	if (ret_func_t)
 	{
-		*func_t = F_BEEP;
+		*ret_func_t = F_BEEP;
 	}
 	if (flags)
 	{
@@ -421,6 +421,7 @@ typedef struct action_flags
 struct namelist			/* matches to names in this list are ORed */
 {
 	char *name;
+	struct wild_pattern *pattern;
 	struct namelist *next;
 };
 
@@ -992,6 +993,17 @@ typedef struct FvwmWindow
 		int i;
 	} scratch;
 
+	/* where the window is filed in the spatial index (geom_index.c) */
+	struct
+	{
+		rectangle g;
+		int desk;
+		/* position in the list the window is kept in */
+		int slot;
+		unsigned int stamp;
+		unsigned char where;
+	} geom_index;
+
 	struct monitor *m;
 	struct monitor *m_prev;
 } FvwmWindow;
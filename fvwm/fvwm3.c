@@ -65,6 +65,8 @@
 #include "ewmh.h"
 #include "add_window.h"
 #include "libs/fvwmsignal.h"
+#include "libs/fpoll.h"
+#include "libs/FProperty.h"
 #include "stack.h"
 #include "virtual.h"
 #include "session.h"
@@ -144,7 +146,7 @@ Display *dpy = NULL;            /* which display are we talking to */
 Bool fFvwmInStartup = True;     /* Set to False when startup has finished */
 Bool DoingCommandLine = False;  /* Set True before each cmd line arg */
 
-XContext FvwmContext;           /* context for fvwm windows */
+wintable_t *FvwmWindowTable;    /* maps window ids to fvwm windows */
 XContext MenuContext;           /* context for fvwm menus */
 
 int JunkX = 0, JunkY = 0;
@@ -608,6 +610,9 @@ void Done(int restart, char *command)
 		 * but this is adequate for now */
 		sleep(1);
 
+		/* the new window manager must not inherit the signals that
+		 * are blocked for the event loop */
+		fpoll_restore_signals();
 		if (command)
 		{
 			char *my_argv[MAX_ARG_SIZE];
@@ -770,6 +775,12 @@ InstallSignals(void)
 	sigact.sa_flags |= SA_NOCLDSTOP;
 	sigact.sa_handler = fvwmReapChildren;
 	sigaction(SIGCHLD, &sigact, NULL);
+
+	/* After a Restart, SIGCHLD may still be blocked by the event loop of
+	 * the previous instance. */
+	sigemptyset(&sigact.sa_mask);
+	sigaddset(&sigact.sa_mask, SIGCHLD);
+	sigprocmask(SIG_UNBLOCK, &sigact.sa_mask, NULL);
 #else
 #ifdef USE_BSD_SIGNALS
 	fvwmSetSignalMask(
@@ -822,6 +833,7 @@ InstallSignals(void)
 
 void fvmm_deinstall_signals(void)
 {
+	fpoll_restore_signals();
 	signal(SIGCHLD, SIG_DFL);
 	signal(SIGHUP, SIG_DFL);
 	signal(SIGINT, SIG_DFL);
@@ -1094,7 +1106,7 @@ static void CreateGCs(void)
  ************************************************************************/
 static void InitVariables(void)
 {
-	FvwmContext = XUniqueContext();
+	FvwmWindowTable = wintable_create();
 	MenuContext = XUniqueContext();
 
 	/* initialize some lists */
@@ -1141,6 +1153,7 @@ static void InitVariables(void)
 	//Scr.EdgeScrollY = DEFAULT_EDGE_SCROLL * Scr.MyDisplayHeight / 100;
 	Scr.ScrollDelay = DEFAULT_SCROLL_DELAY;
 	Scr.OpaqueSize = DEFAULT_OPAQUE_MOVE_SIZE;
+	Scr.OpaqueFrameRate = DEFAULT_OPAQUE_FRAME_RATE;
 	Scr.MoveThreshold = DEFAULT_MOVE_THRESHOLD;
 	/* ClickTime is set to the positive value upon entering the
 	 * event loop. */
@@ -1507,6 +1520,11 @@ void StartupStuff(void)
 	ecc.w.wcontext = C_ROOT;
 	exc = exc_create_context(&ecc, ECC_TYPE | ECC_WCONTEXT);
 	CaptureAllWindows(exc, False);
+	if (debugging)
+	{
+		print_capture_info(1);
+		FPropertyPrintInfo(0);
+	}
 	/* Turn off the SM stuff after the initial capture so that new windows
 	 * will not be matched by accident. */
 	if (Restarting)
@@ -2217,6 +2235,26 @@ int main(int argc, char **argv)
 	}
 #endif
 
+	/* The event loop must not be shared with the processes forked for
+	 * the other screens above. */
+	DBUG("main", "Initialising the event loop");
+	fpoll_init();
+	fpoll_add(x_fd, FPOLL_IN, NULL);
+	{
+		sigset_t sigs;
+
+		/* With the epoll backend these signals are handled
+		 * synchronously from the main loop. */
+		sigemptyset(&sigs);
+		sigaddset(&sigs, SIGCHLD);
+		sigaddset(&sigs, SIGUSR1);
+		sigaddset(&sigs, SIGINT);
+		sigaddset(&sigs, SIGHUP);
+		sigaddset(&sigs, SIGQUIT);
+		sigaddset(&sigs, SIGTERM);
+		fpoll_add_signals(&sigs);
+	}
+
 	/* Add a DISPLAY entry to the environment, incase we were started
 	 * with fvwm -display term:0.0 */
 	len = strlen(XDisplayString(dpy));
@@ -0,0 +1,512 @@
+/* -*-c-*- */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see: <http://www.gnu.org/licenses/>
+ */
+
+/* ---------------------------- included header files ---------------------- */
+
+#include "config.h"
+
+#include <stdio.h>
+
+#include "libs/fvwmlib.h"
+#include "fvwm.h"
+#include "externs.h"
+#include "execcontext.h"
+#include "misc.h"
+#include "screen.h"
+#include "geometry.h"
+#include "geom_index.h"
+
+/* ---------------------------- local definitions -------------------------- */
+
+/* cells are 1 << GI_CELL_SHIFT pixels wide and high */
+#define GI_CELL_SHIFT 8
+/* windows that would cover more cells are kept in a list */
+#define GI_MAX_CELLS_PER_WINDOW 64
+/* must be a power of two */
+#define GI_MIN_BUCKETS 256
+
+/* ---------------------------- local macros ------------------------------- */
+
+#define GI_HASH(desk, cx, cy) \
+	((unsigned int)(cx) * 73856093u ^ (unsigned int)(cy) * 19349663u ^ \
+	 (unsigned int)(desk) * 83492791u)
+
+/* ---------------------------- imports ------------------------------------ */
+
+/* ---------------------------- included code files ------------------------ */
+
+/* ---------------------------- local types -------------------------------- */
+
+/* values of fw->geom_index.where */
+typedef enum
+{
+	GI_UNTRACKED = 0,
+	GI_GRID,
+	GI_LARGE,
+	GI_ICONIFIED
+} gi_where_t;
+
+typedef struct
+{
+	FvwmWindow **fws;
+	int num_fws;
+	int size;
+} gi_list_t;
+
+typedef struct gi_cell
+{
+	struct gi_cell *next;
+	int desk;
+	int cx;
+	int cy;
+	gi_list_t list;
+} gi_cell_t;
+
+typedef struct
+{
+	int x0;
+	int y0;
+	int x1;
+	int y1;
+} gi_cells_t;
+
+/* ---------------------------- forward declarations ----------------------- */
+
+/* ---------------------------- local variables ---------------------------- */
+
+static struct
+{
+	gi_cell_t **buckets;
+	unsigned int num_buckets;
+	unsigned int num_cells;
+	/* windows that cover too many cells */
+	gi_list_t large;
+	gi_list_t iconified;
+	/* result of the last query */
+	gi_list_t found;
+	unsigned int stamp;
+} gi;
+
+/* ---------------------------- exported variables (globals) --------------- */
+
+/* ---------------------------- local functions ---------------------------- */
+
+static void gi_list_append(gi_list_t *list, FvwmWindow *fw)
+{
+	if (list->num_fws == list->size)
+	{
+		list->size = (list->size == 0) ? 8 : 2 * list->size;
+		list->fws = fxrealloc(
+			(void *)list->fws, list->size, sizeof(FvwmWindow *));
+	}
+	list->fws[list->num_fws++] = fw;
+
+	return;
+}
+
+/* removes the entry at position i; the last entry takes its place */
+static void gi_list_delete(gi_list_t *list, int i)
+{
+	list->num_fws--;
+	list->fws[i] = list->fws[list->num_fws];
+
+	return;
+}
+
+static int gi_cell_coord(int v)
+{
+	/* round towards minus infinity */
+	if (v >= 0)
+	{
+		return v >> GI_CELL_SHIFT;
+	}
+
+	return -((-v - 1) >> GI_CELL_SHIFT) - 1;
+}
+
+/* The cells covering the rectangle.  Empty rectangles still cover the cell
+ * of their corner because intersect tests may consider them inside of a
+ * larger rectangle. */
+static void gi_get_cells(gi_cells_t *c, const rectangle *g)
+{
+	c->x0 = gi_cell_coord(g->x);
+	c->y0 = gi_cell_coord(g->y);
+	c->x1 = gi_cell_coord(g->x + ((g->width > 0) ? g->width - 1 : 0));
+	c->y1 = gi_cell_coord(g->y + ((g->height > 0) ? g->height - 1 : 0));
+
+	return;
+}
+
+static void gi_grow_buckets(void)
+{
+	gi_cell_t **old = gi.buckets;
+	unsigned int old_num = gi.num_buckets;
+	unsigned int i;
+
+	gi.num_buckets = (old_num == 0) ? GI_MIN_BUCKETS : 2 * old_num;
+	gi.buckets = fxcalloc(gi.num_buckets, sizeof(gi_cell_t *));
+	for (i = 0; i < old_num; i++)
+	{
+		gi_cell_t *cell;
+		gi_cell_t *next;
+
+		for (cell = old[i]; cell != NULL; cell = next)
+		{
+			unsigned int h;
+
+			next = cell->next;
+			h = GI_HASH(cell->desk, cell->cx, cell->cy) &
+				(gi.num_buckets - 1);
+			cell->next = gi.buckets[h];
+			gi.buckets[h] = cell;
+		}
+	}
+	free(old);
+
+	return;
+}
+
+/* returns the cell or NULL; with do_create an empty cell is created */
+static gi_cell_t *gi_get_cell(int desk, int cx, int cy, Bool do_create)
+{
+	gi_cell_t *cell;
+	unsigned int h;
+
+	if (gi.num_buckets == 0)
+	{
+		if (!do_create)
+		{
+			return NULL;
+		}
+		gi_grow_buckets();
+	}
+	h = GI_HASH(desk, cx, cy) & (gi.num_buckets - 1);
+	for (cell = gi.buckets[h]; cell != NULL; cell = cell->next)
+	{
+		if (cell->cx == cx && cell->cy == cy && cell->desk == desk)
+		{
+			return cell;
+		}
+	}
+	if (!do_create)
+	{
+		return NULL;
+	}
+	if (gi.num_cells >= gi.num_buckets)
+	{
+		gi_grow_buckets();
+		h = GI_HASH(desk, cx, cy) & (gi.num_buckets - 1);
+	}
+	cell = fxcalloc(1, sizeof(gi_cell_t));
+	cell->desk = desk;
+	cell->cx = cx;
+	cell->cy = cy;
+	cell->next = gi.buckets[h];
+	gi.buckets[h] = cell;
+	gi.num_cells++;
+
+	return cell;
+}
+
+static void gi_free_cell(gi_cell_t *cell)
+{
+	gi_cell_t **pc;
+
+	pc = &gi.buckets[
+		GI_HASH(cell->desk, cell->cx, cell->cy) & (gi.num_buckets - 1)];
+	for ( ; *pc != NULL; pc = &(*pc)->next)
+	{
+		if (*pc == cell)
+		{
+			*pc = cell->next;
+			break;
+		}
+	}
+	free(cell->list.fws);
+	free(cell);
+	gi.num_cells--;
+
+	return;
+}
+
+static void gi_unfile(FvwmWindow *fw)
+{
+	gi_list_t *list;
+	int i;
+
+	switch (fw->geom_index.where)
+	{
+	case GI_GRID:
+	{
+		gi_cells_t c;
+		int cx;
+		int cy;
+
+		gi_get_cells(&c, &fw->geom_index.g);
+		for (cy = c.y0; cy <= c.y1; cy++)
+		{
+			for (cx = c.x0; cx <= c.x1; cx++)
+			{
+				gi_cell_t *cell;
+
+				cell = gi_get_cell(
+					fw->geom_index.desk, cx, cy, False);
+				if (cell == NULL)
+				{
+					continue;
+				}
+				for (i = 0; i < cell->list.num_fws; i++)
+				{
+					if (cell->list.fws[i] == fw)
+					{
+						gi_list_delete(&cell->list, i);
+						break;
+					}
+				}
+				if (cell->list.num_fws == 0)
+				{
+					gi_free_cell(cell);
+				}
+			}
+		}
+		break;
+	}
+	case GI_LARGE:
+	case GI_ICONIFIED:
+		list = (fw->geom_index.where == GI_LARGE) ?
+			&gi.large : &gi.iconified;
+		i = fw->geom_index.slot;
+		gi_list_delete(list, i);
+		if (i < list->num_fws)
+		{
+			list->fws[i]->geom_index.slot = i;
+		}
+		break;
+	default:
+		break;
+	}
+	fw->geom_index.where = GI_UNTRACKED;
+
+	return;
+}
+
+static void gi_file(FvwmWindow *fw)
+{
+	gi_list_t *list;
+	gi_cells_t c;
+
+	fw->geom_index.g = fw->g.frame;
+	fw->geom_index.desk = fw->Desk;
+	if (IS_ICONIFIED(fw))
+	{
+		list = &gi.iconified;
+		fw->geom_index.where = GI_ICONIFIED;
+	}
+	else
+	{
+		gi_get_cells(&c, &fw->geom_index.g);
+		if ((c.x1 - c.x0 + 1) * (c.y1 - c.y0 + 1) <=
+		    GI_MAX_CELLS_PER_WINDOW)
+		{
+			int cx;
+			int cy;
+
+			for (cy = c.y0; cy <= c.y1; cy++)
+			{
+				for (cx = c.x0; cx <= c.x1; cx++)
+				{
+					gi_list_append(
+						&gi_get_cell(
+							fw->Desk, cx, cy,
+							True)->list, fw);
+				}
+			}
+			fw->geom_index.where = GI_GRID;
+
+			return;
+		}
+		list = &gi.large;
+		fw->geom_index.where = GI_LARGE;
+	}
+	fw->geom_index.slot = list->num_fws;
+	gi_list_append(list, fw);
+
+	return;
+}
+
+/* adds the window to the result of the query if it really overlaps */
+static void gi_check_window(FvwmWindow *fw, int desk, const rectangle *g)
+{
+	rectangle g2;
+
+	if (fw->geom_index.stamp == gi.stamp)
+	{
+		return;
+	}
+	fw->geom_index.stamp = gi.stamp;
+	if (fw->Desk != desk)
+	{
+		return;
+	}
+	if (get_visible_window_or_icon_geometry(fw, &g2) == False)
+	{
+		return;
+	}
+	if (g->x >= g2.x + g2.width || g->x + g->width <= g2.x ||
+	    g->y >= g2.y + g2.height || g->y + g->height <= g2.y)
+	{
+		return;
+	}
+	gi_list_append(&gi.found, fw);
+
+	return;
+}
+
+/* ---------------------------- interface functions ------------------------ */
+
+void geom_index_add(FvwmWindow *fw)
+{
+	if (fw->geom_index.where == GI_UNTRACKED)
+	{
+		gi_file(fw);
+	}
+
+	return;
+}
+
+void geom_index_remove(FvwmWindow *fw)
+{
+	gi_unfile(fw);
+
+	return;
+}
+
+void geom_index_update(FvwmWindow *fw)
+{
+	switch (fw->geom_index.where)
+	{
+	case GI_UNTRACKED:
+		return;
+	case GI_ICONIFIED:
+		if (IS_ICONIFIED(fw))
+		{
+			/* icons are checked when the index is queried */
+			return;
+		}
+		break;
+	default:
+		if (!IS_ICONIFIED(fw) && fw->Desk == fw->geom_index.desk &&
+		    fw->g.frame.x == fw->geom_index.g.x &&
+		    fw->g.frame.y == fw->geom_index.g.y &&
+		    fw->g.frame.width == fw->geom_index.g.width &&
+		    fw->g.frame.height == fw->geom_index.g.height)
+		{
+			return;
+		}
+		break;
+	}
+	gi_unfile(fw);
+	gi_file(fw);
+
+	return;
+}
+
+int geom_index_find_overlapping(
+	FvwmWindow ***ret_fws, int desk, const rectangle *g)
+{
+	gi_cells_t c;
+	int cx;
+	int cy;
+	int i;
+
+	gi.found.num_fws = 0;
+	gi.stamp++;
+	if (gi.stamp == 0)
+	{
+		FvwmWindow *t;
+
+		for (t = Scr.FvwmRoot.next; t != NULL; t = t->next)
+		{
+			t->geom_index.stamp = 0;
+		}
+		gi.stamp = 1;
+	}
+	gi_get_cells(&c, g);
+	if ((c.x1 - c.x0 + 1) * (c.y1 - c.y0 + 1) > (int)gi.num_cells)
+	{
+		unsigned int h;
+
+		/* cheaper to look at all cells */
+		for (h = 0; h < gi.num_buckets; h++)
+		{
+			gi_cell_t *cell;
+
+			for (cell = gi.buckets[h]; cell != NULL;
+			     cell = cell->next)
+			{
+				if (cell->desk != desk ||
+				    cell->cx < c.x0 || cell->cx > c.x1 ||
+				    cell->cy < c.y0 || cell->cy > c.y1)
+				{
+					continue;
+				}
+				for (i = 0; i < cell->list.num_fws; i++)
+				{
+					gi_check_window(
+						cell->list.fws[i], desk, g);
+				}
+			}
+		}
+	}
+	else
+	{
+		for (cy = c.y0; cy <= c.y1; cy++)
+		{
+			for (cx = c.x0; cx <= c.x1; cx++)
+			{
+				gi_cell_t *cell;
+
+				cell = gi_get_cell(desk, cx, cy, False);
+				if (cell == NULL)
+				{
+					continue;
+				}
+				for (i = 0; i < cell->list.num_fws; i++)
+				{
+					gi_check_window(
+						cell->list.fws[i], desk, g);
+				}
+			}
+		}
+	}
+	for (i = 0; i < gi.large.num_fws; i++)
+	{
+		gi_check_window(gi.large.fws[i], desk, g);
+	}
+	for (i = 0; i < gi.iconified.num_fws; i++)
+	{
+		gi_check_window(gi.iconified.fws[i], desk, g);
+	}
+	*ret_fws = gi.found.fws;
+
+	return gi.found.num_fws;
+}
+
+int geom_index_get_iconified(FvwmWindow ***ret_fws)
+{
+	*ret_fws = gi.iconified.fws;
+
+	return gi.iconified.num_fws;
+}
@@ -0,0 +1,46 @@
+/* -*-c-*- */
+
+#ifndef GEOM_INDEX_H
+#define GEOM_INDEX_H
+
+/* Spatial index of the window geometry.
+ *
+ * The frames of all windows that are not iconified are kept in a grid of
+ * cells per desk, so the windows near a rectangle can be found without
+ * looking at every window.  Iconified windows and windows that cover very
+ * many cells are kept in lists instead; their geometry is checked when the
+ * index is queried.  The index must be told about every change of the frame
+ * geometry, the desk or the iconified state of a window through
+ * geom_index_update().
+ */
+
+/* ---------------------------- included header files ---------------------- */
+
+/* ---------------------------- global definitions ------------------------- */
+
+/* ---------------------------- global macros ------------------------------ */
+
+/* ---------------------------- type definitions --------------------------- */
+
+/* ---------------------------- exported variables (globals) --------------- */
+
+/* ---------------------------- interface functions ------------------------ */
+
+/* Start tracking a window that has just been linked into the window list. */
+void geom_index_add(FvwmWindow *fw);
+/* Stop tracking a window that is about to be destroyed. */
+void geom_index_remove(FvwmWindow *fw);
+/* Move the window to where its current desk, frame geometry and iconified
+ * state belong.  Cheap if nothing has changed. */
+void geom_index_update(FvwmWindow *fw);
+/* Find all windows on the desk whose visible window or icon geometry
+ * overlaps the rectangle (see get_visible_window_or_icon_geometry()).  The
+ * number of windows is returned and the windows are stored in *ret_fws in no
+ * particular order.  The array is valid until the next call. */
+int geom_index_find_overlapping(
+	FvwmWindow ***ret_fws, int desk, const rectangle *g);
+/* Returns the number of iconified windows on all desks and stores them in
+ * *ret_fws.  The array is valid until the index is changed. */
+int geom_index_get_iconified(FvwmWindow ***ret_fws);
+
+#endif /* GEOM_INDEX_H */
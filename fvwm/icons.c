@@ -36,6 +36,7 @@
 #include "libs/Rectangles.c"
 #include "libs/charmap.h"
 #include "libs/wcontext.h"
+#include "libs/FProperty.h"
 #include "fvwm.h"
 #include "externs.h"
 #include "cursor.h"
@@ -58,6 +59,7 @@
 #include "module_interface.h"
 #include "ewmh.h"
 #include "geometry.h"
+#include "geom_index.h"
 
 static int do_all_iconboxes(FvwmWindow *t, icon_boxes **icon_boxes_ptr);
 static void GetIconFromFile(FvwmWindow *fw);
@@ -623,7 +625,7 @@ void CreateIconWindow(FvwmWindow *fw, int def_x, int def_y)
 	{
 		if (FW_W_ICON_TITLE(fw))
 		{
-			XDeleteContext(dpy, FW_W_ICON_TITLE(fw), FvwmContext);
+			wintable_remove(FvwmWindowTable, FW_W_ICON_TITLE(fw));
 			XDestroyWindow(dpy, FW_W_ICON_TITLE(fw));
 			XFlush(dpy);
 			FW_W_ICON_TITLE(fw) = None;
@@ -733,7 +735,7 @@ void CreateIconWindow(FvwmWindow *fw, int def_x, int def_y)
 	{
 		/* destroy the old window */
 		XDestroyWindow(dpy, old_icon_pixmap_w);
-		XDeleteContext(dpy, old_icon_pixmap_w, FvwmContext);
+		wintable_remove(FvwmWindowTable, old_icon_pixmap_w);
 		XFlush(dpy);
 		is_old_icon_shaped = False;
 	}
@@ -777,8 +779,7 @@ void CreateIconWindow(FvwmWindow *fw, int def_x, int def_y)
 
 	if (FW_W_ICON_TITLE(fw) != None && FW_W_ICON_TITLE(fw) != old_icon_w)
 	{
-		XSaveContext(
-			dpy, FW_W_ICON_TITLE(fw), FvwmContext, (caddr_t)fw);
+		wintable_insert(FvwmWindowTable, FW_W_ICON_TITLE(fw), fw);
 		XDefineCursor(
 			dpy, FW_W_ICON_TITLE(fw), Scr.FvwmCursors[CRS_DEFAULT]);
 		GrabAllWindowKeysAndButtons(
@@ -793,8 +794,7 @@ void CreateIconWindow(FvwmWindow *fw, int def_x, int def_y)
 	if (FW_W_ICON_PIXMAP(fw) != None &&
 	    FW_W_ICON_PIXMAP(fw) != old_icon_pixmap_w)
 	{
-		XSaveContext(
-			dpy, FW_W_ICON_PIXMAP(fw), FvwmContext, (caddr_t)fw);
+		wintable_insert(FvwmWindowTable, FW_W_ICON_PIXMAP(fw), fw);
 		XDefineCursor(
 			dpy, FW_W_ICON_PIXMAP(fw),
 			Scr.FvwmCursors[CRS_DEFAULT]);
@@ -1585,6 +1585,7 @@ void ChangeIconPixmap(FvwmWindow *fw)
 			}
 		}
 		SET_ICONIFIED(fw, 1);
+		geom_index_update(fw);
 		DrawIconWindow(fw, False, True, False, False, NULL);
 	}
 
@@ -1653,6 +1654,7 @@ void AutoPlaceIcon(
   if (IS_ICON_STICKY_ACROSS_DESKS(t) || IS_STICKY_ACROSS_DESKS(t))
   {
     t->Desk = t->m->virtual_scr.CurrentDesk;
+    geom_index_update(t);
   }
   if (IS_ICON_STICKY_ACROSS_PAGES(t) || IS_STICKY_ACROSS_PAGES(t))
   {
@@ -1776,6 +1778,9 @@ void AutoPlaceIcon(
     dimension dim[3];                   /* space for work, 1st, 2nd dimen */
     icon_boxes *icon_boxes_ptr;         /* current icon box */
     int i;                              /* index for inner/outer loop data */
+    FvwmWindow **icons;                 /* iconified windows */
+    int num_icons;
+    int j;
     fscreen_scr_arg *fscr;
     rectangle ref;
     rectangle g;
@@ -1968,10 +1973,11 @@ void AutoPlaceIcon(
 	  {
 	    loc_ok_wrong_screen2 = True;
 	  }
-	  test_fw = Scr.FvwmRoot.next;
-	  while((test_fw != (FvwmWindow *)0)
-		&&(loc_ok == True || loc_ok_wrong_screen2))
+	  num_icons = geom_index_get_iconified(&icons);
+	  for (j = 0; j < num_icons
+		 &&(loc_ok == True || loc_ok_wrong_screen2); j++)
 	  {
+	    test_fw = icons[j];
 	    /* test overlap */
 	    if (test_fw->Desk == t->Desk)
 	    {
@@ -1994,8 +2000,7 @@ void AutoPlaceIcon(
 		} /* end if icons overlap */
 	      } /* end if its an icon */
 	    } /* end if same desk */
-	    test_fw = test_fw->next;
-	  } /* end while icons that may overlap */
+	  } /* end for icons that may overlap */
 	  if (loc_ok_wrong_screen2)
 	  {
 	    loc_ok_wrong_screen = True;
@@ -2414,6 +2419,7 @@ void DeIconify(FvwmWindow *fw)
 			SET_ICONIFIED(t, 0);
 			SET_ICON_UNMAPPED(t, 0);
 			SET_ICON_ENTERED(t, 0);
+			geom_index_update(t);
 			/* Need to make sure the border is colored correctly,
 			 * in case it was stuck or unstuck while iconified. */
 			tmp = Scr.Hilite;
@@ -2536,6 +2542,7 @@ void Iconify(FvwmWindow *fw, initial_window_options_t *win_opts)
 				SET_ICONIFIED(t, 1);
 				SET_ICON_UNMAPPED(t, 1);
 				SET_ICONIFIED_BY_PARENT(t, 1);
+				geom_index_update(t);
 				get_icon_geometry(t, &g);
 				BroadcastPacket(
 					M_ICONIFY, 7, (long)FW_W(t),
@@ -2599,6 +2606,7 @@ void Iconify(FvwmWindow *fw, initial_window_options_t *win_opts)
 	}
 	SET_ICONIFIED(fw, 1);
 	SET_ICON_UNMAPPED(fw, 0);
+	geom_index_update(fw);
 	get_icon_geometry(fw, &icon_rect);
 	/* if this fails it does not overwrite icon_rect */
 	EWMH_GetIconGeometry(fw, &icon_rect);
@@ -2619,6 +2627,7 @@ void Iconify(FvwmWindow *fw, initial_window_options_t *win_opts)
 	if (IS_ICON_STICKY_ACROSS_DESKS(fw) || IS_STICKY_ACROSS_DESKS(fw))
 	{
 		fw->Desk = fw->m->virtual_scr.CurrentDesk;
+		geom_index_update(fw);
 	}
 	if (fw->Desk == fw->m->virtual_scr.CurrentDesk)
 	{
@@ -2655,6 +2664,7 @@ void SetMapStateProp(const FvwmWindow *fw, int state)
 	XChangeProperty(
 		dpy, FW_W(fw), _XA_WM_STATE, _XA_WM_STATE, 32, PropModeReplace,
 		(unsigned char *) data, 2);
+	FPropertyInvalidate(FW_W(fw), _XA_WM_STATE);
 
 	return;
 }
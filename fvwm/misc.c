@@ -552,8 +552,7 @@ FvwmWindow *get_pointer_fvwm_window(void)
 		Window *children;
 		unsigned int nchildren;
 
-		if (XFindContext(dpy, win, FvwmContext, (caddr_t *) &t) !=
-		    XCNOENT)
+		if (wintable_find(FvwmWindowTable, win, (void **)&t))
 		{
 			/* found a matching window context */
 			return t;
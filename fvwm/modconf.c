@@ -358,7 +358,19 @@ void CMD_Send_ConfigInfo(F_CMD_ARGS)
 	/* get length once for efficiency */
 	int match_len = 0;
 	fmodule *mod = exc->m.module;
+	Bool is_bulk = False;
 
+	if (mod == NULL)
+	{
+		return;
+	}
+	/* modules that ask for it get all lines in one snapshot */
+	if (StrEquals(PeekToken(action, NULL), "Bulk"))
+	{
+		is_bulk = True;
+		PeekToken(action, &action);
+		module_snapshot_begin(mod, M_CONFIG_INFO);
+	}
 	send_desktop_geometry(mod);
 	/* send ImagePath and ColorLimit first */
 	send_image_path(mod);
@@ -380,6 +392,10 @@ void CMD_Send_ConfigInfo(F_CMD_ARGS)
 	SendPacket(
 		mod, M_END_CONFIG_INFO, (long)0, (long)0, (long)0, (long)0,
 		(long)0, (long)0, (long)0, (long)0);
+	if (is_bulk)
+	{
+		module_snapshot_send();
+	}
 
 	return;
 }
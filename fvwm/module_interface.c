@@ -49,6 +49,19 @@ static fqueue cqueue = FQUEUE_INIT;
 
 static const unsigned long dummy = 0;
 
+/* While a snapshot is built for a module, the packets for that module are
+ * collected here instead of being sent; see module_snapshot_begin(). */
+static struct
+{
+	fmodule *module;
+	/* the type of the packets that carry the snapshot */
+	unsigned long type;
+	unsigned long *data;
+	/* in unsigned longs */
+	int size;
+	int used;
+} snapshot;
+
 static unsigned long *
 make_vpacket(unsigned long *body, unsigned long event_type,
 	     unsigned long num, va_list ap)
@@ -180,6 +193,109 @@ make_new_vpacket(unsigned char *body, unsigned long event_type,
 
 
 
+/* Appends the packet as a record of the snapshot: the number of body words,
+ * the type and the body. */
+static void snapshot_add_packet(unsigned long *ptr, int size)
+{
+	int n;
+
+	if (
+		!IS_MESSAGE_IN_MASK(&(MOD_PIPEMASK(snapshot.module)), ptr[1]) ||
+		!module_filter_packet(snapshot.module, ptr))
+	{
+		return;
+	}
+	n = size / sizeof(unsigned long) - FvwmPacketHeaderSize;
+	if (snapshot.used + n + 2 > snapshot.size)
+	{
+		snapshot.size = 2 * snapshot.size + n + 2;
+		snapshot.data = fxrealloc(
+			(void *)snapshot.data, snapshot.size,
+			sizeof(unsigned long));
+	}
+	snapshot.data[snapshot.used++] = n;
+	snapshot.data[snapshot.used++] = ptr[1];
+	memcpy(
+		&snapshot.data[snapshot.used], &ptr[FvwmPacketHeaderSize],
+		n * sizeof(unsigned long));
+	snapshot.used += n;
+
+	return;
+}
+
+void module_snapshot_begin(fmodule *module, unsigned long type)
+{
+	snapshot.module = module;
+	snapshot.type = type;
+	snapshot.used = 0;
+
+	return;
+}
+
+void module_snapshot_send(void)
+{
+	unsigned long body[FvwmPacketMaxSize];
+	fmodule *module = snapshot.module;
+	unsigned long type = snapshot.type;
+	unsigned long *data = snapshot.data;
+	int used = snapshot.used;
+	int offset = 0;
+
+	/* PositiveWrite() may wait for the module and run its commands, which
+	 * may start a new snapshot; so take the data out of the global */
+	snapshot.module = NULL;
+	snapshot.data = NULL;
+	snapshot.size = 0;
+	snapshot.used = 0;
+	do
+	{
+		int n;
+
+		n = used - offset;
+		if (n > FvwmPacketBodyMaxSize - MX_WINDOW_SNAPSHOT_HEADER_SIZE)
+		{
+			n = FvwmPacketBodyMaxSize -
+				MX_WINDOW_SNAPSHOT_HEADER_SIZE;
+		}
+		body[0] = START_FLAG;
+		body[1] = type;
+		body[2] = FvwmPacketHeaderSize +
+			MX_WINDOW_SNAPSHOT_HEADER_SIZE + n;
+		body[3] = fev_get_evtime();
+		body[4] = MX_WINDOW_SNAPSHOT_VERSION;
+		body[5] = used;
+		body[6] = offset;
+		if (n > 0)
+		{
+			memcpy(
+				&body[FvwmPacketHeaderSize +
+				      MX_WINDOW_SNAPSHOT_HEADER_SIZE],
+				&data[offset], n * sizeof(unsigned long));
+		}
+		PositiveWrite(module, body, body[2] * sizeof(unsigned long));
+		offset += n;
+	} while (offset < used);
+	if (data != NULL)
+	{
+		free(data);
+	}
+
+	return;
+}
+
+/* All packets for a single module go through here. */
+static void send_packet(fmodule *module, unsigned long *ptr, int size)
+{
+	if (snapshot.module != NULL && module == snapshot.module)
+	{
+		snapshot_add_packet(ptr, size);
+		return;
+	}
+	PositiveWrite(module, ptr, size);
+
+	return;
+}
+
 void SendPacket(
 	fmodule *module, unsigned long event_type, unsigned long num_datum,
 	...)
@@ -190,7 +306,7 @@ void SendPacket(
 	va_start(ap, num_datum);
 	make_vpacket(body, event_type, num_datum, ap);
 	va_end(ap);
-	PositiveWrite(
+	send_packet(
 		module, body,
 		(num_datum+FvwmPacketHeaderSize)*sizeof(body[0]));
 
@@ -201,19 +317,12 @@ void BroadcastPacket(unsigned long event_type, unsigned long num_datum, ...)
 {
 	unsigned long body[FvwmPacketMaxSize];
 	va_list ap;
-	fmodule_list_itr moditr;
-	fmodule *module;
 
 	va_start(ap,num_datum);
 	make_vpacket(body, event_type, num_datum, ap);
 	va_end(ap);
-	module_list_itr_init(&moditr);
-	while ( (module = module_list_itr_next(&moditr)) != NULL)
-	{
-		PositiveWrite(
-			module, body,
-			(num_datum+FvwmPacketHeaderSize)*sizeof(body[0]));
-	}
+	module_broadcast(
+		body, (num_datum+FvwmPacketHeaderSize)*sizeof(body[0]));
 
 	return;
 }
@@ -233,7 +342,7 @@ static void SendNewPacket(
 	va_start(ap,num_datum);
 	plen = make_new_vpacket(body, event_type, num_datum, ap);
 	va_end(ap);
-	PositiveWrite(module, (void *) &body, plen);
+	send_packet(module, (void *) &body, plen);
 
 	return;
 }
@@ -243,18 +352,12 @@ static void BroadcastNewPacket(unsigned long event_type,
 {
 	unsigned char body[FvwmPacketMaxSize_byte];
 	va_list ap;
-	fmodule_list_itr moditr;
-	fmodule *module;
 	unsigned long plen;
 
 	va_start(ap,num_datum);
 	plen = make_new_vpacket(body, event_type, num_datum, ap);
 	va_end(ap);
-	module_list_itr_init(&moditr);
-	while ( (module = module_list_itr_next(&moditr)) != NULL)
-	{
-		PositiveWrite(module, (void *) &body, plen);
-	}
+	module_broadcast((void *) &body, plen);
 
 	return;
 }
@@ -380,10 +483,11 @@ void BroadcastConfig(unsigned long event_type, const FvwmWindow *t)
 	return;
 }
 
+/* body must have room for FvwmPacketMaxSize unsigned longs */
 static unsigned long *make_named_packet(
-	int *len, unsigned long event_type, const char *name, int num, ...)
+	unsigned long *body, int *len, unsigned long event_type,
+	const char *name, int num, ...)
 {
-	unsigned long *body;
 	va_list ap;
 
 	/* Packet is the header plus the items plus enough items to hold the
@@ -396,7 +500,6 @@ static unsigned long *make_named_packet(
 		*len = FvwmPacketMaxSize;
 	}
 
-	body = fxmalloc(*len * sizeof(unsigned long));
 	/* Zero out end of memory to avoid uninit memory access. */
 	body[*len-1] = 0;
 
@@ -416,16 +519,15 @@ void SendName(
 	unsigned long data1,unsigned long data2, unsigned long data3,
 	const char *name)
 {
-	unsigned long *body;
+	unsigned long body[FvwmPacketMaxSize];
 	int l;
 
 	if (name == NULL)
 	{
 		return;
 	}
-	body = make_named_packet(&l, event_type, name, 3, data1, data2, data3);
-	PositiveWrite(module, body, l*sizeof(unsigned long));
-	free(body);
+	make_named_packet(body, &l, event_type, name, 3, data1, data2, data3);
+	send_packet(module, body, l*sizeof(unsigned long));
 
 	return;
 }
@@ -435,22 +537,15 @@ void BroadcastName(
 	unsigned long data1, unsigned long data2, unsigned long data3,
 	const char *name)
 {
-	unsigned long *body;
+	unsigned long body[FvwmPacketMaxSize];
 	int l;
-	fmodule_list_itr moditr;
-	fmodule *module;
 
 	if (name == NULL)
 	{
 		return;
 	}
-	body = make_named_packet(&l, event_type, name, 3, data1, data2, data3);
-	module_list_itr_init(&moditr);
-	while ( (module = module_list_itr_next(&moditr)) != NULL)
-	{
-		PositiveWrite(module, body, l*sizeof(unsigned long));
-	}
-	free(body);
+	make_named_packet(body, &l, event_type, name, 3, data1, data2, data3);
+	module_broadcast(body, l*sizeof(unsigned long));
 
 	return;
 }
@@ -484,7 +579,7 @@ void SendFvwmPicture(
 	unsigned long data2, unsigned long data3, FvwmPicture *picture,
 	char *name)
 {
-	unsigned long *body;
+	unsigned long body[FvwmPacketMaxSize];
 	unsigned long
 		data4 = 0, data5 = 0, data6 = 0,
 		data7 = 0, data8 = 0, data9 = 0;
@@ -508,11 +603,10 @@ void SendFvwmPicture(
 		data8 = picture->mask;
 		data9 = picture->alpha;
 	}
-	body = make_named_packet(
-		&l, event_type, name, 9, data1, data2, data3, data4, data5,
-		data6, data7, data8, data9);
-	PositiveWrite(module, body, l*sizeof(unsigned long));
-	free(body);
+	make_named_packet(
+		body, &l, event_type, name, 9, data1, data2, data3, data4,
+		data5, data6, data7, data8, data9);
+	send_packet(module, body, l*sizeof(unsigned long));
 
 	return;
 }
@@ -521,11 +615,9 @@ void BroadcastFvwmPicture(
 	unsigned long event_type, unsigned long data1, unsigned long data2,
 	unsigned long data3, FvwmPicture *picture, char *name)
 {
-	unsigned long *body;
+	unsigned long body[FvwmPacketMaxSize];
 	unsigned long data4, data5, data6, data7, data8, data9;
 	int l;
-	fmodule_list_itr moditr;
-	fmodule *module;
 
 	if (!FMiniIconsSupported)
 	{
@@ -549,15 +641,10 @@ void BroadcastFvwmPicture(
 		data8 = 0;
 		data9 = 0;
 	}
-	body = make_named_packet(
-		&l, event_type, name, 9, data1, data2, data3, data4, data5,
-		data6, data7, data8, data9);
-	module_list_itr_init(&moditr);
-	while ( (module = module_list_itr_next(&moditr)) != NULL)
-	{
-		PositiveWrite(module, body, l*sizeof(unsigned long));
-	}
-	free(body);
+	make_named_packet(
+		body, &l, event_type, name, 9, data1, data2, data3, data4,
+		data5, data6, data7, data8, data9);
+	module_broadcast(body, l*sizeof(unsigned long));
 
 	return;
 }
@@ -567,16 +654,10 @@ void BroadcastFvwmPicture(
  */
 void BroadcastColorset(int n)
 {
-	fmodule_list_itr moditr;
-	fmodule *module;
 	char *buf;
 
 	buf = DumpColorset(n, &Colorset[n]);
-	module_list_itr_init(&moditr);
-	while ( (module = module_list_itr_next(&moditr)) != NULL)
-	{
-		SendName(module, M_CONFIG_INFO, 0, 0, 0, buf);
-	}
+	BroadcastName(M_CONFIG_INFO, 0, 0, 0, buf);
 
 	return;
 }
@@ -588,15 +669,7 @@ void BroadcastPropertyChange(
 	unsigned long argument, unsigned long data1, unsigned long data2,
 	char *string)
 {
-	fmodule_list_itr moditr;
-	fmodule *module;
-
-	module_list_itr_init(&moditr);
-	while ( (module = module_list_itr_next(&moditr)) != NULL)
-	{
-		SendName(module, MX_PROPERTY_CHANGE, argument,
-			 data1, data2, string);
-	}
+	BroadcastName(MX_PROPERTY_CHANGE, argument, data1, data2, string);
 
 	return;
 }
@@ -606,14 +679,7 @@ void BroadcastPropertyChange(
  */
 void BroadcastConfigInfoString(char *string)
 {
-	fmodule_list_itr moditr;
-	fmodule *module;
-
-	module_list_itr_init(&moditr);
-	while ( (module = module_list_itr_next(&moditr)) != NULL)
-	{
-		SendName(module, M_CONFIG_INFO, 0, 0, 0, string);
-	}
+	BroadcastName(M_CONFIG_INFO, 0, 0, 0, string);
 
 	return;
 }
@@ -640,8 +706,7 @@ void module_input_execute(struct fmodule_input *input)
 	int flags;
 
 	memset(&e, 0, sizeof(e));
-	if (XFindContext(dpy, input->window, FvwmContext,
-				 (caddr_t *)&ecc.w.fw) == XCNOENT)
+	if (!wintable_find(FvwmWindowTable, input->window, (void **)&ecc.w.fw))
 	{
 		ecc.w.fw = NULL;
 		input->window = None;
@@ -799,6 +864,34 @@ void CMD_SendToModule(F_CMD_ARGS)
 	return;
 }
 
+/*
+** send the event handler statistics to the calling module
+*/
+void CMD_Send_EventStats(F_CMD_ARGS)
+{
+	if (exc->m.module == NULL)
+	{
+		return;
+	}
+	send_event_stats(exc->m.module);
+
+	return;
+}
+
+/*
+** send the statistics of all modules to the calling module
+*/
+void CMD_Send_ModuleStats(F_CMD_ARGS)
+{
+	if (exc->m.module == NULL)
+	{
+		return;
+	}
+	send_module_info(exc->m.module);
+
+	return;
+}
+
 /*
 ** send an arbitrary string back to the calling module
 */
@@ -837,16 +930,89 @@ void CMD_Send_Reply(F_CMD_ARGS)
 	return;
 }
 
+/* Send all a module has to know about a window, as Send_WindowList does. */
+void SendWindowInfo(fmodule *mod, FvwmWindow *t)
+{
+	SendConfig(mod,M_CONFIGURE_WINDOW,t);
+	SendName(
+		mod, M_WINDOW_NAME, FW_W(t), FW_W_FRAME(t),
+		(unsigned long)t, t->name.name);
+	SendName(
+		mod, M_ICON_NAME, FW_W(t), FW_W_FRAME(t),
+		(unsigned long)t, t->icon_name.name);
+	SendName(
+		mod, M_VISIBLE_NAME, FW_W(t), FW_W_FRAME(t),
+		(unsigned long)t, t->visible_name);
+	SendName(
+		mod, MX_VISIBLE_ICON_NAME, FW_W(t), FW_W_FRAME(t),
+		(unsigned long)t,t->visible_icon_name);
+	if (t->icon_bitmap_file != NULL
+	    && t->icon_bitmap_file != Scr.DefaultIcon)
+	{
+		SendName(
+			mod, M_ICON_FILE, FW_W(t), FW_W_FRAME(t),
+			(unsigned long)t, t->icon_bitmap_file);
+	}
+
+	SendName(
+		mod, M_RES_CLASS, FW_W(t), FW_W_FRAME(t),
+		(unsigned long)t, t->class.res_class);
+	SendName(
+		mod, M_RES_NAME, FW_W(t), FW_W_FRAME(t),
+		(unsigned long)t, t->class.res_name);
+
+	if (IS_ICONIFIED(t) && !IS_ICON_UNMAPPED(t))
+	{
+		rectangle r;
+		Bool rc;
+
+		rc = get_visible_icon_geometry(t, &r);
+		if (rc == True)
+		{
+			SendPacket(
+				mod, M_ICONIFY, 7, (long)FW_W(t),
+				(long)FW_W_FRAME(t), (unsigned long)t,
+				(long)r.x, (long)r.y,
+				(long)r.width, (long)r.height);
+		}
+	}
+	if ((IS_ICONIFIED(t))&&(IS_ICON_UNMAPPED(t)))
+	{
+		SendPacket(
+			mod, M_ICONIFY, 7, (long)FW_W(t),
+			(long)FW_W_FRAME(t), (unsigned long)t,
+			(long)0, (long)0, (long)0, (long)0);
+	}
+	if (FMiniIconsSupported && t->mini_icon != NULL)
+	{
+		SendFvwmPicture(
+			mod, M_MINI_ICON, FW_W(t), FW_W_FRAME(t),
+			(unsigned long)t, t->mini_icon,
+			t->mini_pixmap_file);
+	}
+
+	return;
+}
+
 void CMD_Send_WindowList(F_CMD_ARGS)
 {
 	FvwmWindow *t;
 	fmodule *mod = exc->m.module;
 	struct monitor	*m;
+	Bool do_snapshot = False;
 
 	if (mod == NULL)
 	{
 		return;
 	}
+	/* modules that ask for it get the packets of each monitor in one
+	 * snapshot */
+	if (
+		StrEquals(PeekToken(action, NULL), "Snapshot") &&
+		IS_MESSAGE_IN_MASK(&(MOD_PIPEMASK(mod)), MX_WINDOW_SNAPSHOT))
+	{
+		do_snapshot = True;
+	}
 
 	/* TA: 2020-01-09:  We send this for *ALL* configured monitors.
 	 *
@@ -854,6 +1020,10 @@ void CMD_Send_WindowList(F_CMD_ARGS)
 	 * in.
 	 */
 	TAILQ_FOREACH(m, &monitor_q, entry) {
+		if (do_snapshot)
+		{
+			module_snapshot_begin(mod, MX_WINDOW_SNAPSHOT);
+		}
 		SendPacket(mod, M_NEW_DESK, 2, (long)m->virtual_scr.CurrentDesk,
 			(long)m->number);
 		SendPacket(
@@ -889,63 +1059,12 @@ void CMD_Send_WindowList(F_CMD_ARGS)
 			if ((!(monitor_mode == MONITOR_TRACKING_G)) && t->m != m)
 				continue;
 
-			SendConfig(mod,M_CONFIGURE_WINDOW,t);
-			SendName(
-				mod, M_WINDOW_NAME, FW_W(t), FW_W_FRAME(t),
-				(unsigned long)t, t->name.name);
-			SendName(
-				mod, M_ICON_NAME, FW_W(t), FW_W_FRAME(t),
-				(unsigned long)t, t->icon_name.name);
-			SendName(
-				mod, M_VISIBLE_NAME, FW_W(t), FW_W_FRAME(t),
-				(unsigned long)t, t->visible_name);
-			SendName(
-				mod, MX_VISIBLE_ICON_NAME, FW_W(t), FW_W_FRAME(t),
-				(unsigned long)t,t->visible_icon_name);
-			if (t->icon_bitmap_file != NULL
-			    && t->icon_bitmap_file != Scr.DefaultIcon)
-			{
-				SendName(
-					mod, M_ICON_FILE, FW_W(t), FW_W_FRAME(t),
-					(unsigned long)t, t->icon_bitmap_file);
-			}
-
-			SendName(
-				mod, M_RES_CLASS, FW_W(t), FW_W_FRAME(t),
-				(unsigned long)t, t->class.res_class);
-			SendName(
-				mod, M_RES_NAME, FW_W(t), FW_W_FRAME(t),
-				(unsigned long)t, t->class.res_name);
-
-			if (IS_ICONIFIED(t) && !IS_ICON_UNMAPPED(t))
-			{
-				rectangle r;
-				Bool rc;
-
-				rc = get_visible_icon_geometry(t, &r);
-				if (rc == True)
-				{
-					SendPacket(
-						mod, M_ICONIFY, 7, (long)FW_W(t),
-						(long)FW_W_FRAME(t), (unsigned long)t,
-						(long)r.x, (long)r.y,
-						(long)r.width, (long)r.height);
-				}
-			}
-			if ((IS_ICONIFIED(t))&&(IS_ICON_UNMAPPED(t)))
-			{
-				SendPacket(
-					mod, M_ICONIFY, 7, (long)FW_W(t),
-					(long)FW_W_FRAME(t), (unsigned long)t,
-					(long)0, (long)0, (long)0, (long)0);
-			}
-			if (FMiniIconsSupported && t->mini_icon != NULL)
-			{
-				SendFvwmPicture(
-					mod, M_MINI_ICON, FW_W(t), FW_W_FRAME(t),
-					(unsigned long)t, t->mini_icon,
-					t->mini_pixmap_file);
-			}
+			module_filter_prepare_window(mod, t);
+			SendWindowInfo(mod, t);
+		}
+		if (do_snapshot)
+		{
+			module_snapshot_send();
 		}
 
 		if (Scr.Hilite == NULL)
@@ -33,6 +33,12 @@ void SendConfig(
 void SendName(
 	struct fmodule *module, unsigned long event_type, unsigned long data1,
 	unsigned long data2, unsigned long data3, const char *name);
+void SendWindowInfo(struct fmodule *module, FvwmWindow *t);
+/* Collect the packets sent to the module until module_snapshot_send() and
+ * then send them as a snapshot (see MX_WINDOW_SNAPSHOT in libs/Module.h)
+ * in packets of the given type. */
+void module_snapshot_begin(struct fmodule *module, unsigned long type);
+void module_snapshot_send(void);
 
 
 /* command queue - module input */
@@ -19,6 +19,8 @@
 #ifdef HAVE_FCNTL_H
 #include <fcntl.h>
 #endif
+#include <sys/uio.h>
+#include <time.h>
 
 /* for F_CMD_ARGS */
 #include "fvwm/fvwm.h"
@@ -48,8 +50,10 @@
 #include "libs/Strings.h"
 #include "libs/wild.h"
 #include "libs/fvwmsignal.h"
+#include "libs/fpoll.h"
 #include "events.h"
 #include "bindings.h"
+#include "conditional.h"
 
 /* for positive write */
 
@@ -65,11 +69,53 @@
 
 #define MOD_NOGRABMASK(m) ((m)->xNoGrabMask)
 #define MOD_SYNCMASK(m) ((m)->xSyncMask)
-
+#define MOD_COALESCEMASK(m) ((m)->xCoalesceMask)
+
+#define MQUEUE_MIN_SIZE 16
+#define MQUEUE_IS_EMPTY(m) (MOD_PIPEQUEUE(m).count == 0)
+
+/* most packets written with a single writev() */
+#define MQUEUE_MAX_IOV 64
+/* used if the size of the pipe buffer is unknown */
+#define MQUEUE_DEFAULT_PIPE_SIZE 4096
+/* milliseconds between redraws while a command waits for a module */
+#define MQUEUE_SYNC_SLICE 20
+/* messages that only describe the current state of a window, so an older
+ * one is useless once a newer one is queued; see set_coalesce_mask */
+#define MQUEUE_COALESCE_M1 \
+	(M_CONFIGURE_WINDOW | M_WINDOW_NAME | M_ICON_NAME | M_VISIBLE_NAME | \
+	 M_RES_CLASS | M_RES_NAME | M_MINI_ICON | M_FOCUS_CHANGE)
+#define MQUEUE_COALESCE_M2 (MX_VISIBLE_ICON_NAME & ~M_EXTENDED_MSG)
+/* messages about a single window, with the client and the frame window in
+ * the first two words of the body; see set_filter */
+#define MQUEUE_FILTER_M1 \
+	(M_ADD_WINDOW | M_CONFIGURE_WINDOW | M_DESTROY_WINDOW | \
+	 M_RAISE_WINDOW | M_LOWER_WINDOW | M_MAP | M_ICONIFY | M_DEICONIFY | \
+	 M_ICON_LOCATION | M_WINDOW_NAME | M_ICON_NAME | M_VISIBLE_NAME | \
+	 M_RES_CLASS | M_RES_NAME | M_ICON_FILE | M_MINI_ICON | \
+	 M_WINDOWSHADE | M_DEWINDOWSHADE)
+#define MQUEUE_FILTER_M2 (MX_VISIBLE_ICON_NAME & ~M_EXTENDED_MSG)
+/* the data of the windows in MOD_FILTER_WINDOWS, i.e. of the windows the
+ * module has been told about */
+#define FILTER_WIN_NOT_MATCHING ((void *)0)
+#define FILTER_WIN_MATCHING ((void *)1)
+
+/* An immutable packet.  A broadcast packet is copied only once and shared
+ * by the queues of all modules it is sent to. */
 typedef struct
 {
-	unsigned long *data;
+	int refcount;
 	int size;
+	/* when the packet was queued, on the monotonic clock */
+	struct timespec time;
+	unsigned long *data;
+} mqueue_packet_type;
+
+typedef struct fmodule_queue_entry
+{
+	/* NULL if the packet has been replaced by a newer one */
+	mqueue_packet_type *packet;
+	/* number of bytes already written */
 	int done;
 } mqueue_object_type;
 
@@ -94,7 +140,25 @@ static inline void module_list_destroy(fmodule_list *list);
 
 static void KillModuleByName(char *name, char *alias);
 static char *get_pipe_name(fmodule *module);
+static mqueue_packet_type *create_message_packet(
+	unsigned long *ptr, int size);
+static void release_message_packet(mqueue_packet_type *packet);
+static void add_to_message_queue(fmodule *module, mqueue_packet_type *packet);
 static void DeleteMessageQueueBuff(fmodule *module);
+static mqueue_object_type *get_message_queue_first(fmodule *module);
+static void coalesce_message_queue(fmodule *module, unsigned long *ptr);
+static int module_queue_age(fmodule *module);
+static void module_check_lag(fmodule *module);
+static const char *module_transport_name(fmodule *module);
+static void module_free_filter(fmodule *module);
+static Bool module_is_alive(fmodule *module);
+static void module_sync_wait(fmodule *module, unsigned long *ptr);
+static void module_update_write_interest(fmodule *module);
+static void module_park(fmodule *module);
+static Bool module_wait_fd(fmodule *module, int fd, int events);
+static Bool module_ring_flush(fmodule *module, Bool do_block);
+static ssize_t write_message_queue_batch(fmodule *module);
+static Bool flush_message_queue(fmodule *module, Bool do_block);
 
 static inline void msg_mask_set(
 	msg_masks_t *msg_mask, unsigned long m1, unsigned long m2);
@@ -114,12 +178,34 @@ static fmodule *module_alloc(void)
 
 	module = fxmalloc(sizeof(fmodule));
 	MOD_SET_CMDLINE(module, 0);
+	MOD_SET_RING_ACTIVE(module, 0);
+	MOD_SET_PARKED(module, 0);
+	MOD_SET_LAG_REPORTED(module, 0);
+	MOD_PID(module) = 0;
 	MOD_READFD(module) = -1;
 	MOD_WRITEFD(module) = -1;
-	fqueue_init(&MOD_PIPEQUEUE(module));
+	MOD_PIPESIZE(module) = MQUEUE_DEFAULT_PIPE_SIZE;
+	memset(&MOD_PIPEQUEUE(module), 0, sizeof(fmodule_queue));
+	MOD_PARKTIME(module) = 0;
+	MOD_SYSCALLS_SAVED(module) = 0;
+	MOD_QUEUED_BYTES(module) = 0;
+	MOD_PACKETS_SENT(module) = 0;
+	MOD_BYTES_SENT(module) = 0;
+	MOD_COALESCED(module) = 0;
+	MOD_FILTER(module) = NULL;
+	MOD_FILTER_STRING(module) = NULL;
+	MOD_FILTER_WINDOWS(module) = NULL;
+	MOD_FILTERED(module) = 0;
+	MOD_SYNC_SENT(module) = 0;
+	MOD_SYNC_ACKED(module) = 0;
+	MOD_SYNC_TIMEOUT(module) = 0;
+	MOD_SYNC_WAIT_TOTAL(module) = 0;
+	MOD_SYNC_WAIT_MAX(module) = 0;
+	MOD_RING(module) = NULL;
 	msg_mask_set(&MOD_PIPEMASK(module), DEFAULT_MASK, DEFAULT_MASK);
 	msg_mask_set(&MOD_NOGRABMASK(module), 0, 0);
 	msg_mask_set(&MOD_SYNCMASK(module), 0, 0);
+	msg_mask_set(&MOD_COALESCEMASK(module), 0, 0);
 	MOD_NAME(module) = NULL;
 	MOD_ALIAS(module) = NULL;
 
@@ -133,8 +219,20 @@ static void module_free(fmodule *module)
 	{
 		return;
 	}
-	close(MOD_WRITEFD(module));
+	fpoll_remove(MOD_WRITEFD(module));
+	fpoll_remove(MOD_READFD(module));
+	if (MOD_RING(module) != NULL)
+	{
+		fpoll_remove(fring_get_space_fd(MOD_RING(module)));
+	}
+	/* with the ring, the write descriptor is the ring's doorbell */
+	if (!MOD_IS_RING_ACTIVE(module))
+	{
+		close(MOD_WRITEFD(module));
+	}
 	close(MOD_READFD(module));
+	/* tells the module that fvwm has gone */
+	fring_destroy(MOD_RING(module));
 
 	if (MOD_NAME(module) != NULL)
 	{
@@ -144,10 +242,15 @@ static void module_free(fmodule *module)
 	{
 		free(MOD_ALIAS(module));
 	}
-	while (!FQUEUE_IS_EMPTY(&(MOD_PIPEQUEUE(module))))
+	module_free_filter(module);
+	while (!MQUEUE_IS_EMPTY(module))
 	{
 		DeleteMessageQueueBuff(module);
 	}
+	if (MOD_PIPEQUEUE(module).entries != NULL)
+	{
+		free(MOD_PIPEQUEUE(module).entries);
+	}
 	free(module);
 
 	return;
@@ -308,15 +411,14 @@ static fmodule *do_execute_module(
 		goto err_exit;
 	}
 	if (
-		fvwm_to_app[0] >= fvwmlib_max_fd ||
-		fvwm_to_app[1] >= fvwmlib_max_fd ||
-		app_to_fvwm[0] >= fvwmlib_max_fd ||
-		app_to_fvwm[1] >= fvwmlib_max_fd)
+		fvwm_to_app[0] >= fpoll_get_max_fd() ||
+		fvwm_to_app[1] >= fpoll_get_max_fd() ||
+		app_to_fvwm[0] >= fpoll_get_max_fd() ||
+		app_to_fvwm[1] >= fpoll_get_max_fd())
 	{
 		fvwm_msg(ERR, "executeModule", "too many open fds");
 		goto err_exit;
 	}
-
 	/* all ok, create the space and fill up */
 	module = module_alloc();
 
@@ -367,6 +469,7 @@ static fmodule *do_execute_module(
 		close(fvwm_to_app[0]);
 
 		/* add these pipes to fvwm's active pipe list */
+		MOD_PID(module) = val;
 		MOD_WRITEFD(module) = fvwm_to_app[1];
 		MOD_READFD(module) = app_to_fvwm[0];
 		msg_mask_set(
@@ -384,6 +487,18 @@ static fmodule *do_execute_module(
 		if (MOD_WRITEFD(module) >= 0)
 		{
 			fcntl(MOD_WRITEFD(module), F_SETFL, O_NONBLOCK);
+#ifdef F_GETPIPE_SZ
+			{
+				int pipe_size;
+
+				pipe_size = fcntl(
+					MOD_WRITEFD(module), F_GETPIPE_SZ);
+				if (pipe_size > 0)
+				{
+					MOD_PIPESIZE(module) = pipe_size;
+				}
+			}
+#endif
 		}
 		/* Mark the pipes close-on exec so other programs
 		 * won`t inherit them */
@@ -403,6 +518,9 @@ static fmodule *do_execute_module(
 		}
 		/* module struct is completed, insert into the list */
 		module_list_insert(module, &module_list);
+		/* The write pipe is only watched while there is something
+		 * in the queue, see module_update_write_interest(). */
+		fpoll_add(MOD_READFD(module), FPOLL_IN, module);
 
 		for (i = 6; i < nargs; i++)
 		{
@@ -507,6 +625,14 @@ fmodule *executeModuleDesperate(F_CMD_ARGS)
 
 void module_kill(fmodule *module)
 {
+	/* stop watching the pipes; pending events from the main loop are
+	 * dropped because the descriptors are no longer registered */
+	fpoll_remove(MOD_WRITEFD(module));
+	fpoll_remove(MOD_READFD(module));
+	if (MOD_RING(module) != NULL)
+	{
+		fpoll_remove(fring_get_space_fd(MOD_RING(module)));
+	}
 	module_list_insert(
 		module_list_remove(module, &module_list), &death_row);
 
@@ -521,13 +647,145 @@ void module_cleanup(void)
 	return;
 }
 
+/* Returns True while the module has not been killed. */
+static Bool module_is_alive(fmodule *module)
+{
+	return (fpoll_get_data(MOD_READFD(module)) == module);
+}
+
+/* Waits until the module has answered the sync mask packet ptr that has
+ * just been queued.  The packet is in one of three states: queued, sent and
+ * waiting for the answer, answered.  Only the command that sent the packet
+ * is held up; the commands the module sends meanwhile are executed at once,
+ * and expose events are handled so that fvwm keeps drawing.  Every other
+ * event and the input of other modules wait until the command continues,
+ * as they did before.  The answers are counted, so a packet sent to the
+ * same module by one of these commands is answered in turn.  If the module
+ * has a deadline (set_sync_timeout) the command continues when it is over;
+ * otherwise the module is killed after ModuleTimeout seconds.  The time is
+ * added to the module's statistics. */
+static void module_sync_wait(fmodule *module, unsigned long *ptr)
+{
+	extern int moduleTimeout;
+	extern int moduleWarnTimeout;
+	unsigned long ticket;
+	int timeout_ms;
+	int elapsed_ms = 0;
+	Bool is_reported = False;
+	struct timespec start;
+	struct timespec now;
+
+	ticket = ++MOD_SYNC_SENT(module);
+	/* the module must have the packet before we wait for it */
+	if (!flush_message_queue(module, True))
+	{
+		return;
+	}
+	timeout_ms = (MOD_SYNC_TIMEOUT(module) > 0) ?
+		MOD_SYNC_TIMEOUT(module) : moduleTimeout * 1000;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	while (MOD_SYNC_ACKED(module) < ticket)
+	{
+		int wait_ms;
+		int rc;
+
+		handle_all_expose();
+		if (isTerminated || !module_is_alive(module))
+		{
+			break;
+		}
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		elapsed_ms = (now.tv_sec - start.tv_sec) * 1000 +
+			(now.tv_nsec - start.tv_nsec) / 1000000;
+		if (elapsed_ms >= timeout_ms)
+		{
+			if (MOD_SYNC_TIMEOUT(module) > 0)
+			{
+				fvwm_msg(
+					WARN, "PositiveWrite",
+					"Module '%s' did not answer within"
+					" %d ms, continuing", get_pipe_name(
+						module), timeout_ms);
+
+				break;
+			}
+			/* Doh! Something has gone wrong - get rid of the
+			 * offender! */
+			fvwm_msg(
+				ERR, "PositiveWrite",
+				"Module '%s' did not answer within %d seconds",
+				get_pipe_name(module), moduleTimeout);
+			module_kill(module);
+
+			break;
+		}
+		if (
+			!is_reported && moduleWarnTimeout > 0 &&
+			elapsed_ms >= moduleWarnTimeout * 1000)
+		{
+			fvwm_msg(
+				WARN, "PositiveWrite",
+				"Module '%s' has not answered for %d ms",
+				get_pipe_name(module), elapsed_ms);
+			is_reported = True;
+		}
+		wait_ms = timeout_ms - elapsed_ms;
+		if (wait_ms > MQUEUE_SYNC_SLICE)
+		{
+			wait_ms = MQUEUE_SYNC_SLICE;
+		}
+		rc = fpoll_wait_fd(MOD_READFD(module), FPOLL_IN, wait_ms);
+		if (rc > 0)
+		{
+			fmodule_input *input;
+
+			/* module_receive() counts the answer */
+			input = module_receive(module);
+			if (
+				input == NULL ||
+				module_input_expect(
+					input, ModuleUnlockResponse))
+			{
+				module_input_discard(input);
+			}
+			else
+			{
+				/* N.B. This may send another sync packet to
+				 * this module; that packet is answered
+				 * after ours. */
+				module_input_execute(input);
+			}
+		}
+		else if (rc < 0 && errno != EINTR)
+		{
+			module_kill(module);
+
+			break;
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	elapsed_ms = (now.tv_sec - start.tv_sec) * 1000 +
+		(now.tv_nsec - start.tv_nsec) / 1000000;
+	MOD_SYNC_WAIT_TOTAL(module) += elapsed_ms;
+	if (elapsed_ms > MOD_SYNC_WAIT_MAX(module))
+	{
+		MOD_SYNC_WAIT_MAX(module) = elapsed_ms;
+	}
+
+	return;
+}
+
 /* void module_send(fmodule *module, unsigned long *ptr, int size) */
 /* This used to be marked "fvwm_inline".  I removed this
    when I added the lockonsend logic.  The routine seems too big to
    want to inline.  dje 9/4/98 */
 extern int myxgrabcount;                /* defined in libs/Grab.c */
 extern char *ModuleUnlock;              /* defined in libs/Module.c */
-void PositiveWrite(fmodule *module, unsigned long *ptr, int size)
+/* If shared is not NULL, the packet in *shared is queued instead of a copy
+ * of the data; it is created on first use. */
+static void positive_write(
+	fmodule *module, unsigned long *ptr, int size,
+	mqueue_packet_type **shared)
 {
 	extern int moduleTimeout;
 	msg_masks_t mask;
@@ -544,6 +802,10 @@ void PositiveWrite(fmodule *module, unsigned long *ptr, int size)
 	{
 		return;
 	}
+	if (!module_filter_packet(module, ptr))
+	{
+		return;
+	}
 
 	/* a dirty hack to prevent FvwmAnimate triggering during Recapture */
 	/* would be better to send RecaptureStart and RecaptureEnd messages. */
@@ -555,24 +817,58 @@ void PositiveWrite(fmodule *module, unsigned long *ptr, int size)
 	{
 		return;
 	}
+	/* a module that has not read anything for so long is dead or hung;
+	 * do not let its queue grow without bounds */
+	if (
+		MOD_IS_PARKED(module) &&
+		difftime(time(NULL), MOD_PARKTIME(module)) >= moduleTimeout)
+	{
+		fvwm_msg(
+			ERR, "PositiveWrite",
+			"Module '%s' has not read any packets for %d seconds",
+			get_pipe_name(module), moduleTimeout);
+		module_kill(module);
 
+		return;
+	}
+
+	if (
+		MOD_IS_RING_ACTIVE(module) && MQUEUE_IS_EMPTY(module) &&
+		fring_write(MOD_RING(module), ptr, size))
+	{
+		/* written straight into the ring, the module is woken up by
+		 * FlushMessageQueue() */
+		MOD_SYSCALLS_SAVED(module)++;
+		MOD_PACKETS_SENT(module)++;
+		MOD_BYTES_SENT(module) += size;
+		module_update_write_interest(module);
+	}
 	/* DV: This was once the AddToMessageQueue function.  Since it was only
 	 * called once, put it in here for better performance. */
+	else
 	{
-		mqueue_object_type *c;
+		mqueue_packet_type *packet;
 
-		c = (mqueue_object_type *)malloc(
-			sizeof(mqueue_object_type) + size);
-		if (c == NULL)
+		if (IS_MESSAGE_IN_MASK(&(MOD_COALESCEMASK(module)), ptr[1]))
+		{
+			coalesce_message_queue(module, ptr);
+		}
+		if (shared == NULL)
 		{
-			fvwm_msg(ERR, "PositiveWrite", "malloc failed\n");
-			exit(1);
+			packet = create_message_packet(ptr, size);
+			add_to_message_queue(module, packet);
+			release_message_packet(packet);
 		}
-		c->size = size;
-		c->done = 0;
-		c->data = (unsigned long *)(c + 1);
-		memcpy((void*)c->data, (const void*)ptr, size);
-		fqueue_add_at_end(&(MOD_PIPEQUEUE(module)), c);
+		else
+		{
+			if (*shared == NULL)
+			{
+				*shared = create_message_packet(ptr, size);
+			}
+			add_to_message_queue(module, *shared);
+		}
+		module_update_write_interest(module);
+		module_check_lag(module);
 	}
 
 	/* dje, from afterstep, for FvwmAnimate, allows modules to sync with
@@ -590,102 +886,109 @@ void PositiveWrite(fmodule *module, unsigned long *ptr, int size)
 		IS_MESSAGE_IN_MASK(
 			&(MOD_SYNCMASK(module)), ptr[1]) && !myxgrabcount)
 	{
-		fd_set readSet;
-		int channel = MOD_READFD(module);
-		struct timeval timeout;
-		Bool done = False;
-		fmodule_input *input;
+		module_sync_wait(module, ptr);
+	}
 
-		FlushMessageQueue(module);
+	return;
+}
+
+void PositiveWrite(fmodule *module, unsigned long *ptr, int size)
+{
+	positive_write(module, ptr, size, NULL);
+
+	return;
+}
+
+Bool module_filter_packet(fmodule *module, unsigned long *ptr)
+{
+	static const msg_masks_t filtered = {
+		MQUEUE_FILTER_M1, MQUEUE_FILTER_M2
+	};
+	wintable_t *table = MOD_FILTER_WINDOWS(module);
+	FvwmWindow *fw;
+	void *data = FILTER_WIN_NOT_MATCHING;
+	Bool is_known;
 
-		while (!done)
+	if (
+		MOD_FILTER(module) == NULL ||
+		!IS_MESSAGE_IN_MASK(&filtered, ptr[1]) ||
+		ptr[2] < FvwmPacketHeaderSize + 2)
+	{
+		return True;
+	}
+	is_known = wintable_find(table, (Window)ptr[4], &data);
+	if (ptr[1] == M_DESTROY_WINDOW)
+	{
+		/* even if the window no longer matches */
+		wintable_remove(table, (Window)ptr[4]);
+		return is_known;
+	}
+	/* the frame is still known when the client has gone */
+	if (
+		!wintable_find(FvwmWindowTable, (Window)ptr[5], (void **)&fw) ||
+		FW_W(fw) != (Window)ptr[4])
+	{
+		/* can not tell */
+		wintable_insert(table, (Window)ptr[4], FILTER_WIN_MATCHING);
+		return True;
+	}
+	if (MatchesConditionMask(fw, MOD_FILTER(module)))
+	{
+		if (data == FILTER_WIN_MATCHING)
 		{
-			int rc = 0;
-			/*
-			 * We give the read a long timeout; if the module
-			 * fails to respond within this time then it deserves
-			 * to be KILLED!
-			 *
-			 * NOTE: rather than impose an arbitrary timeout on the
-			 * user, we will make this a configuration parameter.
-			 */
-			do
-			{
-				timeout.tv_sec = moduleTimeout;
-				timeout.tv_usec = 0;
-				FD_ZERO(&readSet);
-				FD_SET(channel, &readSet);
-
-				/* Wait for input to arrive on just one
-				 * descriptor, with a timeout (fvwmSelect <= 0)
-				 * or read() returning wrong size is bad news
-				 */
-				rc = fvwmSelect(
-					channel + 1, &readSet, NULL, NULL,
-					&timeout);
-				/* retry if select() failed with EINTR */
-			} while (rc < 0 && !isTerminated && (errno == EINTR));
-
-			if ( isTerminated )
-			{
-				break;
-			}
+			return True;
+		}
+		wintable_insert(table, (Window)ptr[4], FILTER_WIN_MATCHING);
+		if (ptr[1] != M_ADD_WINDOW)
+		{
+			/* The window has just started to match.  The module
+			 * has missed its names and icons (or never heard of
+			 * it), so send everything first.  After M_ADD_WINDOW
+			 * they follow anyway. */
+			SendWindowInfo(module, fw);
+		}
+		return True;
+	}
+	if (data == FILTER_WIN_MATCHING)
+	{
+		/* one more message so that the module learns the window no
+		 * longer matches, e.g. that it is now on another desk */
+		wintable_insert(table, (Window)ptr[4], FILTER_WIN_NOT_MATCHING);
+		return True;
+	}
+	MOD_FILTERED(module)++;
 
-			if (rc > 0)
-			{
-				input = module_receive(module);
-				if (
-					input == NULL ||
-					module_input_expect(input,
-						ModuleUnlockResponse))
-				{
-					module_input_discard(input);
-					done = True;
-				}
-				else
-				{
-					module_input_execute(input);
-				}
+	return False;
+}
 
-			}
-			else
-			{
-				char *name;
-
-				name = get_pipe_name(module);
-				/* Doh! Something has gone wrong - get rid of
-				 * the offender! */
-				fvwm_msg(ERR, "PositiveWrite",
-					 "Failed to read descriptor from"
-					 " '%s':\n"
-					 "- data available=%c\n"
-					 "- terminate signal=%c\n",
-					 name,
-					 (FD_ISSET(channel, &readSet) ?
-					  'Y' : 'N'),
-					 isTerminated ? 'Y' : 'N');
-				module_kill(module);
-				break;
-			}
+void module_filter_prepare_window(fmodule *module, FvwmWindow *fw)
+{
+	if (
+		MOD_FILTER(module) != NULL &&
+		MatchesConditionMask(fw, MOD_FILTER(module)))
+	{
+		wintable_insert(
+			MOD_FILTER_WINDOWS(module), FW_W(fw),
+			FILTER_WIN_MATCHING);
+	}
 
+	return;
+}
 
-			/* Execute all messages from the module until UNLOCK is
-			 * received N.B. This may cause recursion if a command
-			 * results in a sync message to another module, which
-			 * in turn may send a command that results in another
-			 * sync message to this module.
-			 * Hippo: I don't think this will cause deadlocks, but
-			 * the third time we get here the first times UNLOCK
-			 * will be read and then on returning up the third
-			 * level UNLOCK will be read at the first level. This
-			 * could be difficult to fix without turning queueing
-			 * on.  Turning queueing on may be bad because it can
-			 * be useful for modules to be able to inject commands
-			 * from modules in a synchronous manner. e.g.
-			 * FvwmIconMan can tell FvwmAnimate to do an animation
-			 * when a window is de-iconified from the IconMan,
-			 * queueing make s this happen too late. */
-		}
+void module_broadcast(unsigned long *ptr, int size)
+{
+	fmodule_list_itr moditr;
+	fmodule *module;
+	mqueue_packet_type *packet = NULL;
+
+	module_list_itr_init(&moditr);
+	while ( (module = module_list_itr_next(&moditr)) != NULL)
+	{
+		positive_write(module, ptr, size, &packet);
+	}
+	if (packet != NULL)
+	{
+		release_message_packet(packet);
 	}
 
 	return;
@@ -759,6 +1062,14 @@ fmodule_input *module_receive(fmodule *module)
 		 * so let's not complain */
 		module_kill(module);
 	}
+	/* modules also send an unlock when nothing waits for it, e.g. at
+	 * startup */
+	if (
+		MOD_SYNC_ACKED(module) < MOD_SYNC_SENT(module) &&
+		module_input_expect(input, ModuleUnlockResponse))
+	{
+		MOD_SYNC_ACKED(module)++;
+	}
 
 	return input;
 err:
@@ -928,111 +1239,496 @@ static void set_message_mask(msg_masks_t *mask, unsigned long msg)
 
 /* message queues */
 
+/* Returns True if there are queued packets or packets in the ring the module
+ * has not been told about yet. */
+static Bool module_has_pending_output(fmodule *module)
+{
+	if (!MQUEUE_IS_EMPTY(module))
+	{
+		return True;
+	}
+	if (
+		MOD_IS_RING_ACTIVE(module) &&
+		fring_has_unsignalled(MOD_RING(module)))
+	{
+		return True;
+	}
+
+	return False;
+}
+
+/* Watch the module's write pipe in the main loop only while there are queued
+ * packets.  A pipe is almost always writable, so keeping it registered all
+ * the time would make the main loop spin.  With the ring, the doorbell
+ * descriptor is watched instead; it is always writable.  While the ring is
+ * full, the descriptor that reports free space is watched in its place. */
+static void module_update_write_interest(fmodule *module)
+{
+	Bool is_watched;
+	Bool needs_watch;
+
+	if (MOD_WRITEFD(module) < 0)
+	{
+		return;
+	}
+	if (MOD_IS_RING_ACTIVE(module))
+	{
+		int space_fd = fring_get_space_fd(MOD_RING(module));
+
+		is_watched = (fpoll_get_data(space_fd) != NULL);
+		needs_watch = MOD_IS_PARKED(module);
+		if (needs_watch && !is_watched)
+		{
+			fpoll_add(space_fd, FPOLL_IN, module);
+		}
+		else if (!needs_watch && is_watched)
+		{
+			fpoll_remove(space_fd);
+		}
+	}
+	is_watched = (fpoll_get_data(MOD_WRITEFD(module)) != NULL);
+	needs_watch =
+		module_has_pending_output(module) &&
+		!(MOD_IS_RING_ACTIVE(module) && MOD_IS_PARKED(module));
+	if (needs_watch && !is_watched)
+	{
+		fpoll_add(MOD_WRITEFD(module), FPOLL_OUT, module);
+	}
+	else if (!needs_watch && is_watched)
+	{
+		fpoll_remove(MOD_WRITEFD(module));
+	}
+
+	return;
+}
+
+static mqueue_packet_type *create_message_packet(
+	unsigned long *ptr, int size)
+{
+	mqueue_packet_type *packet;
+
+	/* the data is in the same malloced block as the packet */
+	packet = fxmalloc(sizeof(mqueue_packet_type) + size);
+	packet->refcount = 1;
+	packet->size = size;
+	clock_gettime(CLOCK_MONOTONIC, &packet->time);
+	packet->data = (unsigned long *)(packet + 1);
+	memcpy((void *)packet->data, (const void *)ptr, size);
+
+	return packet;
+}
+
+static void release_message_packet(mqueue_packet_type *packet)
+{
+	packet->refcount--;
+	if (packet->refcount == 0)
+	{
+		free(packet);
+	}
+
+	return;
+}
+
+static void add_to_message_queue(fmodule *module, mqueue_packet_type *packet)
+{
+	fmodule_queue *queue = &MOD_PIPEQUEUE(module);
+	mqueue_object_type *obj;
+
+	if (queue->count == queue->size)
+	{
+		mqueue_object_type *entries;
+		int size;
+		int i;
+
+		size = (queue->size == 0) ? MQUEUE_MIN_SIZE : 2 * queue->size;
+		entries = fxmalloc(size * sizeof(mqueue_object_type));
+		for (i = 0; i < queue->count; i++)
+		{
+			entries[i] = queue->entries[
+				(queue->first + i) & (queue->size - 1)];
+		}
+		if (queue->entries != NULL)
+		{
+			free(queue->entries);
+		}
+		queue->entries = entries;
+		queue->size = size;
+		queue->first = 0;
+	}
+	obj = &queue->entries[(queue->first + queue->count) & (queue->size - 1)];
+	obj->packet = packet;
+	obj->done = 0;
+	packet->refcount++;
+	queue->count++;
+	MOD_QUEUED_BYTES(module) += packet->size;
+
+	return;
+}
+
+/* Returns the first packet that has not been replaced by a newer one. */
+static mqueue_object_type *get_message_queue_first(fmodule *module)
+{
+	fmodule_queue *queue = &MOD_PIPEQUEUE(module);
+
+	while (queue->count > 0 && queue->entries[queue->first].packet == NULL)
+	{
+		DeleteMessageQueueBuff(module);
+	}
+	if (queue->count == 0)
+	{
+		return NULL;
+	}
+
+	return &queue->entries[queue->first];
+}
+
 static void DeleteMessageQueueBuff(fmodule *module)
+{
+	fmodule_queue *queue = &MOD_PIPEQUEUE(module);
+
+	if (queue->count == 0)
+	{
+		return;
+	}
+	if (queue->entries[queue->first].packet != NULL)
+	{
+		mqueue_object_type *obj = &queue->entries[queue->first];
+
+		MOD_QUEUED_BYTES(module) -= obj->packet->size - obj->done;
+		release_message_packet(obj->packet);
+	}
+	queue->first = (queue->first + 1) & (queue->size - 1);
+	queue->count--;
+	if (queue->count == 0)
+	{
+		/* caught up */
+		MOD_SET_LAG_REPORTED(module, 0);
+	}
+	if (queue->count == 0 && queue->size > 4 * MQUEUE_MIN_SIZE)
+	{
+		/* give back the memory after a burst */
+		free(queue->entries);
+		queue->entries = NULL;
+		queue->size = 0;
+		queue->first = 0;
+	}
+
+	return;
+}
+
+/* Drops the queued packet that the packet ptr supersedes: the last one of
+ * the same type for the same window, or of any window for focus changes.
+ * The queue does not hold more than one such packet per window and type,
+ * but the search still walks the whole queue if there is none, so it costs
+ * as much as the module lags behind.  Packets that have been written
+ * partially are kept.  The entry is left in place as a hole so the ring
+ * buffer need not be moved. */
+static void coalesce_message_queue(fmodule *module, unsigned long *ptr)
+{
+	fmodule_queue *queue = &MOD_PIPEQUEUE(module);
+	int i;
+
+	for (i = queue->count - 1; i >= 0; i--)
+	{
+		mqueue_object_type *obj;
+		unsigned long *data;
+
+		obj = &queue->entries[(queue->first + i) & (queue->size - 1)];
+		if (obj->packet == NULL || obj->done > 0)
+		{
+			continue;
+		}
+		data = obj->packet->data;
+		if (data[1] != ptr[1])
+		{
+			continue;
+		}
+		if (
+			ptr[1] != M_FOCUS_CHANGE &&
+			data[FvwmPacketHeaderSize] != ptr[FvwmPacketHeaderSize])
+		{
+			continue;
+		}
+		MOD_QUEUED_BYTES(module) -= obj->packet->size;
+		release_message_packet(obj->packet);
+		obj->packet = NULL;
+		MOD_COALESCED(module)++;
+
+		return;
+	}
+
+	return;
+}
+
+/* Remembers when the module stopped taking packets.  The main loop flushes
+ * the queue again when the pipe or ring has room. */
+static void module_park(fmodule *module)
+{
+	if (!MOD_IS_PARKED(module))
+	{
+		MOD_SET_PARKED(module, 1);
+		MOD_PARKTIME(module) = time(NULL);
+	}
+
+	return;
+}
+
+/* Returns how many milliseconds the oldest queued packet has waited. */
+static int module_queue_age(fmodule *module)
 {
 	mqueue_object_type *obj;
+	struct timespec now;
+
+	obj = get_message_queue_first(module);
+	if (obj == NULL)
+	{
+		return 0;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (now.tv_sec - obj->packet->time.tv_sec) * 1000 +
+		(now.tv_nsec - obj->packet->time.tv_nsec) / 1000000;
+}
+
+/* Warns once when a module falls behind by more than the soft limits given
+ * to ModuleTimeout, long before it would be killed.  It is warned about
+ * again after it has caught up. */
+static void module_check_lag(fmodule *module)
+{
+	extern int moduleWarnTimeout;
+	extern int moduleWarnQueueSize;
+	int age;
 
-	if (fqueue_get_first(&(MOD_PIPEQUEUE(module)), (void **)&obj) == 1)
+	if (MOD_IS_LAG_REPORTED(module))
+	{
+		return;
+	}
+	if (
+		moduleWarnQueueSize > 0 &&
+		MOD_QUEUED_BYTES(module) >= moduleWarnQueueSize)
+	{
+		fvwm_msg(
+			WARN, "PositiveWrite",
+			"Module '%s' lags behind by %d bytes",
+			get_pipe_name(module), MOD_QUEUED_BYTES(module));
+		MOD_SET_LAG_REPORTED(module, 1);
+	}
+	else if (
+		moduleWarnTimeout > 0 &&
+		(age = module_queue_age(module)) >= moduleWarnTimeout * 1000)
 	{
-		/* remove from queue */
-		fqueue_remove_or_operate_from_front(
-			&(MOD_PIPEQUEUE(module)), NULL, NULL, NULL, NULL);
-		/* we don't need to free the obj->data here because it's in the
-		 * same malloced block as the obj itself. */
-		free(obj);
+		fvwm_msg(
+			WARN, "PositiveWrite",
+			"Module '%s' has not read packets for %d ms",
+			get_pipe_name(module), age);
+		MOD_SET_LAG_REPORTED(module, 1);
 	}
 
 	return;
 }
 
-void FlushMessageQueue(fmodule *module)
+/* Waits until descriptor fd is ready for the events; kills the module if it
+ * does not get ready within moduleTimeout seconds.  Returns False if the
+ * module has been killed or fvwm is terminating. */
+static Bool module_wait_fd(fmodule *module, int fd, int events)
 {
 	extern int moduleTimeout;
+	int rc = 0;
+
+	do
+	{
+		rc = fpoll_wait_fd(fd, events, moduleTimeout * 1000);
+		/* retry if select() failed with EINTR */
+	} while ((rc < 0) && !isTerminated && (errno == EINTR));
+	if (isTerminated)
+	{
+		return False;
+	}
+	if (rc <= 0)
+	{
+		/* Doh! Something has gone wrong - get rid of the offender! */
+		fvwm_msg(
+			ERR, "FlushMessageQueue",
+			"Failed to write descriptor to '%s':\n"
+			"- select rc=%d\n"
+			"- terminate signal=%c\n",
+			get_pipe_name(module), rc, isTerminated ? 'Y' : 'N');
+		module_kill(module);
+
+		return False;
+	}
+
+	return True;
+}
+
+/* Moves the queued packets into the ring and wakes up the module.  If the
+ * ring is full, the module is parked unless do_block is set. */
+static Bool module_ring_flush(fmodule *module, Bool do_block)
+{
+	fring_t *ring = MOD_RING(module);
 	mqueue_object_type *obj;
-	char *dptr;
-	int a;
 
+	while ((obj = get_message_queue_first(module)) != NULL)
+	{
+		if (fring_write(ring, obj->packet->data, obj->packet->size))
+		{
+			MOD_SYSCALLS_SAVED(module)++;
+			MOD_PACKETS_SENT(module)++;
+			MOD_BYTES_SENT(module) += obj->packet->size;
+			DeleteMessageQueueBuff(module);
+			continue;
+		}
+		/* the module has to see what is already in the ring before
+		 * it can make room */
+		MOD_SYSCALLS_SAVED(module) -= fring_signal(ring);
+		if (fring_wait_for_space(ring))
+		{
+			continue;
+		}
+		if (!do_block)
+		{
+			module_park(module);
+			module_update_write_interest(module);
+
+			return True;
+		}
+		if (!module_wait_fd(module, fring_get_space_fd(ring), FPOLL_IN))
+		{
+			return False;
+		}
+	}
+	MOD_SYSCALLS_SAVED(module) -= fring_signal(ring);
+	MOD_SET_PARKED(module, 0);
+	module_update_write_interest(module);
+
+	return True;
+}
+
+/* Writes as many queued packets as fit into the pipe with a single
+ * writev().  Returns the result of writev(). */
+static ssize_t write_message_queue_batch(fmodule *module)
+{
+	fmodule_queue *q = &MOD_PIPEQUEUE(module);
+	struct iovec iov[MQUEUE_MAX_IOV];
+	int total = 0;
+	int i;
+	int n;
+	ssize_t rc;
+	ssize_t written;
+
+	/* skips the holes at the start */
+	if (get_message_queue_first(module) == NULL)
+	{
+		return 0;
+	}
+	n = 0;
+	for (i = 0; i < q->count && n < MQUEUE_MAX_IOV; i++)
+	{
+		mqueue_object_type *obj;
+
+		obj = &q->entries[(q->first + i) & (q->size - 1)];
+		if (obj->packet == NULL)
+		{
+			continue;
+		}
+		/* the first packet is always taken, even if it does not fit
+		 * into the pipe */
+		if (n > 0 && total + obj->packet->size > MOD_PIPESIZE(module))
+		{
+			break;
+		}
+		iov[n].iov_base = (char *)obj->packet->data + obj->done;
+		iov[n].iov_len = obj->packet->size - obj->done;
+		total += iov[n].iov_len;
+		n++;
+	}
+	rc = writev(MOD_WRITEFD(module), iov, n);
+	if (rc <= 0)
+	{
+		return rc;
+	}
+	written = rc;
+	for (n = 0; rc > 0; n++)
+	{
+		mqueue_object_type *obj = get_message_queue_first(module);
+		int left = obj->packet->size - obj->done;
+
+		if (rc < left)
+		{
+			obj->done += rc;
+			MOD_QUEUED_BYTES(module) -= rc;
+			break;
+		}
+		rc -= left;
+		DeleteMessageQueueBuff(module);
+		MOD_PACKETS_SENT(module)++;
+	}
+	MOD_BYTES_SENT(module) += written;
+	/* count the packets that would have needed a write() of their own;
+	 * a packet written partially is finished by the next call */
+	if (n > 1)
+	{
+		MOD_SYSCALLS_SAVED(module) += n - 1;
+	}
+
+	return written;
+}
+
+/* Writes the queued packets to the module.  If the pipe is full, the module
+ * is parked and the rest is written when the main loop finds the pipe
+ * writable again, unless do_block is set.  Returns False if the module has
+ * been killed. */
+static Bool flush_message_queue(fmodule *module, Bool do_block)
+{
 	if (module == NULL)
 	{
-		return;
+		return False;
+	}
+	if (MOD_IS_RING_ACTIVE(module))
+	{
+		return module_ring_flush(module, do_block);
 	}
 
-	while (fqueue_get_first(&(MOD_PIPEQUEUE(module)), (void **)&obj) == 1)
+	while (!MQUEUE_IS_EMPTY(module))
 	{
-		dptr = (char *)obj->data;
-		while (obj->done < obj->size)
+		if (write_message_queue_batch(module) >= 0)
+		{
+			MOD_SET_PARKED(module, 0);
+		}
+		/* the write returns EWOULDBLOCK or EAGAIN if the pipe
+		 * is full. (This is non-blocking I/O). SunOS returns
+		 * EWOULDBLOCK, OSF/1 returns EAGAIN under these
+		 * conditions. Hopefully other OSes return one of these
+		 * values too. Solaris 2 doesn't seem to have a man
+		 * page for write(2) (!) */
+		else if (errno == EWOULDBLOCK || errno == EAGAIN)
 		{
-			a = write(MOD_WRITEFD(module), &dptr[obj->done],
-				  obj->size - obj->done);
-			if (a >=0)
+			if (!do_block)
 			{
-				obj->done += a;
+				module_park(module);
+				break;
 			}
-			/* the write returns EWOULDBLOCK or EAGAIN if the pipe
-			 * is full. (This is non-blocking I/O). SunOS returns
-			 * EWOULDBLOCK, OSF/1 returns EAGAIN under these
-			 * conditions. Hopefully other OSes return one of these
-			 * values too. Solaris 2 doesn't seem to have a man
-			 * page for write(2) (!) */
-			else if (errno == EWOULDBLOCK || errno == EAGAIN)
+			if (!module_wait_fd(
+				module, MOD_WRITEFD(module), FPOLL_OUT))
 			{
-				fd_set writeSet;
-				struct timeval timeout;
-				int channel = MOD_WRITEFD(module);
-				int rc = 0;
-
-				do
-				{
-					/* Wait until the pipe accepts further
-					 * input */
-					timeout.tv_sec = moduleTimeout;
-					timeout.tv_usec = 0;
-					FD_ZERO(&writeSet);
-					FD_SET(channel, &writeSet);
-					rc = fvwmSelect(
-						channel + 1, NULL, &writeSet,
-						NULL, &timeout);
-					/* retry if select() failed with EINTR
-					 */
-				} while ((rc < 0) && !isTerminated &&
-					 (errno == EINTR));
-
-				if ( isTerminated )
-				{
-					return;
-				}
-				if (!FD_ISSET(channel, &writeSet))
-				{
-					char *name;
-
-					name = get_pipe_name(module);
-					/* Doh! Something has gone wrong - get
-					 * rid of the offender! */
-					fvwm_msg(
-						ERR, "FlushMessageQueue",
-						"Failed to write descriptor to"
-						" '%s':\n"
-						"- select rc=%d\n"
-						"- terminate signal=%c\n",
-						name, rc, isTerminated ?
-						'Y' : 'N');
-					module_kill(module);
-
-					return;
-				}
-
-				/* pipe accepts further input; continue */
-				continue;
+				return False;
 			}
-			else if (errno != EINTR)
-			{
-				module_kill(module);
+		}
+		else if (errno != EINTR)
+		{
+			module_kill(module);
 
-				return;
-			}
+			return False;
 		}
-		DeleteMessageQueueBuff(module);
 	}
+	module_update_write_interest(module);
+
+	return True;
+}
+
+void FlushMessageQueue(fmodule *module)
+{
+	flush_message_queue(module, False);
 
 	return;
 }
@@ -1051,6 +1747,114 @@ void FlushAllMessageQueues(void)
 	return;
 }
 
+static const char *module_transport_name(fmodule *module)
+{
+	if (MOD_WRITEFD(module) < 0)
+	{
+		return "listen only";
+	}
+	else if (MOD_IS_RING_ACTIVE(module))
+	{
+		return "ring";
+	}
+
+	return "pipe";
+}
+
+void print_module_info(int verbose)
+{
+	fmodule_list_itr moditr;
+	fmodule *module;
+
+	fflush(stderr);
+	fflush(stdout);
+	fprintf(stderr, "fvwm info on modules:\n");
+	module_list_itr_init(&moditr);
+	while ((module = module_list_itr_next(&moditr)) != NULL)
+	{
+		fprintf(stderr,
+			"  %s: %s, %d queued packets (%d bytes), %lu packets"
+			" (%lu bytes) sent, %lu syscalls saved,"
+			" %lu packets coalesced%s\n",
+			get_pipe_name(module), module_transport_name(module),
+			MOD_PIPEQUEUE(module).count, MOD_QUEUED_BYTES(module),
+			MOD_PACKETS_SENT(module), MOD_BYTES_SENT(module),
+			MOD_SYSCALLS_SAVED(module), MOD_COALESCED(module),
+			MOD_IS_PARKED(module) ? ", parked" : "");
+		if (!MQUEUE_IS_EMPTY(module))
+		{
+			fprintf(stderr,
+				"    oldest queued packet: %d ms\n",
+				module_queue_age(module));
+		}
+		if (MOD_SYNC_SENT(module) > 0)
+		{
+			fprintf(stderr,
+				"    %lu sync packets, waited %lu ms"
+				" (at most %lu ms)\n",
+				MOD_SYNC_SENT(module),
+				MOD_SYNC_WAIT_TOTAL(module),
+				MOD_SYNC_WAIT_MAX(module));
+		}
+		if (MOD_FILTER_STRING(module) != NULL)
+		{
+			fprintf(stderr,
+				"    filter: %s, %lu packets dropped\n",
+				MOD_FILTER_STRING(module), MOD_FILTERED(module));
+		}
+		if (verbose > 0 && MOD_IS_PARKED(module))
+		{
+			fprintf(stderr, "    parked for %.0f s\n",
+				difftime(time(NULL), MOD_PARKTIME(module)));
+		}
+		if (verbose > 0 && !MOD_IS_RING_ACTIVE(module) &&
+		    MOD_WRITEFD(module) >= 0)
+		{
+			fprintf(stderr, "    pipe buffer: %d bytes\n",
+				MOD_PIPESIZE(module));
+		}
+	}
+	fflush(stderr);
+
+	return;
+}
+
+/* Sends one MX_REPLY message per module:
+ *
+ *   ModuleStats <alias> <transport> <queued packets> <queued bytes>
+ *     <oldest ms> <packets sent> <bytes sent> <sync packets> <sync total ms>
+ *     <sync max ms> <parked>
+ *
+ * followed by "ModuleStats End". */
+void send_module_info(fmodule *module)
+{
+	fmodule_list_itr moditr;
+	fmodule *m;
+	char line[256];
+
+	module_list_itr_init(&moditr);
+	while ((m = module_list_itr_next(&moditr)) != NULL)
+	{
+		snprintf(
+			line, sizeof(line),
+			"ModuleStats %s %s %d %d %d %lu %lu %lu %lu %lu %d",
+			(MOD_ALIAS(m) != NULL) ? MOD_ALIAS(m) :
+			(MOD_NAME(m) != NULL) ? MOD_NAME(m) : "(null)",
+			(MOD_WRITEFD(m) < 0) ? "none" :
+			module_transport_name(m),
+			MOD_PIPEQUEUE(m).count, MOD_QUEUED_BYTES(m),
+			module_queue_age(m), MOD_PACKETS_SENT(m),
+			MOD_BYTES_SENT(m), MOD_SYNC_SENT(m),
+			MOD_SYNC_WAIT_TOTAL(m), MOD_SYNC_WAIT_MAX(m),
+			MOD_IS_PARKED(m) ? 1 : 0);
+		SendName(module, MX_REPLY, 0, 0, 0, line);
+	}
+	SendName(module, MX_REPLY, 0, 0, 0, "ModuleStats End");
+	FlushMessageQueue(module);
+
+	return;
+}
+
 /* empty, only here so that the signal handling initialization code is the
  * same for modules and fvwm  */
 RETSIGTYPE DeadPipe(int sig)
@@ -1100,8 +1904,6 @@ void CMD_ModuleSynchronous(F_CMD_ARGS)
 	char *token;
 	char *expect = ModuleFinishedStartupResponse;
 	fmodule *module;
-	fd_set in_fdset;
-	fd_set out_fdset;
 	time_t start_time;
 	Bool done = False;
 	Bool need_ungrab = False;
@@ -1164,30 +1966,24 @@ void CMD_ModuleSynchronous(F_CMD_ARGS)
 
 	while (!done)
 	{
-		struct timeval timeout;
-		int num_fd;
+		int is_readable;
+		int is_writable = 0;
 
-		/* A signal here could interrupt the select call. We would
-		 * then need to restart our select, unless the signal was
-		 * a "terminate" signal. Note that we need to reinitialise
-		 * all of select's parameters after it has returned. */
+		/* A signal here could interrupt the wait. We would then need
+		 * to restart it, unless the signal was a "terminate"
+		 * signal. */
 		do
 		{
-			FD_ZERO(&in_fdset);
-			FD_ZERO(&out_fdset);
-
-			FD_SET(MOD_READFD(module), &in_fdset);
-
-			if (!FQUEUE_IS_EMPTY(&MOD_PIPEQUEUE(module)))
-			{
-				FD_SET(MOD_WRITEFD(module), &out_fdset);
-			}
-			timeout.tv_sec = 0;
-			timeout.tv_usec = 1;
-			num_fd = fvwmSelect(
-				fvwmlib_max_fd, &in_fdset, &out_fdset, 0,
-				&timeout);
-		} while (num_fd < 0 && !isTerminated);
+			is_readable = fpoll_wait_fd(
+				MOD_READFD(module), FPOLL_IN, 0);
+		} while (is_readable < 0 && !isTerminated);
+		if (
+			!isTerminated && MOD_WRITEFD(module) >= 0 &&
+			module_has_pending_output(module))
+		{
+			is_writable = fpoll_wait_fd(
+				MOD_WRITEFD(module), FPOLL_OUT, 0);
+		}
 
 		/* Exit if we have received a "terminate" signal */
 		if (isTerminated)
@@ -1195,9 +1991,9 @@ void CMD_ModuleSynchronous(F_CMD_ARGS)
 			break;
 		}
 
-		if (num_fd > 0)
+		if (is_readable > 0 || is_writable > 0)
 		{
-			if (FD_ISSET(MOD_READFD(module), &in_fdset))
+			if (is_readable > 0)
 			{
 				fmodule_input * input;
 
@@ -1217,8 +2013,7 @@ void CMD_ModuleSynchronous(F_CMD_ARGS)
 
 			}
 
-			if ((MOD_WRITEFD(module) >= 0) &&
-			    FD_ISSET(MOD_WRITEFD(module), &out_fdset))
+			if (is_writable > 0)
 			{
 				FlushMessageQueue(module);
 			}
@@ -1311,6 +2106,148 @@ void CMD_set_sync_mask(F_CMD_ARGS)
 	return;
 }
 
+void CMD_set_sync_timeout(F_CMD_ARGS)
+{
+	int val;
+
+	if (exc->m.module == NULL)
+	{
+		return;
+	}
+	if (!action || sscanf(action, "%d", &val) != 1 || val < 0)
+	{
+		val = 0;
+	}
+	MOD_SYNC_TIMEOUT(exc->m.module) = val;
+
+	return;
+}
+
+void CMD_set_ring(F_CMD_ARGS)
+{
+	fmodule *module = exc->m.module;
+	fring_t *ring;
+	int fds[3];
+
+	if (
+		module == NULL || MOD_PID(module) <= 0 ||
+		MOD_RING(module) != NULL || MOD_WRITEFD(module) < 0)
+	{
+		return;
+	}
+	/* the numbers of the module's ring descriptors */
+	if (GetIntegerArguments(action, NULL, fds, 3) != 3)
+	{
+		return;
+	}
+	ring = fring_attach(MOD_PID(module), fds[0], fds[1], fds[2]);
+	if (ring == NULL)
+	{
+		/* the module keeps using the pipe */
+		return;
+	}
+	if (
+		fring_get_doorbell_fd(ring) >= fpoll_get_max_fd() ||
+		fring_get_space_fd(ring) >= fpoll_get_max_fd())
+	{
+		fring_destroy(ring);
+		return;
+	}
+	/* everything queued for the pipe must arrive before the first packet
+	 * in the ring */
+	if (!flush_message_queue(module, True))
+	{
+		fring_destroy(ring);
+		return;
+	}
+	MOD_RING(module) = ring;
+	/* the module switches to the ring when it reads the end of the pipe
+	 */
+	fring_activate(ring);
+	fpoll_remove(MOD_WRITEFD(module));
+	close(MOD_WRITEFD(module));
+	MOD_WRITEFD(module) = fring_get_doorbell_fd(ring);
+	MOD_SET_RING_ACTIVE(module, 1);
+
+	return;
+}
+
+void CMD_set_coalesce_mask(F_CMD_ARGS)
+{
+	msg_masks_t *mask;
+	unsigned long val;
+
+	if (exc->m.module == NULL)
+	{
+		return;
+	}
+	if (!action || sscanf(action,"%lu",&val) != 1)
+	{
+		val = 0;
+	}
+	mask = &(MOD_COALESCEMASK(exc->m.module));
+	set_message_mask(mask, val);
+	/* other messages may carry information that must not get lost */
+	mask->m1 &= MQUEUE_COALESCE_M1;
+	mask->m2 &= MQUEUE_COALESCE_M2;
+
+	return;
+}
+
+static void module_free_filter(fmodule *module)
+{
+	if (MOD_FILTER(module) != NULL)
+	{
+		FreeConditionMask(MOD_FILTER(module));
+		free(MOD_FILTER(module));
+		MOD_FILTER(module) = NULL;
+	}
+	if (MOD_FILTER_STRING(module) != NULL)
+	{
+		free(MOD_FILTER_STRING(module));
+		MOD_FILTER_STRING(module) = NULL;
+	}
+	wintable_destroy(MOD_FILTER_WINDOWS(module));
+	MOD_FILTER_WINDOWS(module) = NULL;
+
+	return;
+}
+
+void CMD_set_filter(F_CMD_ARGS)
+{
+	fmodule *module = exc->m.module;
+	WindowConditionMask *mask;
+	char *conditions;
+
+	if (module == NULL)
+	{
+		return;
+	}
+	module_free_filter(module);
+	if (action == NULL)
+	{
+		return;
+	}
+	conditions = fxstrdup(action);
+	if (*conditions == 0)
+	{
+		free(conditions);
+		return;
+	}
+	mask = fxmalloc(sizeof(WindowConditionMask));
+	DefaultConditionMask(mask);
+	/* modules want to see all windows, not only those for Next/Prev */
+	mask->my_flags.use_circulate_hit = 1;
+	mask->my_flags.use_circulate_hit_icon = 1;
+	mask->my_flags.use_circulate_hit_shaded = 1;
+	CreateConditionMask(conditions, mask);
+	MOD_FILTER(module) = mask;
+	MOD_FILTER_STRING(module) = conditions;
+	MOD_FILTER_WINDOWS(module) = wintable_create();
+
+	return;
+}
+
 void CMD_set_nograb_mask(F_CMD_ARGS)
 {
 	unsigned long val;
@@ -5,6 +5,8 @@
 
 #include "libs/Module.h"
 #include "libs/fqueue.h"
+#include "libs/fring.h"
+#include "libs/wintable.h"
 
 /* for F_CMD_ARGS */
 #include "fvwm/fvwm.h"
@@ -18,6 +20,17 @@ typedef struct msg_masks_t
 	unsigned long m2;
 } msg_masks_t;
 
+/* packets waiting to be written to a module; a circular array of
+ * references to packets that may be shared with other modules */
+typedef struct fmodule_queue
+{
+	struct fmodule_queue_entry *entries;
+	/* a power of two */
+	int size;
+	int first;
+	int count;
+} fmodule_queue;
+
 /* module linked list record, only to be accessed by using the access macros
  * below */
 typedef struct fmodule
@@ -25,19 +38,66 @@ typedef struct fmodule
         struct
         {
 		unsigned is_cmdline_module : 1;
+		unsigned is_ring_active : 1;
+		unsigned is_parked : 1;
+		unsigned is_lag_reported : 1;
         } xflags;
+	/* 0 if fvwm has not forked the module */
+	pid_t xpid;
 	int xreadPipe;
 	int xwritePipe;
-	fqueue xpipeQueue;
+	/* bytes the write pipe can hold */
+	int xpipeSize;
+	fmodule_queue xpipeQueue;
+	/* when the module stopped taking packets */
+	time_t xparkTime;
+	/* write calls saved by writev() and the ring */
+	unsigned long xsyscallsSaved;
+	/* bytes waiting in the queue */
+	int xqueuedBytes;
+	unsigned long xpacketsSent;
+	unsigned long xbytesSent;
+	/* queued packets dropped in favour of newer ones */
+	unsigned long xcoalesced;
+	/* sync mask packets sent and answered */
+	unsigned long xsyncSent;
+	unsigned long xsyncAcked;
+	/* milliseconds a command waits for the answer; 0 means ModuleTimeout
+	 * seconds, after which the module is killed */
+	int xsyncTimeout;
+	/* time spent waiting for the answers */
+	unsigned long xsyncWaitTotal;
+	unsigned long xsyncWaitMax;
+	/* shared memory ring created by the module, used instead of the
+	 * write pipe once fvwm has taken it over */
+	fring_t *xring;
 	msg_masks_t xPipeMask;
 	msg_masks_t xNoGrabMask;
 	msg_masks_t xSyncMask;
+	/* queued messages that are replaced by newer ones for the same
+	 * window */
+	msg_masks_t xCoalesceMask;
+	/* conditions the window of a window message must match, NULL if
+	 * there are none */
+	WindowConditionMask *xfilter;
+	char *xfilterString;
+	/* the windows that matched the filter when the last message about
+	 * them was sent */
+	wintable_t *xfilterWindows;
+	/* messages dropped by the filter */
+	unsigned long xfiltered;
 	char *xname;
 	char *xalias;
 } fmodule;
 
 #define MOD_IS_CMDLINE(m) ((m)->xflags.is_cmdline_module)
 #define MOD_SET_CMDLINE(m,on) ((m)->xflags.is_cmdline_module = !!(on))
+#define MOD_IS_RING_ACTIVE(m) ((m)->xflags.is_ring_active)
+#define MOD_SET_RING_ACTIVE(m,on) ((m)->xflags.is_ring_active = !!(on))
+#define MOD_IS_PARKED(m) ((m)->xflags.is_parked)
+#define MOD_SET_PARKED(m,on) ((m)->xflags.is_parked = !!(on))
+#define MOD_IS_LAG_REPORTED(m) ((m)->xflags.is_lag_reported)
+#define MOD_SET_LAG_REPORTED(m,on) ((m)->xflags.is_lag_reported = !!(on))
 
 typedef struct fmodule_store
 {
@@ -51,9 +111,27 @@ typedef fmodule_store* fmodule_list;
 /* this objects allows safe iteration over a module list */
 typedef fmodule_store* fmodule_list_itr;
 
+#define MOD_PID(m) ((m)->xpid)
 #define MOD_READFD(m) ((m)->xreadPipe)
 #define MOD_WRITEFD(m) ((m)->xwritePipe)
 #define MOD_PIPEQUEUE(m) ((m)->xpipeQueue)
+#define MOD_PIPESIZE(m) ((m)->xpipeSize)
+#define MOD_PARKTIME(m) ((m)->xparkTime)
+#define MOD_SYSCALLS_SAVED(m) ((m)->xsyscallsSaved)
+#define MOD_QUEUED_BYTES(m) ((m)->xqueuedBytes)
+#define MOD_PACKETS_SENT(m) ((m)->xpacketsSent)
+#define MOD_BYTES_SENT(m) ((m)->xbytesSent)
+#define MOD_COALESCED(m) ((m)->xcoalesced)
+#define MOD_FILTER(m) ((m)->xfilter)
+#define MOD_FILTER_STRING(m) ((m)->xfilterString)
+#define MOD_FILTER_WINDOWS(m) ((m)->xfilterWindows)
+#define MOD_FILTERED(m) ((m)->xfiltered)
+#define MOD_SYNC_SENT(m) ((m)->xsyncSent)
+#define MOD_SYNC_ACKED(m) ((m)->xsyncAcked)
+#define MOD_SYNC_TIMEOUT(m) ((m)->xsyncTimeout)
+#define MOD_SYNC_WAIT_TOTAL(m) ((m)->xsyncWaitTotal)
+#define MOD_SYNC_WAIT_MAX(m) ((m)->xsyncWaitMax)
+#define MOD_RING(m) ((m)->xring)
 #define MOD_PIPEMASK(m) ((m)->xPipeMask)
 #define MOD_NAME(m) ((m)->xname)
 #define MOD_ALIAS(m) ((m)->xalias)
@@ -115,6 +193,17 @@ fmodule *executeModuleDesperate(F_CMD_ARGS);
 /* module_send(fmodule *module, unsigned long *ptr, int size); */
 void PositiveWrite(fmodule *module, unsigned long *ptr, int size);
 
+/* send the same "raw" data to all modules; the data is copied at most once
+ * and shared by the queues of all modules */
+void module_broadcast(unsigned long *ptr, int size);
+
+/* returns False if the module's filter rejects the window message; must be
+ * called once for each message that is sent to the module */
+Bool module_filter_packet(fmodule *module, unsigned long *ptr);
+/* called before SendWindowInfo() sends a window to the module, so that
+ * module_filter_packet() does not send it once more */
+void module_filter_prepare_window(fmodule *module, FvwmWindow *fw);
+
 /* returns a dynamicaly allocated struct with the received data
  * or NULL on error */
 fmodule_input *module_receive(fmodule *module);
@@ -138,13 +227,19 @@ fmodule *module_list_itr_next(fmodule_list_itr *itr);
 /* free modules in the deathrow */
 void module_cleanup(void);
 
+/* print the transport and queue of each module */
+void print_module_info(int verbose);
+/* sends the numbers printed by print_module_info() to the module */
+void send_module_info(fmodule *module);
+
 
 
 /*
  *	Message Queue Handling Functions
  */
 
-/* message queues */
+/* message queues; modules that do not take all packets are parked and
+ * flushed again from the main loop */
 void FlushAllMessageQueues(void);
 void FlushMessageQueue(fmodule *module);
 
@@ -23,6 +23,8 @@
 
 #include <stdio.h>
 #include <math.h>
+#include <limits.h>
+#include <time.h>
 #include <X11/keysym.h>
 
 #include "libs/fvwmlib.h"
@@ -30,6 +32,7 @@
 #include "libs/Grab.h"
 #include "libs/Parse.h"
 #include "libs/Graphics.h"
+#include "libs/fpoll.h"
 #include "fvwm.h"
 #include "externs.h"
 #include "cursor.h"
@@ -57,6 +60,7 @@
 #include "move_resize.h"
 #include "functions.h"
 #include "style.h"
+#include "geom_index.h"
 
 /* ----- move globals ----- */
 
@@ -87,8 +91,68 @@ static int move_interactive_finish_button_mask =
 static int move_drag_finish_button_mask =
 	((1<<(NUMBER_OF_EXTENDED_MOUSE_BUTTONS))-1) & ~0x3;
 
+/* edges of other windows that attract the moved window */
+typedef enum
+{
+	SNAP_EDGE_LEFT = 0,
+	SNAP_EDGE_RIGHT,
+	SNAP_EDGE_TOP,
+	SNAP_EDGE_BOTTOM,
+	SNAP_EDGE_NUM
+} snap_edge_type;
+
+typedef struct
+{
+	/* x coordinate of a left or right edge, y of a top or bottom edge */
+	int pos;
+	/* the edge covers [start, end) in the other direction */
+	int start;
+	int end;
+	/* position of the window in the window list; ties between equally
+	 * distant edges go to the first window, as if the list was walked */
+	int order;
+} snap_edge_t;
+
+/* The snap candidates of an interactive move, collected once at the start
+ * of the move and again after the viewport has changed.  Each list is sorted
+ * by pos. */
+typedef struct
+{
+	snap_edge_t *edges[SNAP_EDGE_NUM];
+	int num_edges[SNAP_EDGE_NUM];
+	int size;
+	Bool is_valid;
+	/* the monitor and screen size the edges were collected for */
+	struct monitor *m;
+	int scr_w;
+	int scr_h;
+	int vx;
+	int vy;
+} snap_edges_t;
+
 /* ----- end of move globals ----- */
 
+/* ----- frame rate globals ----- */
+
+/* The update rate limit and the statistics of an opaque move or resize.
+ * All times are microseconds since the start of the move or resize. */
+typedef struct
+{
+	struct timespec start;
+	/* time between two updates, 0 if not limited */
+	long period;
+	long next_frame;
+	long frame_start;
+	Bool is_in_frame;
+	int num_frames;
+	int num_dropped;
+	long last_frame_time;
+	long max_frame_time;
+	long sum_frame_time;
+} frame_rate_t;
+
+/* ----- end of frame rate globals ----- */
+
 /* ----- resize globals ----- */
 
 /* DO NOT USE (STATIC) GLOBALS IN THIS MODULE!
@@ -876,15 +940,155 @@ static void position_geometry_window(const XEvent *eventp)
 	return;
 }
 
+static long __frame_rate_get_time(const frame_rate_t *fr)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (now.tv_sec - fr->start.tv_sec) * 1000000L +
+		(now.tv_nsec - fr->start.tv_nsec) / 1000L;
+}
+
+/* reset the statistics at the start of an opaque move or resize */
+static void __frame_rate_init(frame_rate_t *fr)
+{
+	memset(fr, 0, sizeof(*fr));
+	clock_gettime(CLOCK_MONOTONIC, &fr->start);
+	if (Scr.OpaqueFrameRate > 0)
+	{
+		fr->period = 1000000L / Scr.OpaqueFrameRate;
+	}
+
+	return;
+}
+
+/* Called with a MotionNotify event before the window is updated.  Waits
+ * until the next update is due and replaces *e with the latest motion that
+ * arrived meanwhile.  Stops waiting early if a button or key event is
+ * queued, so the motion before it is not lost. */
+static void __frame_rate_begin_frame(frame_rate_t *fr, XEvent *e)
+{
+	XEvent e2;
+	long now;
+	Bool is_interrupted = False;
+
+	now = __frame_rate_get_time(fr);
+	while (fr->period > 0 && !is_interrupted)
+	{
+		int ms;
+
+		while (FCheckMaskEvent(
+			       dpy, ButtonMotionMask | PointerMotionMask |
+			       ButtonPressMask | ButtonReleaseMask |
+			       KeyPressMask, &e2))
+		{
+			if (e2.type != MotionNotify)
+			{
+				FPutBackEvent(dpy, &e2);
+				is_interrupted = True;
+				break;
+			}
+			*e = e2;
+			fr->num_dropped++;
+		}
+		now = __frame_rate_get_time(fr);
+		if (is_interrupted || now >= fr->next_frame)
+		{
+			break;
+		}
+		ms = (fr->next_frame - now + 999) / 1000;
+		if (fpoll_wait_fd(XConnectionNumber(dpy), FPOLL_IN, ms) < 0)
+		{
+			break;
+		}
+	}
+	fr->frame_start = now;
+	fr->is_in_frame = True;
+	if (fr->period > 0)
+	{
+		/* keep the cadence unless an update took too long */
+		fr->next_frame += fr->period;
+		if (fr->next_frame <= now)
+		{
+			fr->next_frame = now + fr->period;
+		}
+	}
+
+	return;
+}
+
+static void __frame_rate_end_frame(frame_rate_t *fr)
+{
+	long t;
+
+	if (!fr->is_in_frame)
+	{
+		return;
+	}
+	fr->is_in_frame = False;
+	t = __frame_rate_get_time(fr) - fr->frame_start;
+	fr->last_frame_time = t;
+	fr->sum_frame_time += t;
+	if (t > fr->max_frame_time)
+	{
+		fr->max_frame_time = t;
+	}
+	fr->num_frames++;
+
+	return;
+}
+
+static void __frame_rate_report(const frame_rate_t *fr, char *func)
+{
+	if (!Scr.bo.do_debug_frame_rate || fr->num_frames == 0)
+	{
+		return;
+	}
+	fvwm_msg(
+		DBG, func, "%d updates, %d motions skipped, update time"
+		" %.2f ms average, %.2f ms max",
+		fr->num_frames, fr->num_dropped,
+		fr->sum_frame_time / 1000.0 / fr->num_frames,
+		fr->max_frame_time / 1000.0);
+
+	return;
+}
+
+/* append the frame rate statistics to a geometry window string */
+static void __frame_rate_append_string(const frame_rate_t *fr, char *str)
+{
+	if (!Scr.bo.do_debug_frame_rate || fr == NULL)
+	{
+		return;
+	}
+	(void)sprintf(
+		str + strlen(str), GEOMETRY_WINDOW_RATE_FMT_STRING,
+		fr->num_dropped, fr->last_frame_time / 1000.0);
+
+	return;
+}
+
 void resize_geometry_window(void)
 {
 	int w;
 	int h;
 	int cset = Scr.DefaultColorset;
 
-	Scr.SizeStringWidth =
-		FlocaleTextWidth(Scr.DefaultFont, GEOMETRY_WINDOW_STRING,
-				 sizeof(GEOMETRY_WINDOW_STRING) - 1);
+	if (Scr.bo.do_debug_frame_rate)
+	{
+		Scr.SizeStringWidth = FlocaleTextWidth(
+			Scr.DefaultFont,
+			GEOMETRY_WINDOW_STRING GEOMETRY_WINDOW_RATE_STRING,
+			sizeof(GEOMETRY_WINDOW_STRING
+			       GEOMETRY_WINDOW_RATE_STRING) - 1);
+	}
+	else
+	{
+		Scr.SizeStringWidth =
+			FlocaleTextWidth(Scr.DefaultFont, GEOMETRY_WINDOW_STRING,
+					 sizeof(GEOMETRY_WINDOW_STRING) - 1);
+	}
 	w = Scr.SizeStringWidth + 2 * GEOMETRY_WINDOW_BW;
 	h = Scr.DefaultFont->height + 2 * GEOMETRY_WINDOW_BW;
 	if (w != sizew_g.width || h != sizew_g.height)
@@ -915,11 +1119,13 @@ void resize_geometry_window(void)
  *  Inputs:
  *      tmp_win - the current fvwm window
  *      x, y    - position of the window
+ *      fr      - frame rate statistics to show, or NULL
  *
  */
 
 static void DisplayPosition(
-	const FvwmWindow *tmp_win, const XEvent *eventp, int x, int y,int Init)
+	const FvwmWindow *tmp_win, const XEvent *eventp, int x, int y,int Init,
+	const frame_rate_t *fr)
 {
 	char str[100];
 	int offset;
@@ -938,6 +1144,7 @@ static void DisplayPosition(
 	FScreenTranslateCoordinates(NULL, FSCREEN_GLOBAL, &fscr,
 			FSCREEN_XYPOS, &x, &y);
 	(void)sprintf(str, GEOMETRY_WINDOW_POS_STRING, x, y);
+	__frame_rate_append_string(fr, str);
 	if (Init)
 	{
 		XClearWindow(dpy, Scr.SizeWindow);
@@ -988,11 +1195,12 @@ static void DisplayPosition(
  *      tmp_win - the current fvwm window
  *      width   - the width of the rubber band
  *      height  - the height of the rubber band
+ *      fr      - frame rate statistics to show, or NULL
  *
  */
 static void DisplaySize(
 	const FvwmWindow *tmp_win, const XEvent *eventp, int width,
-	int height, Bool Init, Bool resetLast)
+	int height, Bool Init, Bool resetLast, const frame_rate_t *fr)
 {
 	char str[100];
 	int dwidth,dheight,offset;
@@ -1027,6 +1235,7 @@ static void DisplaySize(
 	dheight /= tmp_win->hints.height_inc;
 
 	(void)sprintf(str, GEOMETRY_WINDOW_SIZE_STRING, dwidth, dheight);
+	__frame_rate_append_string(fr, str);
 	if (Init)
 	{
 		XClearWindow(dpy,Scr.SizeWindow);
@@ -1454,6 +1663,7 @@ static void AnimatedMoveAnyWindow(
 		{
 			fw->g.frame.x = currentX;
 			fw->g.frame.y = currentY;
+			geom_index_update(fw);
 			update_absolute_geometry(fw);
 			maximize_adjust_offset(fw);
 			BroadcastConfig(M_CONFIGURE_WINDOW, fw);
@@ -1944,10 +2154,204 @@ static void update_pos(
 	return;
 }
 
+static int __snap_edge_cmp(const void *a, const void *b)
+{
+	const snap_edge_t *e1 = a;
+	const snap_edge_t *e2 = b;
+
+	if (e1->pos != e2->pos)
+	{
+		return (e1->pos < e2->pos) ? -1 : 1;
+	}
+
+	return e1->order - e2->order;
+}
+
+static void __snap_add_edge(
+	snap_edges_t *se, snap_edge_type type, int pos, int start, int end,
+	int order)
+{
+	snap_edge_t *e;
+
+	e = &se->edges[type][se->num_edges[type]++];
+	e->pos = pos;
+	e->start = start;
+	e->end = end;
+	e->order = order;
+
+	return;
+}
+
+/* Collects the edges of all windows the window can snap to, with the same
+ * tests DoSnapAttract() used to apply to every window on every step. */
+static void __snap_collect_edges(
+	snap_edges_t *se, FvwmWindow *fw, struct monitor *m, int scr_w,
+	int scr_h)
+{
+	FvwmWindow *tmp;
+	int maskout = (SNAP_SCREEN | SNAP_SCREEN_WINDOWS |
+		       SNAP_SCREEN_ICONS | SNAP_SCREEN_ALL);
+	int order;
+	int i;
+
+	for (i = 0; i < SNAP_EDGE_NUM; i++)
+	{
+		se->num_edges[i] = 0;
+	}
+	se->is_valid = True;
+	se->m = m;
+	se->scr_w = scr_w;
+	se->scr_h = scr_h;
+	se->vx = m->virtual_scr.Vx;
+	se->vy = m->virtual_scr.Vy;
+	for (order = 0, tmp = Scr.FvwmRoot.next; tmp;
+	     tmp = tmp->next, order++)
+	{
+		rectangle other;
+
+		if (fw->Desk != tmp->Desk || fw == tmp)
+		{
+			continue;
+		}
+		/* check snapping type */
+		switch (fw->snap_attraction.mode & ~(maskout))
+		{
+		case SNAP_WINDOWS:  /* we only snap windows */
+			if (IS_ICONIFIED(tmp) || IS_ICONIFIED(fw))
+			{
+				continue;
+			}
+			break;
+		case SNAP_ICONS:  /* we only snap icons */
+			if (!IS_ICONIFIED(tmp) || !IS_ICONIFIED(fw))
+			{
+				continue;
+			}
+			break;
+		case SNAP_SAME:  /* we don't snap unequal */
+			if (IS_ICONIFIED(tmp) != IS_ICONIFIED(fw))
+			{
+				continue;
+			}
+			break;
+		default:  /* All */
+			/* NOOP */
+			break;
+		}
+		/* get other window dimensions */
+		get_visible_window_or_icon_geometry(tmp, &other);
+		if (other.x >= scr_w ||
+		    other.x + other.width <= 0 ||
+		    other.y >= scr_h ||
+		    other.y + other.height <= 0)
+		{
+			/* do not snap to windows that are not currently
+			 * visible */
+			continue;
+		}
+		if (se->num_edges[0] == se->size)
+		{
+			se->size = (se->size == 0) ? 32 : 2 * se->size;
+			for (i = 0; i < SNAP_EDGE_NUM; i++)
+			{
+				se->edges[i] = fxrealloc(
+					(void *)se->edges[i], se->size,
+					sizeof(snap_edge_t));
+			}
+		}
+		/* the left edge was tested before the right edge */
+		__snap_add_edge(
+			se, SNAP_EDGE_LEFT, other.x, other.y,
+			other.y + other.height, 2 * order);
+		__snap_add_edge(
+			se, SNAP_EDGE_RIGHT, other.x + other.width, other.y,
+			other.y + other.height, 2 * order + 1);
+		__snap_add_edge(
+			se, SNAP_EDGE_TOP, other.y, other.x,
+			other.x + other.width, 2 * order);
+		__snap_add_edge(
+			se, SNAP_EDGE_BOTTOM, other.y + other.height, other.x,
+			other.x + other.width, 2 * order + 1);
+	}
+	for (i = 0; i < SNAP_EDGE_NUM; i++)
+	{
+		qsort(se->edges[i], se->num_edges[i], sizeof(snap_edge_t),
+		      __snap_edge_cmp);
+	}
+
+	return;
+}
+
+static void __snap_free_edges(snap_edges_t *se)
+{
+	int i;
+
+	for (i = 0; i < SNAP_EDGE_NUM; i++)
+	{
+		if (se->edges[i] != NULL)
+		{
+			free(se->edges[i]);
+		}
+	}
+	memset(se, 0, sizeof(*se));
+
+	return;
+}
+
+/* Snaps to the closest edge of the given type with a position between lo and
+ * hi that overlaps [start, end) in the other direction.  The window moves to
+ * pos - offset. */
+static void __snap_to_edges(
+	snap_edges_t *se, snap_edge_type type, int lo, int hi, int start,
+	int end, int ref, int offset, int *dest_score, int *dest_pos,
+	int *dest_order)
+{
+	snap_edge_t *edges = se->edges[type];
+	int l = 0;
+	int r = se->num_edges[type];
+
+	/* find the first edge at lo or later */
+	while (l < r)
+	{
+		int i = (l + r) / 2;
+
+		if (edges[i].pos < lo)
+		{
+			l = i + 1;
+		}
+		else
+		{
+			r = i;
+		}
+	}
+	for ( ; l < se->num_edges[type] && edges[l].pos <= hi; l++)
+	{
+		snap_edge_t *e = &edges[l];
+		int score;
+
+		if (e->end <= start || e->start >= end)
+		{
+			continue;
+		}
+		score = abs(ref - e->pos);
+		if (score < *dest_score ||
+		    (score == *dest_score && e->order < *dest_order))
+		{
+			*dest_score = score;
+			*dest_pos = e->pos - offset;
+			*dest_order = e->order;
+		}
+	}
+
+	return;
+}
+
 /* This function does the SnapAttraction stuff. It takes x and y coordinates
- * (*px and *py) and returns the snapped values. */
+ * (*px and *py) and returns the snapped values.  The edges of the other
+ * windows are taken from se, which is filled when needed. */
 static void DoSnapAttract(
-	FvwmWindow *fw, int Width, int Height, int *px, int *py)
+	FvwmWindow *fw, snap_edges_t *se, int Width, int Height, int *px,
+	int *py)
 {
 	int nyt,nxl;
 	rectangle self;
@@ -2015,132 +2419,33 @@ static void DoSnapAttract(
 	if (fw->snap_attraction.proximity > 0 &&
 		(fw->snap_attraction.mode & (SNAP_ICONS | SNAP_WINDOWS | SNAP_SAME)))
 	{
-		FvwmWindow *tmp;
-		int maskout = (SNAP_SCREEN | SNAP_SCREEN_WINDOWS |
-				SNAP_SCREEN_ICONS | SNAP_SCREEN_ALL);
-
-		for (tmp = Scr.FvwmRoot.next; tmp; tmp = tmp->next)
-		{
-			rectangle other;
-
-			if (fw->Desk != tmp->Desk || fw == tmp)
-			{
-				continue;
-			}
-			/* check snapping type */
-			switch (fw->snap_attraction.mode & ~(maskout))
-			{
-			case SNAP_WINDOWS:  /* we only snap windows */
-				if (IS_ICONIFIED(tmp) || IS_ICONIFIED(fw))
-				{
-					continue;
-				}
-				break;
-			case SNAP_ICONS:  /* we only snap icons */
-				if (!IS_ICONIFIED(tmp) || !IS_ICONIFIED(fw))
-				{
-					continue;
-				}
-				break;
-			case SNAP_SAME:  /* we don't snap unequal */
-				if (IS_ICONIFIED(tmp) != IS_ICONIFIED(fw))
-				{
-					continue;
-				}
-				break;
-			default:  /* All */
-				/* NOOP */
-				break;
-			}
-			/* get other window dimensions */
-			get_visible_window_or_icon_geometry(tmp, &other);
-			if (other.x >= scr_w ||
-			    other.x + other.width <= 0 ||
-			    other.y >= scr_h ||
-			    other.y + other.height <= 0)
-			{
-				/* do not snap to windows that are not currently
-				 * visible */
-				continue;
-			}
-			/* snap horizontally */
-			if (
-				other.y + other.height > *py &&
-				other.y < *py + self.height)
-			{
-				if (*px + self.width >= other.x &&
-				    *px + self.width <
-				    other.x + fw->snap_attraction.proximity)
-				{
-					update_pos(
-						&score_x, &nxl, *px,
-						other.x - self.width);
-				}
-				if (*px + self.width >=
-				    other.x - fw->snap_attraction.proximity &&
-				    *px + self.width < other.x)
-				{
-					update_pos(
-						&score_x, &nxl, *px,
-						other.x - self.width);
-				}
-				if (*px <= other.x + other.width &&
-				    *px > other.x + other.width -
-				    fw->snap_attraction.proximity)
-				{
-					update_pos(
-						&score_x, &nxl, *px,
-						other.x + other.width);
-				}
-				if (*px <= other.x + other.width +
-				    fw->snap_attraction.proximity &&
-				    *px > other.x + other.width)
-				{
-					update_pos(
-						&score_x, &nxl, *px,
-						other.x + other.width);
-				}
-			}
-			/* snap vertically */
-			if (
-				other.x + other.width > *px &&
-				other.x < *px + self.width)
-			{
-				if (*py + self.height >= other.y &&
-				    *py + self.height < other.y +
-				    fw->snap_attraction.proximity)
-				{
-					update_pos(
-						&score_y, &nyt, *py,
-						other.y - self.height);
-				}
-				if (*py + self.height >=
-				    other.y - fw->snap_attraction.proximity &&
-				    *py + self.height < other.y)
-				{
-					update_pos(
-						&score_y, &nyt, *py,
-						other.y - self.height);
-				}
-				if (*py <=
-				    other.y + other.height &&
-				    *py > other.y + other.height -
-				    fw->snap_attraction.proximity)
-				{
-					update_pos(
-						&score_y, &nyt, *py,
-						other.y + other.height);
-				}
-				if (*py <= other.y + other.height +
-				    fw->snap_attraction.proximity &&
-				    *py > other.y + other.height)
-				{
-					update_pos(
-						&score_y, &nyt, *py,
-						other.y + other.height);
-				}
-			}
-		} /* for */
+		int prox = fw->snap_attraction.proximity;
+		int order_x = INT_MAX;
+		int order_y = INT_MAX;
+
+		if (!se->is_valid || se->m != m || se->scr_w != scr_w ||
+		    se->scr_h != scr_h || se->vx != m->virtual_scr.Vx ||
+		    se->vy != m->virtual_scr.Vy)
+		{
+			__snap_collect_edges(se, fw, m, scr_w, scr_h);
+		}
+		/* snap horizontally */
+		__snap_to_edges(
+			se, SNAP_EDGE_LEFT, *px + self.width - prox + 1,
+			*px + self.width + prox, *py, *py + self.height,
+			*px + self.width, self.width, &score_x, &nxl, &order_x);
+		__snap_to_edges(
+			se, SNAP_EDGE_RIGHT, *px - prox, *px + prox - 1, *py,
+			*py + self.height, *px, 0, &score_x, &nxl, &order_x);
+		/* snap vertically */
+		__snap_to_edges(
+			se, SNAP_EDGE_TOP, *py + self.height - prox + 1,
+			*py + self.height + prox, *px, *px + self.width,
+			*py + self.height, self.height, &score_y, &nyt,
+			&order_y);
+		__snap_to_edges(
+			se, SNAP_EDGE_BOTTOM, *py - prox, *py + prox - 1, *px,
+			*px + self.width, *py, 0, &score_y, &nyt, &order_y);
 	} /* snap to other windows */
 
 	/* snap to screen egdes */
@@ -2357,6 +2662,8 @@ Bool __move_loop(
 	/* if Alt is initially pressed don't enable no-snap until Alt is
 	 * released */
 	Bool nosnap_enabled = False;
+	snap_edges_t snap_edges;
+	frame_rate_t frame_rate;
 	/* Must not set placed by button if the event is a modified KeyEvent */
 	Bool is_fake_event;
 	FvwmWindow *fw = exc->w.fw;
@@ -2449,9 +2756,11 @@ Bool __move_loop(
 	{
 		draw_parts = border_get_transparent_decorations_part(fw);
 	}
-	DisplayPosition(fw, exc->x.elast, xl, yt, True);
+	__frame_rate_init(&frame_rate);
+	DisplayPosition(fw, exc->x.elast, xl, yt, True, &frame_rate);
 
 	memset(&e, 0, sizeof(e));
+	memset(&snap_edges, 0, sizeof(snap_edges));
 
 	/* Unset the placed by button mask.
 	 * If the move is canceled this will remain as zero.
@@ -2501,7 +2810,9 @@ Bool __move_loop(
 			yt += YOffset;
 			if (do_snap)
 			{
-				DoSnapAttract(fw, Width, Height, &xl, &yt);
+				DoSnapAttract(
+					fw, &snap_edges, Width, Height, &xl,
+					&yt);
 				was_snapped = True;
 			}
 			fev_make_null_event(&e, dpy);
@@ -2586,6 +2897,10 @@ Bool __move_loop(
 				 * ignore event */
 			}
 		}
+		if (do_move_opaque && e.type == MotionNotify)
+		{
+			__frame_rate_begin_frame(&frame_rate, &e);
+		}
 		is_fake_event = False;
 		/* Handle a limited number of key press events to allow
 		 * mouseless operation */
@@ -2732,7 +3047,8 @@ Bool __move_loop(
 				if (do_snap)
 				{
 					DoSnapAttract(
-						fw, Width, Height, &xl, &yt);
+						fw, &snap_edges, Width, Height,
+						&xl, &yt);
 					was_snapped = True;
 				}
 			}
@@ -2775,7 +3091,9 @@ Bool __move_loop(
 
 			if (do_snap)
 			{
-				DoSnapAttract(fw, Width, Height, &xl, &yt);
+				DoSnapAttract(
+					fw, &snap_edges, Width, Height, &xl,
+					&yt);
 				was_snapped = True;
 			}
 
@@ -2805,7 +3123,8 @@ Bool __move_loop(
 							xl, yt);
 					}
 				}
-				DisplayPosition(fw, &e, xl, yt, False);
+				DisplayPosition(
+					fw, &e, xl, yt, False, &frame_rate);
 
 				/* prevent window from lagging behind mouse
 				 * when paging - mab */
@@ -2834,8 +3153,8 @@ Bool __move_loop(
 					if (do_snap)
 					{
 						DoSnapAttract(
-							fw, Width, Height,
-							&xl, &yt);
+							fw, &snap_edges, Width,
+							Height, &xl, &yt);
 						was_snapped = True;
 					}
 					if (!delta_x && !delta_y)
@@ -2923,7 +3242,10 @@ Bool __move_loop(
 				FlushAllMessageQueues();
 			}
 		}
+		__frame_rate_end_frame(&frame_rate);
 	} /* while (!is_finished) */
+	__snap_free_edges(&snap_edges);
+	__frame_rate_report(&frame_rate, "__move_loop");
 
 	if (!Scr.gs.do_hide_position_window)
 	{
@@ -3011,6 +3333,22 @@ void CMD_OpaqueMoveSize(F_CMD_ARGS)
 	return;
 }
 
+void CMD_OpaqueFrameRate(F_CMD_ARGS)
+{
+	int val;
+
+	if (GetIntegerArguments(action, NULL, &val, 1) < 1 || val < 0)
+	{
+		Scr.OpaqueFrameRate = DEFAULT_OPAQUE_FRAME_RATE;
+	}
+	else
+	{
+		Scr.OpaqueFrameRate = val;
+	}
+
+	return;
+}
+
 
 static char *hide_options[] =
 {
@@ -3480,12 +3818,14 @@ static void __resize_get_refpos(
  *      orig     - resize internal structure
  *      xmotionp - pointer to xmotion in resize_window
  *      ymotionp - pointer to ymotion in resize_window
+ *      fr       - frame rate statistics of resize_window
  *
  */
 static void __resize_step(
 	const exec_context_t *exc, int x_root, int y_root, int *x_off,
 	int *y_off, rectangle *drag, const rectangle *orig, int *xmotionp,
-	int *ymotionp, Bool do_resize_opaque, Bool is_direction_fixed)
+	int *ymotionp, Bool do_resize_opaque, Bool is_direction_fixed,
+	const frame_rate_t *fr)
 {
 	int action = 0;
 	int x2;
@@ -3616,7 +3956,9 @@ static void __resize_step(
 				drag->height, False);
 		}
 	}
-	DisplaySize(exc->w.fw, exc->x.elast, drag->width, drag->height, False, False);
+	DisplaySize(
+		exc->w.fw, exc->x.elast, drag->width, drag->height, False,
+		False, fr);
 
 	return;
 }
@@ -3662,6 +4004,7 @@ static Bool __resize_window(F_CMD_ARGS)
 	frame_move_resize_args mr_args = NULL;
 	long evmask;
 	XEvent ev;
+	frame_rate_t frame_rate;
 	int ref_x;
 	int ref_y;
 	int x_off;
@@ -3844,7 +4187,10 @@ static Bool __resize_window(F_CMD_ARGS)
 		position_geometry_window(NULL);
 		XMapRaised(dpy, Scr.SizeWindow);
 	}
-	DisplaySize(fw, exc->x.elast, orig->width, orig->height, True, True);
+	__frame_rate_init(&frame_rate);
+	DisplaySize(
+		fw, exc->x.elast, orig->width, orig->height, True, True,
+		&frame_rate);
 
 	if (dir == DIR_NONE && detect_automatic_direction == True)
 	{
@@ -4013,7 +4359,8 @@ static Bool __resize_window(F_CMD_ARGS)
 		yo = 0;
 		__resize_step(
 			exc, stashed_x, stashed_y, &xo, &yo, drag, orig,
-			&xmotion, &ymotion, do_resize_opaque, True);
+			&xmotion, &ymotion, do_resize_opaque, True,
+			&frame_rate);
 	}
 	else
 	{
@@ -4104,6 +4451,11 @@ static Bool __resize_window(F_CMD_ARGS)
 				 * ignore event */
 			}
 		}
+		if (do_resize_opaque && ev.type == MotionNotify &&
+		    !fForceRedraw)
+		{
+			__frame_rate_begin_frame(&frame_rate, &ev);
+		}
 
 		is_done = False;
 		/* Handle a limited number of key press events to allow
@@ -4175,7 +4527,7 @@ static Bool __resize_window(F_CMD_ARGS)
 				__resize_step(
 					exc, x, y, &x_off, &y_off, drag, orig,
 					&xmotion, &ymotion, do_resize_opaque,
-					is_direction_fixed);
+					is_direction_fixed, &frame_rate);
 				is_resized = True;
 				/* need to move the viewport */
 				HandlePaging(
@@ -4194,7 +4546,7 @@ static Bool __resize_window(F_CMD_ARGS)
 				__resize_step(
 					exc, x, y, &x_off, &y_off, drag, orig,
 					&xmotion, &ymotion, do_resize_opaque,
-					is_direction_fixed);
+					is_direction_fixed, &frame_rate);
 				is_resized = True;
 			}
 			fForceRedraw = False;
@@ -4251,7 +4603,9 @@ static Bool __resize_window(F_CMD_ARGS)
 				FlushAllMessageQueues();
 			}
 		}
+		__frame_rate_end_frame(&frame_rate);
 	}
+	__frame_rate_report(&frame_rate, "__resize_window");
 
 	/* erase the rubber-band */
 	if (!do_resize_opaque)
@@ -4291,7 +4645,8 @@ static Bool __resize_window(F_CMD_ARGS)
 			g = sorig;
 			__resize_step(
 				exc, sorig.x, sorig.y, &xo, &yo, &g, orig,
-				&xmotion, &ymotion, do_resize_opaque, True);
+				&xmotion, &ymotion, do_resize_opaque, True,
+				&frame_rate);
 		}
 		if (vx != mon->virtual_scr.Vx || vy != mon->virtual_scr.Vy)
 		{
@@ -5161,6 +5516,7 @@ int stick_across_desks(F_CMD_ARGS, int toggle)
 	{
 		SET_STICKY_ACROSS_DESKS(fw, 0);
 		fw->Desk = fw->m->virtual_scr.CurrentDesk;
+		geom_index_update(fw);
 	}
 	else
 	{
@@ -18,6 +18,10 @@
 #include "config.h"
 
 #include <stdio.h>
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#include <signal.h>
+#endif
 
 #include "libs/fvwmlib.h"
 #include "libs/Grab.h"
@@ -45,6 +49,11 @@
 
 #define MAX_NUM_PLACEMENT_ALGOS 31
 #define CP_GET_NEXT_STEP 5
+/* maximum number of grid cells per row and column of the placement index */
+#define PL_INDEX_MAX_CELLS 32
+#define PL_MAX_THREADS 16
+/* with fewer rows of positions threads are not worth it */
+#define PL_THREAD_MIN_ROWS 8
 
 /* ---------------------------- local macros ------------------------------- */
 
@@ -205,6 +214,53 @@ typedef struct
 		const struct pl_arg_t *arg);
 } pl_algo_t;
 
+/* another window as seen by MinOverlapPlacement */
+typedef struct
+{
+	FvwmWindow *fw;
+	/* visible window or icon geometry, moved for sticky windows */
+	rectangle g;
+	/* the window yields x positions to try if y1 < y < y2 */
+	int x_y1;
+	int x_y2;
+	int num_xs;
+	int xs[2 * (CP_GET_NEXT_STEP + 1)];
+} pl_other_t;
+
+/* The other windows on the desk in a grid over the page, built once per
+ * placement.  Each cell lists the windows that touch it, in the order of
+ * the window list, and each row lists the windows that yield x positions
+ * in it.  The y positions do not depend on the window being placed, so they
+ * are simply sorted. */
+typedef struct pl_index_t
+{
+	pl_other_t *others;
+	int num_others;
+	int x0;
+	int y0;
+	int cell_w;
+	int cell_h;
+	int cols;
+	int rows;
+	/* cell c lists cell_items[cell_start[c]] up to cell_start[c + 1] */
+	int *cell_start;
+	int *cell_items;
+	int *row_start;
+	int *row_items;
+	int *ys;
+	int num_ys;
+	/* no window has a negative placement penalty */
+	unsigned has_no_negative_penalties : 1;
+} pl_index_t;
+
+/* scratch space for queries of a pl_index_t; one per thread */
+typedef struct
+{
+	int *hits;
+	unsigned int *stamps;
+	unsigned int stamp;
+} pl_query_t;
+
 typedef struct pl_scratch_t
 {
 	const pl_penalty_struct *pp;
@@ -219,6 +275,10 @@ typedef struct pl_arg_t
 	pl_reason_t *reason;
 	FvwmWindow *place_fw;
 	pl_scratch_t *scratch;
+	pl_index_t *index;
+	pl_query_t *query;
+	/* the monitor with the pointer, for the working area */
+	struct monitor *strut_m;
 	rectangle place_g;
 	position place_p2;
 	rectangle screen_g;
@@ -243,6 +303,38 @@ typedef struct pl_ret_t
 	} flags;
 } pl_ret_t;
 
+#ifdef HAVE_PTHREAD
+/* the positions with the same y coordinate */
+typedef struct
+{
+	position *candidates;
+	pl_penalty_t *penalties;
+	int num_candidates;
+	int size;
+} pl_row_t;
+
+/* the rows shared by all placement threads */
+typedef struct
+{
+	pthread_mutex_t lock;
+	pl_row_t *rows;
+	int num_rows;
+	/* the next row to hand out */
+	int next;
+	/* the first row with a position without penalty found so far */
+	int first_zero;
+} pl_jobs_t;
+
+typedef struct
+{
+	pl_jobs_t *jobs;
+	pl_arg_t arg;
+	pl_query_t query;
+	pthread_t thread;
+	unsigned is_running : 1;
+} pl_thread_t;
+#endif
+
 /* ---------------------------- forward declarations ----------------------- */
 
 static pl_loop_rc_t __pl_minoverlap_get_first_pos(
@@ -267,6 +359,11 @@ static pl_penalty_t __pl_manual_get_pos_simple(
 
 /* ---------------------------- local variables ---------------------------- */
 
+#ifdef HAVE_PTHREAD
+/* the number of threads that calculate placement penalties */
+static int placement_threads = 0;
+#endif
+
 const pl_algo_t minoverlap_placement_algo =
 {
 	NULL,
@@ -591,60 +688,118 @@ static pl_penalty_t __pl_manual_get_pos_simple(
  * interference, fine.  Otherwise, it places it so that the area of of
  * interference between the new window and the other windows is minimized */
 
-static int __pl_minoverlap_get_next_x(const pl_arg_t *arg)
+static int __pl_index_cell(int v, int v0, int cell_size, int num_cells)
 {
-	FvwmWindow *other_fw;
-	int xnew;
-	int xtest;
-	int stickyx;
-	int stickyy;
-	int start,i;
-	int win_left;
-	rectangle g;
-	Bool rc;
-	int x;
-	int y;
-	struct monitor	*m = NULL;
+	int c;
 
-	m = (arg->place_fw && arg->place_fw->m) ?
-	    arg->place_fw->m : monitor_get_current();
-	x = arg->place_g.x;
-	y = arg->place_g.y;
-	if (arg->flags.use_percent == 1)
+	c = (v - v0) / cell_size;
+	if (c < 0)
 	{
-		start = 0;
+		return 0;
 	}
-	else
+	if (c >= num_cells)
 	{
-		start = CP_GET_NEXT_STEP;
+		return num_cells - 1;
 	}
 
-	/* Test window at far right of screen */
-	xnew = arg->page_p2.x;
-	xtest = arg->page_p2.x - arg->place_g.width;
-	if (xtest > x)
+	return c;
+}
+
+static int __pl_index_cmp_int(const void *a, const void *b)
+{
+	return *(const int *)a - *(const int *)b;
+}
+
+/* the x positions next to a window at win_x that is win_width pixels wide,
+ * see __pl_minoverlap_get_next_x() */
+static void __pl_index_set_xs(
+	pl_other_t *o, const pl_arg_t *arg, int win_x, int win_width,
+	int start)
+{
+	int i;
+
+	o->num_xs = 0;
+	for (i = start; i <= CP_GET_NEXT_STEP; i++)
 	{
-		xnew = xtest;
+		o->xs[o->num_xs++] = win_x - arg->place_g.width +
+			win_width * (CP_GET_NEXT_STEP - i) / CP_GET_NEXT_STEP;
 	}
-	/* test the borders of the working area */
-	xtest = arg->page_p1.x + m->Desktops->ewmh_working_area.x;
-	if (xtest > x)
+	for (i = start; i <= CP_GET_NEXT_STEP; i++)
 	{
-		xnew = MIN(xnew, xtest);
+		o->xs[o->num_xs++] = win_x +
+			win_width * i / CP_GET_NEXT_STEP;
 	}
-	xtest = arg->page_p1.x +
-		(m->Desktops->ewmh_working_area.x +
-		 m->Desktops->ewmh_working_area.width) -
-		arg->place_g.width;
-	if (xtest > x)
+
+	return;
+}
+
+/* the y positions next to a window at win_y that is win_height pixels
+ * high, see __pl_minoverlap_get_next_y() */
+static void __pl_index_add_ys(
+	pl_index_t *index, const pl_arg_t *arg, int win_y, int win_height,
+	int start)
+{
+	int i;
+
+	for (i = start; i <= CP_GET_NEXT_STEP; i++)
 	{
-		xnew = MIN(xnew, xtest);
+		index->ys[index->num_ys++] = win_y +
+			win_height * i / CP_GET_NEXT_STEP;
 	}
-	/* Test the values of the right edges of every window */
+	for (i = start; i <= CP_GET_NEXT_STEP; i++)
+	{
+		index->ys[index->num_ys++] = win_y - arg->place_g.height +
+			win_height * (CP_GET_NEXT_STEP - i) /
+			CP_GET_NEXT_STEP;
+	}
+
+	return;
+}
+
+static Bool __pl_has_negative_penalty(const FvwmWindow *fw)
+{
+	const pl_penalty_struct *pp = &fw->pl_penalty;
+	const pl_percent_penalty_struct *ppp = &fw->pl_percent_penalty;
+
+	return (
+		pp->normal < 0 || pp->ontop < 0 || pp->icon < 0 ||
+		pp->sticky < 0 || pp->below < 0 || pp->strut < 0 ||
+		ppp->p99 < 0 || ppp->p95 < 0 || ppp->p85 < 0 || ppp->p75 < 0);
+}
+
+static pl_index_t *__pl_index_create(const pl_arg_t *arg)
+{
+	pl_index_t *index;
+	FvwmWindow *other_fw;
+	int *fill;
+	int start;
+	int n;
+	int i;
+	int r;
+	int c;
+
+	start = (arg->flags.use_percent == 1) ? 0 : CP_GET_NEXT_STEP;
+	for (
+		n = 0, other_fw = Scr.FvwmRoot.next; other_fw != NULL;
+		other_fw = other_fw->next)
+	{
+		n++;
+	}
+	index = fxcalloc(1, sizeof(pl_index_t));
+	index->others = fxcalloc(n + 1, sizeof(pl_other_t));
+	index->ys = fxcalloc(
+		(n + 1) * 2 * (CP_GET_NEXT_STEP + 1), sizeof(int));
+	index->has_no_negative_penalties =
+		!__pl_has_negative_penalty(arg->place_fw);
 	for (
 		other_fw = Scr.FvwmRoot.next; other_fw != NULL;
 		other_fw = other_fw->next)
 	{
+		pl_other_t *o;
+		rectangle g;
+		int stickyx;
+		int stickyy;
+
 		if (
 			other_fw == arg->place_fw ||
 			(other_fw->Desk != arg->place_fw->Desk &&
@@ -653,6 +808,12 @@ static int __pl_minoverlap_get_next_x(const pl_arg_t *arg)
 		{
 			continue;
 		}
+		o = &index->others[index->num_others++];
+		o->fw = other_fw;
+		if (__pl_has_negative_penalty(other_fw))
+		{
+			index->has_no_negative_penalties = 0;
+		}
 		if (IS_STICKY_ACROSS_PAGES(other_fw))
 		{
 			stickyx = arg->pdelta_p.x;
@@ -663,97 +824,313 @@ static int __pl_minoverlap_get_next_x(const pl_arg_t *arg)
 			stickyx = 0;
 			stickyy = 0;
 		}
+		(void)get_visible_window_or_icon_geometry(other_fw, &o->g);
+		o->g.x -= stickyx;
+		o->g.y -= stickyy;
 		if (IS_ICONIFIED(other_fw))
 		{
+			Bool rc;
+
 			rc = get_visible_icon_geometry(other_fw, &g);
-			if (rc == True && y < g.y + g.height - stickyy &&
-			    g.y - stickyy < arg->place_g.height + y)
+			if (rc == True)
 			{
-				win_left = arg->page_p1.x + g.x - stickyx -
-					arg->place_g.width;
-				for (i = start; i <= CP_GET_NEXT_STEP; i++)
+				__pl_index_set_xs(
+					o, arg, arg->page_p1.x + g.x - stickyx,
+					g.width, start);
+			}
+		}
+		else
+		{
+			g = other_fw->g.frame;
+			if (
+				arg->page_p1.x < g.width + g.x - stickyx &&
+				g.x - stickyx < arg->page_p2.x)
+			{
+				__pl_index_set_xs(
+					o, arg, g.x - stickyx, g.width, start);
+			}
+		}
+		o->x_y1 = g.y - stickyy - arg->place_g.height;
+		o->x_y2 = g.y + g.height - stickyy;
+		__pl_index_add_ys(index, arg, g.y - stickyy, g.height, start);
+	}
+	qsort(index->ys, index->num_ys, sizeof(int), __pl_index_cmp_int);
+	/* about one window per cell */
+	for (
+		index->cols = 1;
+		index->cols * index->cols < index->num_others &&
+			index->cols < PL_INDEX_MAX_CELLS;
+		index->cols++)
+	{
+		/* nothing */
+	}
+	index->rows = index->cols;
+	index->x0 = arg->page_p1.x;
+	index->y0 = arg->page_p1.y;
+	index->cell_w = (arg->page_p2.x - arg->page_p1.x) / index->cols + 1;
+	index->cell_h = (arg->page_p2.y - arg->page_p1.y) / index->rows + 1;
+	index->cell_w = MAX(index->cell_w, 1);
+	index->cell_h = MAX(index->cell_h, 1);
+	/* count the entries first, then fill them in */
+	index->cell_start = fxcalloc(
+		index->rows * index->cols + 1, sizeof(int));
+	index->row_start = fxcalloc(index->rows + 1, sizeof(int));
+	for (n = 0; n < 2; n++)
+	{
+		if (n == 1)
+		{
+			for (i = 0; i < index->rows * index->cols; i++)
+			{
+				index->cell_start[i + 1] +=
+					index->cell_start[i];
+			}
+			for (i = 0; i < index->rows; i++)
+			{
+				index->row_start[i + 1] += index->row_start[i];
+			}
+			index->cell_items = fxcalloc(
+				index->cell_start[index->rows * index->cols] +
+				1, sizeof(int));
+			index->row_items = fxcalloc(
+				index->row_start[index->rows] + 1,
+				sizeof(int));
+			fill = fxcalloc(
+				index->rows * index->cols + index->rows,
+				sizeof(int));
+			memcpy(
+				fill, index->cell_start,
+				index->rows * index->cols * sizeof(int));
+			memcpy(
+				fill + index->rows * index->cols,
+				index->row_start, index->rows * sizeof(int));
+		}
+		for (i = 0; i < index->num_others; i++)
+		{
+			pl_other_t *o = &index->others[i];
+			int c1;
+			int c2;
+			int r1;
+			int r2;
+
+			/* the rectangle including its right and bottom edge,
+			 * so that it is found by a query for a rectangle that
+			 * overlaps it */
+			c1 = __pl_index_cell(
+				o->g.x, index->x0, index->cell_w, index->cols);
+			c2 = __pl_index_cell(
+				o->g.x + o->g.width, index->x0, index->cell_w,
+				index->cols);
+			r1 = __pl_index_cell(
+				o->g.y, index->y0, index->cell_h, index->rows);
+			r2 = __pl_index_cell(
+				o->g.y + o->g.height, index->y0, index->cell_h,
+				index->rows);
+			for (r = r1; r <= r2; r++)
+			{
+				for (c = c1; c <= c2; c++)
 				{
-					xtest = win_left + g.width *
-						(CP_GET_NEXT_STEP - i) /
-						CP_GET_NEXT_STEP;
-					if (xtest > x)
+					int cell = r * index->cols + c;
+
+					if (n == 0)
 					{
-						xnew = MIN(xnew, xtest);
+						index->cell_start[cell + 1]++;
 					}
-				}
-				win_left = arg->page_p1.x + g.x - stickyx;
-				for (i = start; i <= CP_GET_NEXT_STEP; i++)
-				{
-					xtest = (win_left) + g.width * i /
-						CP_GET_NEXT_STEP;
-					if (xtest > x)
+					else
 					{
-						xnew = MIN(xnew, xtest);
+						index->cell_items[
+							fill[cell]++] = i;
 					}
 				}
 			}
-		}
-		else if (
-			y < other_fw->g.frame.height + other_fw->g.frame.y -
-			stickyy &&
-			other_fw->g.frame.y - stickyy <
-			arg->place_g.height + y &&
-			arg->page_p1.x < other_fw->g.frame.width +
-			other_fw->g.frame.x - stickyx &&
-			other_fw->g.frame.x - stickyx < arg->page_p2.x)
-		{
-			win_left =
-				other_fw->g.frame.x - stickyx -
-				arg->place_g.width;
-			for (i = start; i <= CP_GET_NEXT_STEP; i++)
+			if (o->num_xs == 0 || o->x_y1 + 1 > o->x_y2 - 1)
+			{
+				continue;
+			}
+			r1 = __pl_index_cell(
+				o->x_y1 + 1, index->y0, index->cell_h,
+				index->rows);
+			r2 = __pl_index_cell(
+				o->x_y2 - 1, index->y0, index->cell_h,
+				index->rows);
+			for (r = r1; r <= r2; r++)
 			{
-				xtest = win_left + other_fw->g.frame.width *
-					(CP_GET_NEXT_STEP - i) /
-					CP_GET_NEXT_STEP;
-				if (xtest > x)
+				if (n == 0)
+				{
+					index->row_start[r + 1]++;
+				}
+				else
 				{
-					xnew = MIN(xnew, xtest);
+					index->row_items[
+						fill[index->rows * index->cols +
+						     r]++] = i;
 				}
 			}
-			win_left = other_fw->g.frame.x - stickyx;
-			for (i = start; i <= CP_GET_NEXT_STEP; i++)
+		}
+	}
+	free(fill);
+
+	return index;
+}
+
+static void __pl_index_destroy(pl_index_t *index)
+{
+	free(index->others);
+	free(index->ys);
+	free(index->cell_start);
+	free(index->cell_items);
+	free(index->row_start);
+	free(index->row_items);
+	free(index);
+
+	return;
+}
+
+static void __pl_query_init(pl_query_t *query, const pl_index_t *index)
+{
+	query->hits = fxcalloc(index->num_others + 1, sizeof(int));
+	query->stamps = fxcalloc(
+		index->num_others + 1, sizeof(unsigned int));
+	query->stamp = 0;
+
+	return;
+}
+
+static void __pl_query_free(pl_query_t *query)
+{
+	free(query->hits);
+	free(query->stamps);
+
+	return;
+}
+
+/* Stores the windows that may overlap the rectangle from (x1, y1) to
+ * (x2, y2) in query->hits, in the order of the window list, and returns
+ * their number. */
+static int __pl_index_query(
+	const pl_index_t *index, pl_query_t *query, int x1, int y1, int x2,
+	int y2)
+{
+	int c1;
+	int c2;
+	int r1;
+	int r2;
+	int r;
+	int c;
+	int n;
+
+	query->stamp++;
+	if (query->stamp == 0)
+	{
+		memset(
+			query->stamps, 0,
+			index->num_others * sizeof(unsigned int));
+		query->stamp = 1;
+	}
+	c1 = __pl_index_cell(x1, index->x0, index->cell_w, index->cols);
+	c2 = __pl_index_cell(x2, index->x0, index->cell_w, index->cols);
+	r1 = __pl_index_cell(y1, index->y0, index->cell_h, index->rows);
+	r2 = __pl_index_cell(y2, index->y0, index->cell_h, index->rows);
+	n = 0;
+	for (r = r1; r <= r2; r++)
+	{
+		for (c = c1; c <= c2; c++)
+		{
+			int cell = r * index->cols + c;
+			int k;
+
+			for (
+				k = index->cell_start[cell];
+				k < index->cell_start[cell + 1]; k++)
 			{
-				xtest = win_left + other_fw->g.frame.width *
-					i / CP_GET_NEXT_STEP;
-				if (xtest > x)
+				int i = index->cell_items[k];
+
+				if (query->stamps[i] != query->stamp)
 				{
-					xnew = MIN(xnew, xtest);
+					query->stamps[i] = query->stamp;
+					query->hits[n++] = i;
 				}
 			}
 		}
 	}
+	if (n > 1 && (c1 != c2 || r1 != r2))
+	{
+		qsort(query->hits, n, sizeof(int), __pl_index_cmp_int);
+	}
 
-	return xnew;
+	return n;
 }
 
-static int __pl_minoverlap_get_next_y(const pl_arg_t *arg)
+static int __pl_minoverlap_get_next_x(const pl_arg_t *arg)
 {
-	FvwmWindow *other_fw;
-	int ynew;
-	int ytest;
-	int stickyy;
-	int win_top;
-	int start;
-	int i;
-	rectangle g;
+	pl_index_t *index = arg->index;
+	int xnew;
+	int xtest;
+	int r;
+	int k;
+	int x;
 	int y;
-	struct monitor	*mon;
+	struct monitor	*m = NULL;
 
+	m = (arg->place_fw && arg->place_fw->m) ?
+	    arg->place_fw->m : monitor_get_current();
+	x = arg->place_g.x;
 	y = arg->place_g.y;
-	if (arg->flags.use_percent == 1)
+
+	/* Test window at far right of screen */
+	xnew = arg->page_p2.x;
+	xtest = arg->page_p2.x - arg->place_g.width;
+	if (xtest > x)
+	{
+		xnew = xtest;
+	}
+	/* test the borders of the working area */
+	xtest = arg->page_p1.x + m->Desktops->ewmh_working_area.x;
+	if (xtest > x)
 	{
-		start = 0;
+		xnew = MIN(xnew, xtest);
 	}
-	else
+	xtest = arg->page_p1.x +
+		(m->Desktops->ewmh_working_area.x +
+		 m->Desktops->ewmh_working_area.width) -
+		arg->place_g.width;
+	if (xtest > x)
+	{
+		xnew = MIN(xnew, xtest);
+	}
+	/* Test the values of the right edges of every window in this row */
+	r = __pl_index_cell(y, index->y0, index->cell_h, index->rows);
+	for (k = index->row_start[r]; k < index->row_start[r + 1]; k++)
 	{
-		start = CP_GET_NEXT_STEP;
+		pl_other_t *o = &index->others[index->row_items[k]];
+		int i;
+
+		if (y <= o->x_y1 || y >= o->x_y2)
+		{
+			continue;
+		}
+		for (i = 0; i < o->num_xs; i++)
+		{
+			if (o->xs[i] > x)
+			{
+				xnew = MIN(xnew, o->xs[i]);
+			}
+		}
 	}
 
+	return xnew;
+}
+
+static int __pl_minoverlap_get_next_y(const pl_arg_t *arg)
+{
+	pl_index_t *index = arg->index;
+	int ynew;
+	int ytest;
+	int y;
+	int lo;
+	int hi;
+	struct monitor	*mon;
+
+	y = arg->place_g.y;
 	mon = (arg->place_fw && arg->place_fw->m) ?
 	    arg->place_fw->m : monitor_get_current();
 
@@ -778,85 +1155,25 @@ static int __pl_minoverlap_get_next_y(const pl_arg_t *arg)
 	{
 		ynew = MIN(ynew, ytest);
 	}
-	/* Test the values of the bottom edge of every window */
-	for (
-		other_fw = Scr.FvwmRoot.next; other_fw != NULL;
-		other_fw = other_fw->next)
+	/* Test the values of the bottom edge of every window; the smallest
+	 * one greater than y */
+	for (lo = 0, hi = index->num_ys; lo < hi; )
 	{
-		if (
-			other_fw == arg->place_fw ||
-			(
-				other_fw->Desk != arg->place_fw->Desk &&
-				!IS_STICKY_ACROSS_DESKS(other_fw)) ||
-			IS_EWMH_DESKTOP(FW_W(other_fw)))
-		{
-			continue;
-		}
-
-		if (IS_STICKY_ACROSS_PAGES(other_fw))
-		{
-			stickyy = arg->pdelta_p.y;
-		}
-		else
-		{
-			stickyy = 0;
-		}
+		int mid = (lo + hi) / 2;
 
-		if (IS_ICONIFIED(other_fw))
+		if (index->ys[mid] <= y)
 		{
-			get_visible_icon_geometry(other_fw, &g);
-			win_top = g.y - stickyy;
-			for (i = start; i <= CP_GET_NEXT_STEP; i++)
-			{
-				ytest =
-					win_top + g.height * i /
-					CP_GET_NEXT_STEP;
-				if (ytest > y)
-				{
-					ynew = MIN(ynew, ytest);
-				}
-			}
-			win_top = g.y - stickyy - arg->place_g.height;
-			for (i = start; i <= CP_GET_NEXT_STEP; i++)
-			{
-				ytest =
-					win_top + g.height *
-					(CP_GET_NEXT_STEP - i) /
-					CP_GET_NEXT_STEP;
-				if (ytest > y)
-				{
-					ynew = MIN(ynew, ytest);
-				}
-			}
+			lo = mid + 1;
 		}
 		else
 		{
-			win_top = other_fw->g.frame.y - stickyy;
-			for (i = start; i <= CP_GET_NEXT_STEP; i++)
-			{
-				ytest =
-					win_top + other_fw->g.frame.height *
-					i / CP_GET_NEXT_STEP;
-				if (ytest > y)
-				{
-					ynew = MIN(ynew, ytest);
-				}
-			}
-			win_top = other_fw->g.frame.y - stickyy -
-				arg->place_g.height;
-			for (i = start; i <= CP_GET_NEXT_STEP; i++)
-			{
-				ytest =
-					win_top + other_fw->g.frame.height *
-					(CP_GET_NEXT_STEP - i) /
-					CP_GET_NEXT_STEP;
-				if (ytest > y)
-				{
-					ynew = MIN(ynew, ytest);
-				}
-			}
+			hi = mid;
 		}
 	}
+	if (lo < index->num_ys)
+	{
+		ynew = MIN(ynew, index->ys[lo]);
+	}
 
 	return ynew;
 }
@@ -1004,52 +1321,39 @@ static pl_penalty_t __pl_minoverlap_get_avoidance_penalty(
 static pl_penalty_t __pl_minoverlap_get_pos_penalty(
 	position *ret_hint_p, struct pl_ret_t *ret, const struct pl_arg_t *arg)
 {
-	FvwmWindow *other_fw;
+	pl_index_t *index = arg->index;
 	pl_penalty_t penalty;
-	size_borders b;
+	int num_hits;
+	int k;
 
 	penalty = 0;
-	for (
-		other_fw = Scr.FvwmRoot.next; other_fw != NULL;
-		other_fw = other_fw->next)
+	/* sticky windows are already accounted for in the index */
+	num_hits = __pl_index_query(
+		index, arg->query, arg->place_g.x, arg->place_g.y,
+		arg->place_p2.x, arg->place_p2.y);
+	for (k = 0; k < num_hits; k++)
 	{
-		rectangle other_g;
-		get_window_borders(other_fw, &b);
+		pl_other_t *o = &index->others[arg->query->hits[k]];
+		const rectangle *other_g = &o->g;
 
 		if (
-			arg->place_fw == other_fw ||
-			IS_EWMH_DESKTOP(FW_W(other_fw)))
-		{
-			continue;
-		}
-		/*  RBW - account for sticky windows...  */
-		if (
-			other_fw->Desk != arg->place_fw->Desk &&
-			IS_STICKY_ACROSS_DESKS(other_fw) == 0)
-		{
-			continue;
-		}
-		(void)get_visible_window_or_icon_geometry(other_fw, &other_g);
-		if (IS_STICKY_ACROSS_PAGES(other_fw))
-		{
-			other_g.x -= arg->pdelta_p.x;
-			other_g.y -= arg->pdelta_p.y;
-		}
-		if (
-			arg->place_g.x < other_g.x + other_g.width &&
-			arg->place_p2.x > other_g.x &&
-			arg->place_g.y < other_g.y + other_g.height &&
-			arg->place_p2.y > other_g.y)
+			arg->place_g.x < other_g->x + other_g->width &&
+			arg->place_p2.x > other_g->x &&
+			arg->place_g.y < other_g->y + other_g->height &&
+			arg->place_p2.y > other_g->y)
 		{
 			pl_penalty_t anew;
 
 			anew = __pl_minoverlap_get_avoidance_penalty(
-				arg, other_fw, &other_g);
+				arg, o->fw, other_g);
 			penalty += anew;
 			if (
 				penalty > ret->best_penalty &&
 				ret->best_penalty != -1)
 			{
+				size_borders b;
+
+				get_window_borders(o->fw, &b);
 				/* TA:  20091230:  Fix over-zealous penalties
 				 * by explicitly forcing the window on-screen
 				 * here.  The y-axis is only affected here,
@@ -1086,7 +1390,7 @@ static pl_penalty_t __pl_minoverlap_get_pos_penalty(
 		{
 			penalty += EWMH_STRUT_PLACEMENT_PENALTY(mypp) *
 				EWMH_GetStrutIntersection(
-					arg->place_g.x, arg->place_g.y,
+					arg->strut_m, arg->place_g.x, arg->place_g.y,
 					arg->place_p2.x, arg->place_p2.y,
 					arg->flags.use_percent);
 		}
@@ -1097,7 +1401,7 @@ static pl_penalty_t __pl_minoverlap_get_pos_penalty(
 			penalty +=
 				EWMH_STRUT_PLACEMENT_PENALTY(mypp) *
 				EWMH_GetBaseStrutIntersection(
-					arg->place_g.x, arg->place_g.y,
+					arg->strut_m, arg->place_g.x, arg->place_g.y,
 					arg->place_p2.x, arg->place_p2.y,
 					arg->flags.use_percent);
 		}
@@ -1126,11 +1430,270 @@ static pl_penalty_t __pl_smart_get_pos_penalty(
 
 /* ---------------------------- local functions ---------------------------- */
 
+#ifdef HAVE_PTHREAD
+/* Returns 1 if the penalties of all positions can be calculated in any
+ * order and still yield the same position as placement_loop(). */
+static int __pl_can_use_threads(const pl_arg_t *arg)
+{
+	if (
+		placement_threads < 2 ||
+		!arg->index->has_no_negative_penalties)
+	{
+		return 0;
+	}
+	/* the threads must not ask the X server for the monitor */
+	if (arg->place_fw->m == NULL)
+	{
+		return 0;
+	}
+	/* __pl_minoverlap_get_pos_penalty() may move the best position of
+	 * a window that is higher than the page */
+	if (arg->page_p1.y + arg->place_g.height > arg->page_p2.y)
+	{
+		return 0;
+	}
+
+	return 1;
+}
+
+static void __pl_row_add(pl_row_t *row, position p)
+{
+	if (row->num_candidates == row->size)
+	{
+		row->size = (row->size == 0) ? 16 : 2 * row->size;
+		row->candidates = fxrealloc(
+			(void *)row->candidates, row->size, sizeof(position));
+		row->penalties = fxrealloc(
+			(void *)row->penalties, row->size,
+			sizeof(pl_penalty_t));
+	}
+	row->candidates[row->num_candidates++] = p;
+
+	return;
+}
+
+static void *__pl_thread_main(void *data)
+{
+	pl_thread_t *t = data;
+	pl_jobs_t *jobs = t->jobs;
+	pl_ret_t bound;
+
+	/* The lowest penalty of a position before the current one is an
+	 * upper bound for the best penalty placement_loop() would have at
+	 * the current position.  A position whose penalty exceeds it is not
+	 * picked, so its penalty may be cut short.  The rows are handed out
+	 * in order, so every position of this thread is an earlier one. */
+	memset(&bound, 0, sizeof(bound));
+	bound.best_penalty = -1;
+	for (;;)
+	{
+		pl_row_t *row;
+		position p;
+		int r;
+
+		pthread_mutex_lock(&jobs->lock);
+		r = jobs->next;
+		if (r >= jobs->num_rows || r > jobs->first_zero)
+		{
+			pthread_mutex_unlock(&jobs->lock);
+			break;
+		}
+		jobs->next++;
+		pthread_mutex_unlock(&jobs->lock);
+		row = &jobs->rows[r];
+		for (p = row->candidates[0]; ; )
+		{
+			pl_ret_t ret;
+			pl_scratch_t scratch;
+			position hint_p;
+			position next_p;
+			pl_penalty_t penalty;
+
+			ret = bound;
+			memset(&scratch, 0, sizeof(scratch));
+			t->arg.scratch = &scratch;
+			t->arg.place_g.x = p.x;
+			t->arg.place_g.y = p.y;
+			t->arg.place_p2.x = p.x + t->arg.place_g.width;
+			t->arg.place_p2.y = p.y + t->arg.place_g.height;
+			hint_p = p;
+			penalty = t->arg.algo->get_pos_penalty(
+				&hint_p, &ret, &t->arg);
+			row->penalties[row->num_candidates - 1] = penalty;
+			if (
+				penalty >= 0 &&
+				(
+					bound.best_penalty < 0 ||
+					penalty < bound.best_penalty))
+			{
+				bound.best_p = p;
+				bound.best_penalty = penalty;
+			}
+			if (penalty == 0)
+			{
+				/* later positions are not needed */
+				pthread_mutex_lock(&jobs->lock);
+				jobs->first_zero = MIN(jobs->first_zero, r);
+				pthread_mutex_unlock(&jobs->lock);
+				break;
+			}
+			if (
+				t->arg.algo->get_next_pos(
+					&next_p, &ret, &t->arg, hint_p) ==
+				PL_LOOP_END ||
+				next_p.y != p.y)
+			{
+				/* end of the row */
+				break;
+			}
+			p = next_p;
+			__pl_row_add(row, p);
+		}
+	}
+
+	return NULL;
+}
+
+/* Calculates the penalties of the positions in several threads, one row of
+ * positions at a time, then picks the position placement_loop() would have
+ * picked, with the same ties.  Returns 0 if the positions should be tried
+ * one by one instead. */
+static int __pl_loop_in_threads(
+	pl_ret_t *ret, pl_arg_t *arg, position first_p)
+{
+	pl_jobs_t jobs;
+	pl_thread_t threads[PL_MAX_THREADS];
+	position p;
+	sigset_t all_signals;
+	sigset_t old_signals;
+	int num_threads;
+	int size;
+	int r;
+	int i;
+
+	if (!__pl_can_use_threads(arg))
+	{
+		return 0;
+	}
+	/* The rows do not depend on the penalties.  A position right of the
+	 * page makes get_next_pos() start the next row. */
+	memset(&jobs, 0, sizeof(jobs));
+	size = 0;
+	for (p = first_p; ; )
+	{
+		if (jobs.num_rows == size)
+		{
+			size = (size == 0) ? 64 : 2 * size;
+			jobs.rows = fxrealloc(
+				(void *)jobs.rows, size, sizeof(pl_row_t));
+		}
+		memset(&jobs.rows[jobs.num_rows], 0, sizeof(pl_row_t));
+		__pl_row_add(&jobs.rows[jobs.num_rows], p);
+		jobs.num_rows++;
+		arg->place_g.x = arg->page_p2.x;
+		arg->place_g.y = p.y;
+		if (arg->algo->get_next_pos(&p, ret, arg, p) == PL_LOOP_END)
+		{
+			break;
+		}
+	}
+	num_threads = MIN(placement_threads, jobs.num_rows);
+	if (jobs.num_rows < PL_THREAD_MIN_ROWS)
+	{
+		num_threads = 0;
+	}
+	pthread_mutex_init(&jobs.lock, NULL);
+	jobs.first_zero = jobs.num_rows;
+	for (i = 0; i < num_threads; i++)
+	{
+		threads[i].jobs = &jobs;
+		threads[i].arg = *arg;
+		threads[i].arg.query = &threads[i].query;
+		__pl_query_init(&threads[i].query, arg->index);
+		threads[i].is_running = 0;
+	}
+	/* signals are handled by the main thread only */
+	sigfillset(&all_signals);
+	pthread_sigmask(SIG_SETMASK, &all_signals, &old_signals);
+	for (i = 1; i < num_threads; i++)
+	{
+		if (pthread_create(
+			    &threads[i].thread, NULL, __pl_thread_main,
+			    &threads[i]) == 0)
+		{
+			threads[i].is_running = 1;
+		}
+	}
+	pthread_sigmask(SIG_SETMASK, &old_signals, NULL);
+	if (num_threads > 0)
+	{
+		/* if a thread could not be started the others do its share */
+		__pl_thread_main(&threads[0]);
+	}
+	for (i = 0; i < num_threads; i++)
+	{
+		if (threads[i].is_running)
+		{
+			pthread_join(threads[i].thread, NULL);
+		}
+		__pl_query_free(&threads[i].query);
+	}
+	pthread_mutex_destroy(&jobs.lock);
+	/* pick the best position as placement_loop() does */
+	for (r = 0; num_threads > 0 && r < jobs.num_rows; r++)
+	{
+		pl_row_t *row = &jobs.rows[r];
+
+		for (i = 0; i < row->num_candidates; i++)
+		{
+			pl_penalty_t penalty = row->penalties[i];
+
+			if (
+				penalty >= 0 &&
+				(
+					ret->best_penalty < 0 ||
+					penalty + 0.0001 < ret->best_penalty))
+			{
+				ret->best_p = row->candidates[i];
+				ret->best_penalty = penalty;
+			}
+			if (penalty == 0)
+			{
+				p = row->candidates[i];
+				break;
+			}
+		}
+		if (i < row->num_candidates)
+		{
+			break;
+		}
+	}
+	for (r = 0; r < jobs.num_rows; r++)
+	{
+		free(jobs.rows[r].candidates);
+		free(jobs.rows[r].penalties);
+	}
+	free(jobs.rows);
+	if (num_threads == 0)
+	{
+		arg->place_g.x = first_p.x;
+		arg->place_g.y = first_p.y;
+
+		return 0;
+	}
+	arg->place_g.x = p.x;
+	arg->place_g.y = p.y;
+
+	return 1;
+}
+#endif
+
 static int placement_loop(pl_ret_t *ret, pl_arg_t *arg)
 {
 	position next_p;
 	pl_penalty_t penalty;
 	pl_loop_rc_t loop_rc;
+	pl_query_t query;
 
 	if (arg->algo->get_pos_simple != NULL)
 	{
@@ -1146,11 +1709,23 @@ static int placement_loop(pl_ret_t *ret, pl_arg_t *arg)
 	}
 	else
 	{
+		arg->index = __pl_index_create(arg);
+		__pl_query_init(&query, arg->index);
+		arg->query = &query;
+		arg->strut_m = monitor_get_current();
 		loop_rc = arg->algo->get_first_pos(&next_p, ret, arg);
 		arg->place_g.x = next_p.x;
 		arg->place_g.y = next_p.y;
 		ret->best_p.x = next_p.x;
 		ret->best_p.y = next_p.y;
+#ifdef HAVE_PTHREAD
+		if (
+			loop_rc != PL_LOOP_END &&
+			__pl_loop_in_threads(ret, arg, next_p))
+		{
+			loop_rc = PL_LOOP_END;
+		}
+#endif
 	}
 	while (loop_rc != PL_LOOP_END)
 	{
@@ -1184,6 +1759,13 @@ static int placement_loop(pl_ret_t *ret, pl_arg_t *arg)
 		arg->place_g.x = next_p.x;
 		arg->place_g.y = next_p.y;
 	}
+	if (arg->index != NULL)
+	{
+		__pl_query_free(&query);
+		__pl_index_destroy(arg->index);
+		arg->index = NULL;
+		arg->query = NULL;
+	}
 	if (ret->best_penalty < 0)
 	{
 		ret->best_penalty = -1;
@@ -2389,3 +2971,25 @@ void CMD_PlaceAgain(F_CMD_ARGS)
 
 	return;
 }
+
+void CMD_PlacementThreads(F_CMD_ARGS)
+{
+	int val;
+
+	if (GetIntegerArguments(action, NULL, &val, 1) < 1 || val < 0)
+	{
+		val = 0;
+	}
+#ifdef HAVE_PTHREAD
+	placement_threads = MIN(val, PL_MAX_THREADS);
+#else
+	if (val > 1)
+	{
+		fvwm_msg(
+			WARN, "CMD_PlacementThreads",
+			"fvwm was built without thread support");
+	}
+#endif
+
+	return;
+}
@@ -26,6 +26,7 @@
 
 #include "libs/Parse.h"
 #include "libs/Strings.h"
+#include "libs/fpoll.h"
 #include "fvwm.h"
 #include "externs.h"
 #include "cursor.h"
@@ -361,7 +362,9 @@ void CMD_PipeRead(F_CMD_ARGS)
 		return;
 	}
 	cursor_control(True);
+	fpoll_restore_signals();
 	f = popen(command, "r");
+	fpoll_block_signals();
 	if (f == NULL)
 	{
 		if (cond_rc != NULL)
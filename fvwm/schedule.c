@@ -180,9 +180,8 @@ static void execute_obj_func(void *object, void *args)
 
 		ecc.type = EXCT_SCHEDULE;
 		ecc.w.wcontext = C_ROOT;
-		if (XFindContext(
-			    dpy, obj->window, FvwmContext,
-			    (caddr_t *)&ecc.w.fw) != XCNOENT)
+		if (wintable_find(
+			    FvwmWindowTable, obj->window, (void **)&ecc.w.fw))
 		{
 			ecc.w.wcontext = C_WINDOW;
 			mask |= ECC_FW;
@@ -401,6 +401,8 @@ typedef struct ScreenInfo
 	int ScrollDelay;
 	int MoveThreshold;
 	int OpaqueSize;
+	/* frames per second of opaque moves and resizes, 0 = unlimited */
+	int OpaqueFrameRate;
 	/* colormap focus style */
 	int ColormapFocus;
 	/* Limit on colors used in pixmaps */
@@ -426,6 +428,7 @@ typedef struct ScreenInfo
 		unsigned is_modality_evil : 1;
 		unsigned is_raise_hack_needed : 1;
 		unsigned do_debug_randr : 1;
+		unsigned do_debug_frame_rate : 1;
 	} bo; /* bug workaround control options */
 	struct
 	{
@@ -31,8 +31,10 @@
 
 #include "libs/fvwmlib.h"
 #include "libs/FSMlib.h"
+#include "libs/FProperty.h"
 #include "libs/Strings.h"
 #include "libs/System.h"
+#include "libs/fpoll.h"
 #include "fvwm.h"
 #include "externs.h"
 #include "execcontext.h"
@@ -277,7 +279,7 @@ GetWindowRole(Window window)
 {
 	XTextProperty tp;
 
-	if (XGetTextProperty (dpy, window, &tp, _XA_WM_WINDOW_ROLE))
+	if (FGetTextProperty(dpy, window, &tp, _XA_WM_WINDOW_ROLE))
 	{
 		if (tp.encoding == XA_STRING && tp.format == 8 &&
 		    tp.nitems != 0)
@@ -285,7 +287,7 @@ GetWindowRole(Window window)
 			return ((char *) tp.value);
 		}
 	}
-	if (XGetTextProperty (dpy, window, &tp, _XA_WINDOW_ROLE))
+	if (FGetTextProperty(dpy, window, &tp, _XA_WINDOW_ROLE))
 	{
 		if (tp.encoding == XA_STRING && tp.format == 8 &&
 		    tp.nitems != 0)
@@ -312,7 +314,7 @@ GetClientID(FvwmWindow *fw)
 
 	window = FW_W(fw);
 
-	if (XGetWindowProperty(
+	if (FGetWindowProperty(
 		    dpy, window, _XA_WM_CLIENT_LEADER, 0L, 1L, False,
 		    AnyPropertyType, &actual_type, &actual_format, &nitems,
 		    &bytes_after, &prop) == Success)
@@ -751,9 +753,11 @@ static int save_state_file(char *filename)
 		return 0;
 
 #ifdef FVWM_SM_DEBUG_FILES
+	fpoll_restore_signals();
 	system(CatString3(
 		       "mkdir -p /tmp/fs-save; cp ", filename,
 		       " /tmp/fs-save"));
+	fpoll_block_signals();
 #endif
 #if defined(FVWM_SM_DEBUG_PROTO) || defined(FVWM_SM_DEBUG_FILES)
 	fprintf(stderr, "[FVWM_SMDEBUG] Saving %s\n", filename);
@@ -1328,9 +1332,11 @@ LoadWindowStates(char *filename)
 	fprintf(stderr, "[FVWM_SMDEBUG] Loading %s\n", filename);
 #endif
 #ifdef FVWM_SM_DEBUG_FILES
+	fpoll_restore_signals();
 	system(CatString3(
 		       "mkdir -p /tmp/fs-load; cp ", filename,
 		       " /tmp/fs-load"));
+	fpoll_block_signals();
 #endif
 
 	while (fgets(s, sizeof(s), f))
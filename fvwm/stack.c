@@ -45,6 +45,7 @@
 #include "icons.h"
 #include "ewmh.h"
 #include "frame.h"
+#include "geom_index.h"
 
 /* ---------------------------- local definitions -------------------------- */
 
@@ -1195,6 +1196,32 @@ static Bool overlap(FvwmWindow *r, FvwmWindow *s)
 	return rc;
 }
 
+/* Returns True if any other window overlaps r in the sense of overlap().  This
+ * asks the spatial index and is much cheaper than calling overlap() for all
+ * windows. */
+static Bool is_overlapped_by_any(FvwmWindow *r)
+{
+	FvwmWindow **fws;
+	rectangle g;
+	int n;
+	int i;
+
+	if (get_visible_window_or_icon_geometry(r, &g) == False)
+	{
+		return False;
+	}
+	n = geom_index_find_overlapping(&fws, r->Desk, &g);
+	for (i = 0; i < n; i++)
+	{
+		if (fws[i] != r)
+		{
+			return True;
+		}
+	}
+
+	return False;
+}
+
 #if 0
 /*
   ResyncFvwmStackRing -
@@ -1314,9 +1341,8 @@ static void BroadcastRestack(FvwmWindow *s1, FvwmWindow *s2)
 	int num;
 	int i;
 	int n;
-	fmodule_list_itr moditr;
-	fmodule *module;
-	unsigned long *body, *bp, length;
+	unsigned long body[FvwmPacketMaxSize];
+	unsigned long *bp, length;
 	unsigned long max_wins_per_packet;
 
 	if (s2 == &Scr.FvwmRoot)
@@ -1362,7 +1388,6 @@ static void BroadcastRestack(FvwmWindow *s1, FvwmWindow *s2)
 	{
 		n = min(num, max_wins_per_packet) - 1;
 		length = FvwmPacketHeaderSize + 3 * (n + 1);
-		body = fxmalloc(length * sizeof(unsigned long));
 		bp = body;
 		*(bp++) = START_FLAG;
 		*(bp++) = M_RESTACK;
@@ -1376,13 +1401,7 @@ static void BroadcastRestack(FvwmWindow *s1, FvwmWindow *s2)
 		}
 		/* The last window has to be in the header of the next part */
 		fw = fw->stack_prev;
-		module_list_itr_init(&moditr);
-		while ( (module = module_list_itr_next(&moditr)) != NULL)
-		{
-			PositiveWrite(
-				module,body,length*sizeof(unsigned long));
-		}
-		free(body);
+		module_broadcast(body, length*sizeof(unsigned long));
 	}
 #ifdef DEBUG_STACK_RING
 	verify_stack_ring_consistency();
@@ -1478,7 +1497,7 @@ static Bool is_above_unmanaged(FvwmWindow *fw, Window *umtop)
 	for (; i < num; i++)
 	{
 		/* It might be just as well (and quicker) just to check for the
-		 * absence of an FvwmContext instead of for
+		 * absence in FvwmWindowTable instead of for
 		 * override_redirect... */
 		if (!XGetWindowAttributes(dpy, tops[i], &wa))
 		{
@@ -1521,6 +1540,10 @@ static Bool is_on_top_of_layer_ignore_rom(FvwmWindow *fw)
 	{
 		mark_transient_subtree(fw, fw->layer, MARK_RAISE, True, False);
 	}
+	if (!Scr.bo.do_raise_over_unmanaged && !is_overlapped_by_any(fw))
+	{
+		return True;
+	}
 	for (t = fw->stack_prev; t != &Scr.FvwmRoot; t = t->stack_prev)
 	{
 		if (t->layer > fw->layer)
@@ -1763,6 +1786,12 @@ Bool HandleUnusualStackmodes(
 		return 0;
 	}
 
+	if ((stack_mode == TopIf || stack_mode == BottomIf) &&
+	    !is_overlapped_by_any(r))
+	{
+		/* nothing to restack against */
+		return 0;
+	}
 	switch (stack_mode)
 	{
 	case TopIf:
@@ -19,6 +19,7 @@
 
 #include "config.h"
 #include <stdio.h>
+#include <stdint.h>
 
 #include "libs/fvwmlib.h"
 #include "libs/charmap.h"
@@ -40,6 +41,12 @@
 
 #define SAFEFREE( p )  {if (p) {free(p);(p)=NULL;}}
 
+/* must be a power of two */
+#define STYLE_INDEX_MIN_BUCKETS 64
+/* must be a power of two */
+#define MERGED_STYLE_CACHE_BUCKETS 256
+#define MERGED_STYLE_CACHE_MAX_ENTRIES 1024
+
 /* ---------------------------- local macros ------------------------------- */
 
 /* ---------------------------- imports ------------------------------------ */
@@ -48,13 +55,77 @@
 
 /* ---------------------------- local types -------------------------------- */
 
+typedef struct
+{
+	window_style *style;
+	/* position of the style in the style list */
+	int pos;
+	/* next entry in the same chain or -1 */
+	int next;
+	/* length of the name without the wildcard */
+	int len;
+	/* compiled name for names with other wildcards */
+	wild_pattern_t *glob;
+} style_index_entry;
+
+/* An index of the style list to find the styles that can match a window
+ * without calling matchWildcards for every style.  Styles with names
+ * without wildcards are kept in a hash table, names of the form "foo*" and
+ * "*foo" in chains by their first and last character respectively.  Names
+ * with other wildcards are compiled and always tried.  The index is rebuilt
+ * lazily after the list has changed. */
+typedef struct
+{
+	Bool is_valid;
+	style_index_entry *entries;
+	int n_entries;
+	int max_entries;
+	int *exact;
+	int n_exact_buckets;
+	int prefix[256];
+	int suffix[256];
+	/* "*" */
+	int match_all;
+	/* other wildcards */
+	int other;
+	int window_id;
+	/* lookup_style scratch space */
+	int *candidates;
+	int max_candidates;
+} style_index_t;
+
+/* The result of merging a set of styles.  Windows of the same application
+ * usually match the same styles, so the merged style can be shared.  An
+ * entry is dropped when one of its styles is changed or removed. */
+typedef struct merged_style_entry
+{
+	struct merged_style_entry *next;
+	unsigned int hash;
+	int n_styles;
+	/* the matching styles in the order of the list */
+	window_style **styles;
+	window_style merged;
+} merged_style_entry;
+
 /* ---------------------------- forward declarations ----------------------- */
 
+static void merge_styles(
+	window_style *merged_style, window_style *add_style,
+	Bool do_free_src_and_alloc_copy);
+
 /* ---------------------------- local variables ---------------------------- */
 
 /* list of window names with attributes */
 static window_style *all_styles = NULL;
 static window_style *last_style_in_list = NULL;
+static style_index_t style_index;
+static struct
+{
+	merged_style_entry *buckets[MERGED_STYLE_CACHE_BUCKETS];
+	int n_entries;
+	unsigned long hits;
+	unsigned long misses;
+} merged_style_cache;
 
 /* ---------------------------- exported variables (globals) --------------- */
 
@@ -241,6 +312,482 @@ static int one_fw_can_match_both_ids(window_style *s, window_style *t)
 	return 1;
 }
 
+static unsigned int style_index_hash(const char *name)
+{
+	unsigned int h = 5381;
+
+	for ( ; *name != 0; name++)
+	{
+		h = h * 33 + (unsigned char)*name;
+	}
+
+	return h;
+}
+
+static void style_index_add(int *chain, window_style *style, int pos, int len)
+{
+	style_index_entry *e;
+
+	if (style_index.n_entries == style_index.max_entries)
+	{
+		style_index.max_entries = 2 * style_index.max_entries + 16;
+		style_index.entries = fxrealloc(
+			(void *)style_index.entries, style_index.max_entries,
+			sizeof(style_index_entry));
+	}
+	e = &style_index.entries[style_index.n_entries];
+	e->style = style;
+	e->pos = pos;
+	e->len = len;
+	e->glob = NULL;
+	e->next = *chain;
+	*chain = style_index.n_entries;
+	style_index.n_entries++;
+
+	return;
+}
+
+static void style_index_invalidate(void)
+{
+	style_index.is_valid = False;
+
+	return;
+}
+
+static void style_index_build(void)
+{
+	window_style *nptr;
+	int n_styles;
+	int pos;
+	int i;
+
+	n_styles = 0;
+	for (nptr = all_styles; nptr != NULL; nptr = SGET_NEXT_STYLE(*nptr))
+	{
+		n_styles++;
+	}
+	for (i = 0; i < style_index.n_entries; i++)
+	{
+		wild_free(style_index.entries[i].glob);
+	}
+	style_index.n_entries = 0;
+	for (i = 0; i < 256; i++)
+	{
+		style_index.prefix[i] = -1;
+		style_index.suffix[i] = -1;
+	}
+	style_index.match_all = -1;
+	style_index.other = -1;
+	style_index.window_id = -1;
+	if (
+		style_index.exact == NULL ||
+		style_index.n_exact_buckets < n_styles)
+	{
+		for (
+			style_index.n_exact_buckets = STYLE_INDEX_MIN_BUCKETS;
+			style_index.n_exact_buckets < n_styles;
+			style_index.n_exact_buckets *= 2)
+		{
+			/* nothing */
+		}
+		if (style_index.exact != NULL)
+		{
+			free(style_index.exact);
+		}
+		style_index.exact = fxmalloc(
+			style_index.n_exact_buckets * sizeof(int));
+	}
+	for (i = 0; i < style_index.n_exact_buckets; i++)
+	{
+		style_index.exact[i] = -1;
+	}
+	for (
+		nptr = all_styles, pos = 0; nptr != NULL;
+		nptr = SGET_NEXT_STYLE(*nptr), pos++)
+	{
+		if (SGET_ID_HAS_WINDOW_ID(*nptr))
+		{
+			style_index_add(&style_index.window_id, nptr, pos, 0);
+		}
+		if (SGET_ID_HAS_NAME(*nptr))
+		{
+			const char *name = SGET_NAME(*nptr);
+			int len = strlen(name);
+			int n_stars = 0;
+			Bool has_other = False;
+
+			for (i = 0; i < len; i++)
+			{
+				if (name[i] == '*')
+				{
+					n_stars++;
+				}
+				else if (name[i] == '?' || name[i] == '\\')
+				{
+					has_other = True;
+				}
+			}
+			if (has_other || n_stars > 1)
+			{
+				style_index_add(&style_index.other, nptr, pos, 0);
+				style_index.entries[style_index.other].glob =
+					wild_compile(name);
+			}
+			else if (n_stars == 0)
+			{
+				unsigned int h;
+
+				h = style_index_hash(name) &
+					(style_index.n_exact_buckets - 1);
+				style_index_add(
+					&style_index.exact[h], nptr, pos, len);
+			}
+			else if (len == 1)
+			{
+				style_index_add(
+					&style_index.match_all, nptr, pos, 0);
+			}
+			else if (name[len - 1] == '*')
+			{
+				style_index_add(
+					&style_index.prefix[(unsigned char)name[0]],
+					nptr, pos, len - 1);
+			}
+			else if (name[0] == '*')
+			{
+				style_index_add(
+					&style_index.suffix[
+						(unsigned char)name[len - 1]],
+					nptr, pos, len - 1);
+			}
+			else
+			{
+				style_index_add(&style_index.other, nptr, pos, 0);
+				style_index.entries[style_index.other].glob =
+					wild_compile(name);
+			}
+		}
+	}
+	style_index.is_valid = True;
+
+	return;
+}
+
+/* Adds all styles of the chain to the candidates for which the test
+ * succeeds; see style_index_lookup. */
+static int style_index_collect(
+	int n, int chain, const char *string, int slen, int how, FvwmWindow *fw)
+{
+	int i;
+
+	for (i = chain; i >= 0; i = style_index.entries[i].next)
+	{
+		const style_index_entry *e = &style_index.entries[i];
+		const char *name = SGET_NAME(*e->style);
+		Bool does_match;
+
+		switch (how)
+		{
+		case 0:
+			/* exact */
+			does_match = (strcmp(name, string) == 0);
+			break;
+		case 1:
+			/* prefix */
+			does_match = (
+				e->len <= slen &&
+				strncmp(name, string, e->len) == 0);
+			break;
+		case 2:
+			/* suffix */
+			does_match = (
+				e->len <= slen &&
+				memcmp(name + 1, string + slen - e->len,
+				       e->len) == 0);
+			break;
+		case 3:
+			/* window id */
+			does_match = (
+				SGET_WINDOW_ID(*e->style) == (XID)FW_W(fw));
+			break;
+		default:
+			/* other wildcards */
+			does_match = (
+				wild_match(e->glob, fw->class.res_class) ||
+				wild_match(e->glob, fw->class.res_name) ||
+				wild_match(e->glob, fw->visible_name) ||
+				wild_match(e->glob, fw->name.name) ||
+				(fw->style_name != NULL &&
+				 wild_match(e->glob, fw->style_name)));
+			break;
+		}
+		if (does_match)
+		{
+			style_index.candidates[n++] = i;
+		}
+	}
+
+	return n;
+}
+
+static int style_index_cmp_pos(const void *a, const void *b)
+{
+	return style_index.entries[*(const int *)a].pos -
+		style_index.entries[*(const int *)b].pos;
+}
+
+/* Finds the styles that match the window.  Returns the number of matching
+ * styles; their index entries are stored in style_index.candidates in the
+ * order of the style list. */
+static int style_index_lookup(FvwmWindow *fw)
+{
+	const char *strings[5];
+	int n = 0;
+	int i;
+	int j;
+
+	if (!style_index.is_valid)
+	{
+		style_index_build();
+	}
+	strings[0] = fw->class.res_class;
+	strings[1] = fw->class.res_name;
+	strings[2] = fw->visible_name;
+	strings[3] = fw->name.name;
+	strings[4] = fw->style_name;
+	/* the same style can be found through several names, so the candidates
+	 * may exceed the number of styles; make sure there is enough space */
+	if (style_index.max_candidates < 5 * style_index.n_entries)
+	{
+		style_index.max_candidates = 5 * style_index.n_entries;
+		style_index.candidates = fxrealloc(
+			(void *)style_index.candidates,
+			style_index.max_candidates, sizeof(int));
+	}
+	for (i = 0; i < 5; i++)
+	{
+		const char *string = strings[i];
+		int slen;
+		unsigned int h;
+
+		if (string == NULL)
+		{
+			continue;
+		}
+		h = style_index_hash(string) &
+			(style_index.n_exact_buckets - 1);
+		n = style_index_collect(
+			n, style_index.exact[h], string, 0, 0, fw);
+		slen = strlen(string);
+		if (slen == 0)
+		{
+			continue;
+		}
+		n = style_index_collect(
+			n, style_index.prefix[(unsigned char)string[0]],
+			string, slen, 1, fw);
+		n = style_index_collect(
+			n, style_index.suffix[(unsigned char)string[slen - 1]],
+			string, slen, 2, fw);
+	}
+	n = style_index_collect(n, style_index.window_id, NULL, 0, 3, fw);
+	n = style_index_collect(n, style_index.other, NULL, 0, 4, fw);
+	for (i = style_index.match_all; i >= 0; i = style_index.entries[i].next)
+	{
+		style_index.candidates[n++] = i;
+	}
+	/* restore the order of the list and drop duplicates */
+	qsort(style_index.candidates, n, sizeof(int), style_index_cmp_pos);
+	for (i = 0, j = 0; i < n; i++)
+	{
+		const style_index_entry *e;
+
+		e = &style_index.entries[style_index.candidates[i]];
+		if (
+			j == 0 ||
+			style_index.entries[style_index.candidates[j - 1]].pos !=
+			e->pos)
+		{
+			style_index.candidates[j++] = style_index.candidates[i];
+		}
+	}
+
+	return j;
+}
+
+static int style_index_chain_length(int chain)
+{
+	int n;
+
+	for (n = 0; chain >= 0; chain = style_index.entries[chain].next)
+	{
+		n++;
+	}
+
+	return n;
+}
+
+static void style_index_print_info(void)
+{
+	int n_exact = 0;
+	int n_prefix = 0;
+	int n_suffix = 0;
+	int i;
+
+	if (!style_index.is_valid)
+	{
+		style_index_build();
+	}
+	for (i = 0; i < style_index.n_exact_buckets; i++)
+	{
+		n_exact += style_index_chain_length(style_index.exact[i]);
+	}
+	for (i = 0; i < 256; i++)
+	{
+		n_prefix += style_index_chain_length(style_index.prefix[i]);
+		n_suffix += style_index_chain_length(style_index.suffix[i]);
+	}
+	fprintf(stderr,
+		"  Style index: %d exact names, %d prefixes, %d suffixes,"
+		" %d \"*\", %d other patterns, %d window ids\n", n_exact,
+		n_prefix, n_suffix,
+		style_index_chain_length(style_index.match_all),
+		style_index_chain_length(style_index.other),
+		style_index_chain_length(style_index.window_id));
+
+	return;
+}
+
+static void merged_style_cache_free_entry(merged_style_entry *e)
+{
+	/* merge_styles() has copied these strings; the other strings in
+	 * the merged style belong to the styles in the list */
+	SAFEFREE(SGET_PLACEMENT_POSITION_STRING(e->merged));
+	SAFEFREE(SGET_INITIAL_MAP_COMMAND_STRING(e->merged));
+	SAFEFREE(SGET_TITLE_FORMAT_STRING(e->merged));
+	SAFEFREE(SGET_ICON_TITLE_FORMAT_STRING(e->merged));
+	free(e->styles);
+	free(e);
+	merged_style_cache.n_entries--;
+
+	return;
+}
+
+static void merged_style_cache_flush(void)
+{
+	int i;
+
+	for (i = 0; i < MERGED_STYLE_CACHE_BUCKETS; i++)
+	{
+		while (merged_style_cache.buckets[i] != NULL)
+		{
+			merged_style_entry *e = merged_style_cache.buckets[i];
+
+			merged_style_cache.buckets[i] = e->next;
+			merged_style_cache_free_entry(e);
+		}
+	}
+
+	return;
+}
+
+/* Drop all merged styles the style is part of.  Must be called whenever a
+ * style in the list is changed or removed. */
+static void merged_style_cache_drop_style(window_style *style)
+{
+	int i;
+
+	if (merged_style_cache.n_entries == 0)
+	{
+		return;
+	}
+	for (i = 0; i < MERGED_STYLE_CACHE_BUCKETS; i++)
+	{
+		merged_style_entry **pe = &merged_style_cache.buckets[i];
+
+		while (*pe != NULL)
+		{
+			merged_style_entry *e = *pe;
+			int j;
+
+			for (j = 0; j < e->n_styles && e->styles[j] != style; j++)
+			{
+				/* nothing */
+			}
+			if (j < e->n_styles)
+			{
+				*pe = e->next;
+				merged_style_cache_free_entry(e);
+			}
+			else
+			{
+				pe = &e->next;
+			}
+		}
+	}
+
+	return;
+}
+
+/* Returns the merged style for the styles found by style_index_lookup. */
+static window_style *merged_style_cache_lookup(int n)
+{
+	merged_style_entry *e;
+	unsigned int h;
+	int i;
+
+	h = 0;
+	for (i = 0; i < n; i++)
+	{
+		h = h * 31 + (unsigned int)(uintptr_t)
+			style_index.entries[style_index.candidates[i]].style;
+	}
+	for (
+		e = merged_style_cache.buckets[
+			h & (MERGED_STYLE_CACHE_BUCKETS - 1)];
+		e != NULL; e = e->next)
+	{
+		if (e->hash != h || e->n_styles != n)
+		{
+			continue;
+		}
+		for (i = 0; i < n; i++)
+		{
+			if (e->styles[i] != style_index.entries[
+				    style_index.candidates[i]].style)
+			{
+				break;
+			}
+		}
+		if (i == n)
+		{
+			merged_style_cache.hits++;
+			return &e->merged;
+		}
+	}
+	merged_style_cache.misses++;
+	if (merged_style_cache.n_entries >= MERGED_STYLE_CACHE_MAX_ENTRIES)
+	{
+		merged_style_cache_flush();
+	}
+	e = fxcalloc(1, sizeof(merged_style_entry));
+	e->hash = h;
+	e->n_styles = n;
+	e->styles = fxmalloc((n > 0 ? n : 1) * sizeof(window_style *));
+	for (i = 0; i < n; i++)
+	{
+		e->styles[i] = style_index.entries[
+			style_index.candidates[i]].style;
+		merge_styles(&e->merged, e->styles[i], False);
+	}
+	e->next = merged_style_cache.buckets[
+		h & (MERGED_STYLE_CACHE_BUCKETS - 1)];
+	merged_style_cache.buckets[h & (MERGED_STYLE_CACHE_BUCKETS - 1)] = e;
+	merged_style_cache.n_entries++;
+
+	return &e->merged;
+}
+
 static void remove_icon_boxes_from_style(window_style *pstyle)
 {
 	if (SHAS_ICON_BOXES(&pstyle->flags))
@@ -359,6 +906,11 @@ static void merge_styles(
 	char *merge_change_mask;
 	char *add_change_mask;
 
+	if (do_free_src_and_alloc_copy)
+	{
+		/* a style in the list is changed */
+		merged_style_cache_drop_style(merged_style);
+	}
 	if (add_style->flag_mask.has_icon)
 	{
 		if (do_free_src_and_alloc_copy)
@@ -787,6 +1339,7 @@ static void merge_styles(
 
 static void free_style(window_style *style)
 {
+	merged_style_cache_drop_style(style);
 	/* Free contents of style */
 	SAFEFREE(SGET_NAME(*style));
 	SAFEFREE(SGET_BACK_COLOR_NAME(*style));
@@ -814,6 +1367,7 @@ static void free_style_mask(window_style *style, style_flags *mask)
 	style_flags local_mask;
 	style_flags *pmask;
 
+	merged_style_cache_drop_style(style);
 	/* mask out all bits that are not set in the target style */
 	pmask =&local_mask;
 	blockand((char *)pmask, (char *)&style->flag_mask, (char *)mask,
@@ -893,6 +1447,7 @@ static void add_style_to_list(window_style *new_style)
 	SSET_PREV_STYLE(*new_style, last_style_in_list);
 	SSET_NEXT_STYLE(*new_style, NULL);
 	last_style_in_list = new_style;
+	style_index_invalidate();
 	Scr.flags.do_need_style_list_update = 1;
 
 	return;
@@ -924,6 +1479,8 @@ static void remove_style_from_list(window_style *style, Bool do_free_style)
 	{
 		SSET_PREV_STYLE(*next, prev);
 	}
+	style_index_invalidate();
+	merged_style_cache_drop_style(style);
 	if (do_free_style)
 	{
 		free_style(style);
@@ -4767,18 +5324,37 @@ void simplify_style_list(void)
  */
 void lookup_style(FvwmWindow *fw, window_style *styles)
 {
-	window_style *nptr;
-
-	/* clear callers return area */
-	memset(styles, 0, sizeof(window_style));
+	int n;
 
-	/* look thru all styles in order defined. */
-	for (nptr = all_styles; nptr != NULL; nptr = SGET_NEXT_STYLE(*nptr))
+	/* merge the matching styles in the order they were defined, or reuse
+	 * the result for an earlier window that matches the same styles */
+	n = style_index_lookup(fw);
+	memcpy(styles, merged_style_cache_lookup(n), sizeof(window_style));
+	/* the cached style may be dropped while the caller still uses the
+	 * strings merge_styles() has copied, so the caller gets its own */
+	if (SGET_PLACEMENT_POSITION_STRING(*styles) != NULL)
 	{
-		if (fw_match_style_id(fw, SGET_ID(*nptr)))
-		{
-			merge_styles(styles, nptr, False);
-		}
+		SSET_PLACEMENT_POSITION_STRING(
+			*styles,
+			fxstrdup(SGET_PLACEMENT_POSITION_STRING(*styles)));
+	}
+	if (SGET_INITIAL_MAP_COMMAND_STRING(*styles) != NULL)
+	{
+		SSET_INITIAL_MAP_COMMAND_STRING(
+			*styles,
+			fxstrdup(SGET_INITIAL_MAP_COMMAND_STRING(*styles)));
+	}
+	if (SGET_TITLE_FORMAT_STRING(*styles) != NULL)
+	{
+		SSET_TITLE_FORMAT_STRING(
+			*styles,
+			fxstrdup(SGET_TITLE_FORMAT_STRING(*styles)));
+	}
+	if (SGET_ICON_TITLE_FORMAT_STRING(*styles) != NULL)
+	{
+		SSET_ICON_TITLE_FORMAT_STRING(
+			*styles,
+			fxstrdup(SGET_ICON_TITLE_FORMAT_STRING(*styles)));
 	}
 	EWMH_GetStyle(fw, styles);
 
@@ -5206,12 +5782,26 @@ void reset_style_changes(void)
 {
 	window_style *temp;
 
+	int i;
+
 	for (temp = all_styles; temp != NULL; temp = SGET_NEXT_STYLE(*temp))
 	{
 		temp->has_style_changed = 0;
 		memset(&SCCS(*temp), 0, sizeof(SCCS(*temp)));
 		memset(&(temp->change_mask), 0, sizeof(temp->change_mask));
 	}
+	/* the change flags of a merged style are merged from its styles */
+	for (i = 0; i < MERGED_STYLE_CACHE_BUCKETS; i++)
+	{
+		merged_style_entry *e;
+
+		for (e = merged_style_cache.buckets[i]; e; e = e->next)
+		{
+			e->merged.has_style_changed = 0;
+			memset(&(e->merged.change_mask), 0,
+			       sizeof(e->merged.change_mask));
+		}
+	}
 
 	return;
 }
@@ -5223,6 +5813,8 @@ void update_style_colorset(int colorset)
 
 	for (temp = all_styles; temp != NULL; temp = SGET_NEXT_STYLE(*temp))
 	{
+		style_flags old_change_mask = temp->change_mask;
+
 		if (SUSE_COLORSET(&temp->flags) &&
 		    SGET_COLORSET(*temp) == colorset)
 		{
@@ -5272,6 +5864,11 @@ void update_style_colorset(int colorset)
 			temp->change_mask.use_icon_background_colorset = 1;
 			Scr.flags.do_need_window_update = 1;
 		}
+		if (memcmp(&old_change_mask, &temp->change_mask,
+			   sizeof(style_flags)))
+		{
+			merged_style_cache_drop_style(temp);
+		}
 	}
 
 	return;
@@ -5575,6 +6172,14 @@ void print_styles(int verbose)
 	}
 	fprintf(stderr,"  Number of styles: %d, Memory Used: %d bits\n",
 		count, (int)(count*sizeof(window_style) + mem));
+	if (verbose)
+	{
+		style_index_print_info();
+		fprintf(stderr,
+			"  Merged styles: %d cached, %lu hits, %lu misses\n",
+			merged_style_cache.n_entries, merged_style_cache.hits,
+			merged_style_cache.misses);
+	}
 
 	return;
 }
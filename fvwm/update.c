@@ -54,6 +54,13 @@
 
 /* ---------------------------- local types -------------------------------- */
 
+typedef struct
+{
+	FvwmWindow *fw;
+	update_win flags;
+	window_style style;
+} window_update_t;
+
 /* ---------------------------- forward declarations ----------------------- */
 
 /* ---------------------------- local variables ---------------------------- */
@@ -609,6 +616,53 @@ static void apply_window_updates(
 	return;
 }
 
+/* Determine the updates a window needs.  Returns False if the window is not
+ * affected by any change, i.e. it matches no changed style and no global
+ * setting that concerns it has changed. */
+static Bool get_window_updates(
+	FvwmWindow *t, update_win *flags, window_style *style)
+{
+	static const update_win no_updates;
+
+	memset(flags, 0, sizeof(update_win));
+	check_window_style_change(t, flags, style);
+	if (Scr.flags.has_xinerama_state_changed)
+	{
+		flags->do_update_icon_boxes = True;
+		flags->do_update_icon_placement = True;
+	}
+	if (Scr.flags.has_nr_buttons_changed)
+	{
+		flags->do_redecorate = True;
+	}
+	/* TODO: this is not optimised for minimal redrawing yet*/
+	if (t->decor->flags.has_changed)
+	{
+		flags->do_redecorate = True;
+		flags->do_update_window_font_height = True;
+	}
+	if (Scr.flags.has_default_font_changed && !HAS_ICON_FONT(t))
+	{
+		flags->do_update_icon_font = True;
+	}
+	if (Scr.flags.has_default_font_changed && !HAS_WINDOW_FONT(t))
+	{
+		flags->do_update_window_font = True;
+	}
+	if (t->decor->flags.has_title_height_changed)
+	{
+		flags->do_update_window_font_height = True;
+	}
+	if (Scr.flags.has_mouse_binding_changed)
+	{
+		flags->do_update_window_grabs = True;
+	}
+
+	return (
+		style->has_style_changed ||
+		memcmp(flags, &no_updates, sizeof(update_win)) != 0);
+}
+
 /* ---------------------------- builtin commands --------------------------- */
 
 /* takes only care of destroying windows that have to go away. */
@@ -666,84 +720,84 @@ void apply_decor_change(FvwmWindow *fw)
 void flush_window_updates(void)
 {
 	FvwmWindow *t;
-	window_style style;
 	FvwmWindow *focus_fw;
 	Bool do_need_ungrab = False;
-	update_win flags;
+	window_update_t *updates;
+	int n_windows;
+	int n_updates;
+	int i;
 
-	/* Grab the server during the style update! */
-	if (GrabEm(CRS_WAIT, GRAB_BUSY))
+	/* Find the windows that need an update first; this touches only fvwm's
+	 * own data, so the server need not be grabbed yet.  Windows that
+	 * match none of the changed styles are left alone. */
+	for (t = Scr.FvwmRoot.next, n_windows = 0; t != NULL; t = t->next)
 	{
-		do_need_ungrab = True;
+		n_windows++;
 	}
-	MyXGrabServer(dpy);
-
-	/* This is necessary in case the focus policy changes. With
-	 * ClickToFocus some buttons have to be grabbed/ungrabbed. */
-	focus_fw = get_focus_window();
-	DeleteFocus(False);
-
-	/* Apply the new default font and colours first */
-	if (Scr.flags.has_default_color_changed ||
-	    Scr.flags.has_default_font_changed)
+	updates = fxmalloc((n_windows + 1) * sizeof(window_update_t));
+	for (t = Scr.FvwmRoot.next, n_updates = 0; t != NULL; t = t->next)
 	{
-		ApplyDefaultFontAndColors();
+		if (get_window_updates(
+			    t, &updates[n_updates].flags,
+			    &updates[n_updates].style))
+		{
+			updates[n_updates].fw = t;
+			n_updates++;
+		}
 	}
 
-	/* update styles for all windows */
-	for (t = Scr.FvwmRoot.next; t != NULL; t = t->next)
+	if (
+		n_updates > 0 || Scr.flags.has_default_color_changed ||
+		Scr.flags.has_default_font_changed)
 	{
-		memset(&flags, 0, sizeof(update_win));
-		check_window_style_change(t, &flags, &style);
-		if (Scr.flags.has_xinerama_state_changed)
-		{
-			flags.do_update_icon_boxes = True;
-			flags.do_update_icon_placement = True;
-		}
-		if (Scr.flags.has_nr_buttons_changed)
+		/* Grab the server during the style update! */
+		if (GrabEm(CRS_WAIT, GRAB_BUSY))
 		{
-			flags.do_redecorate = True;
+			do_need_ungrab = True;
 		}
-		/* TODO: this is not optimised for minimal redrawing yet*/
-		if (t->decor->flags.has_changed)
-		{
-			flags.do_redecorate = True;
-			flags.do_update_window_font_height = True;
-		}
-		if (Scr.flags.has_default_font_changed && !HAS_ICON_FONT(t))
+		MyXGrabServer(dpy);
+
+		/* This is necessary in case the focus policy changes. With
+		 * ClickToFocus some buttons have to be grabbed/ungrabbed. */
+		focus_fw = get_focus_window();
+		DeleteFocus(False);
+
+		/* Apply the new default font and colours first */
+		if (Scr.flags.has_default_color_changed ||
+		    Scr.flags.has_default_font_changed)
 		{
-			flags.do_update_icon_font = True;
+			ApplyDefaultFontAndColors();
 		}
-		if (Scr.flags.has_default_font_changed && !HAS_WINDOW_FONT(t))
+
+		/* now apply the changes */
+		for (i = 0; i < n_updates; i++)
 		{
-			flags.do_update_window_font = True;
+			apply_window_updates(
+				updates[i].fw, &updates[i].flags,
+				&updates[i].style, focus_fw);
 		}
-		if (t->decor->flags.has_title_height_changed)
+
+		/* restore the focus; also handles the case that the
+		 * previously focused window is now NeverFocus */
+		if (focus_fw)
 		{
-			flags.do_update_window_font_height = True;
+			SetFocusWindow(focus_fw, False, FOCUS_SET_FORCE);
+			if (Scr.flags.has_mouse_binding_changed)
+			{
+				focus_grab_buttons(focus_fw);
+			}
 		}
-		if (Scr.flags.has_mouse_binding_changed)
+		else
 		{
-			flags.do_update_window_grabs = True;
+			DeleteFocus(True);
 		}
-		/* now apply the changes */
-		apply_window_updates(t, &flags, &style, focus_fw);
-	}
-
-	/* restore the focus; also handles the case that the previously focused
-	 * window is now NeverFocus */
-	if (focus_fw)
-	{
-		SetFocusWindow(focus_fw, False, FOCUS_SET_FORCE);
-		if (Scr.flags.has_mouse_binding_changed)
+		MyXUngrabServer(dpy);
+		if (do_need_ungrab)
 		{
-			focus_grab_buttons(focus_fw);
+			UngrabEm(GRAB_BUSY);
 		}
 	}
-	else
-	{
-		DeleteFocus(True);
-	}
+	free(updates);
 
 	/* finally clean up the change flags */
 	reset_style_changes();
@@ -755,12 +809,6 @@ void flush_window_updates(void)
 	Scr.flags.has_nr_buttons_changed = 0;
 	Scr.flags.has_xinerama_state_changed = 0;
 
-	MyXUngrabServer(dpy);
-	if (do_need_ungrab)
-	{
-		UngrabEm(GRAB_BUSY);
-	}
-
 	return;
 }
 
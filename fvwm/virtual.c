@@ -44,6 +44,7 @@
 #include "icons.h"
 #include "stack.h"
 #include "functions.h"
+#include "geom_index.h"
 
 /* ---------------------------- local definitions -------------------------- */
 
@@ -576,6 +577,7 @@ static void MapDesk(struct monitor *m, int desk, Bool grab)
 			/*  If window is sticky, just update its desk (it's
 			 * still mapped).  */
 			t->Desk = desk;
+			geom_index_update(t);
 			if (sf == t)
 			{
 				StickyWin = t;
@@ -1560,6 +1562,7 @@ void do_move_window_to_desk(FvwmWindow *fw, int desk)
 		if (fw->Desk == m->virtual_scr.CurrentDesk)
 		{
 			fw->Desk = desk;
+			geom_index_update(fw);
 			if (fw == get_focus_window())
 			{
 				DeleteFocus(True);
@@ -1571,6 +1574,7 @@ void do_move_window_to_desk(FvwmWindow *fw, int desk)
 		else if (desk == m->virtual_scr.CurrentDesk)
 		{
 			fw->Desk = desk;
+			geom_index_update(fw);
 			/* If its an icon, auto-place it */
 			if (IS_ICONIFIED(fw))
 			{
@@ -1581,6 +1585,7 @@ void do_move_window_to_desk(FvwmWindow *fw, int desk)
 		else
 		{
 			fw->Desk = desk;
+			geom_index_update(fw);
 		}
 		BroadcastConfig(M_CONFIGURE_WINDOW,fw);
 	}
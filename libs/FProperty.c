@@ -0,0 +1,941 @@
+/* -*-c-*- */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see: <http://www.gnu.org/licenses/>
+ */
+
+/* ---------------------------- included header files ---------------------- */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/Xatom.h>
+#ifdef HAVE_XCB
+#include <X11/Xlib-xcb.h>
+#include <xcb/xcb.h>
+#endif
+
+#include "safemalloc.h"
+#include "FEvent.h"
+#include "FProperty.h"
+
+/* ---------------------------- local definitions -------------------------- */
+
+/* number of longs in the WM_HINTS and WM_NORMAL_HINTS properties (see
+ * Xatomtype.h) */
+#define NUM_PROP_WM_HINTS_ELEMENTS 9
+#define NUM_PROP_SIZE_ELEMENTS 18
+#define OLD_NUM_PROP_SIZE_ELEMENTS 15
+
+/* ---------------------------- local macros ------------------------------- */
+
+/* ---------------------------- imports ------------------------------------ */
+
+/* ---------------------------- included code files ------------------------ */
+
+/* ---------------------------- local types -------------------------------- */
+
+#ifdef HAVE_XCB
+typedef struct
+{
+	Atom atom;
+	/* NULL if the request failed or the entry has been invalidated */
+	xcb_get_property_reply_t *reply;
+} fprop_prop_t;
+
+typedef struct
+{
+	Window w;
+	xcb_get_window_attributes_reply_t *attr;
+	xcb_get_geometry_reply_t *geom;
+	fprop_prop_t *props;
+	int n_props;
+} fprop_win_t;
+#endif
+
+/* ---------------------------- forward declarations ----------------------- */
+
+/* ---------------------------- local variables ---------------------------- */
+
+#ifdef HAVE_XCB
+/* cached windows, sorted by window id */
+static fprop_win_t *wins = NULL;
+static int n_wins = 0;
+static int max_wins = 0;
+#endif
+
+static struct
+{
+	/* number of FPropertyPrefetch calls that sent requests */
+	unsigned long batches;
+	/* number of requests sent by these calls */
+	unsigned long pipelined;
+	/* requests answered from the prefetched replies */
+	unsigned long hits;
+	/* requests sent synchronously */
+	unsigned long misses;
+	/* windows fetched in these batches */
+	unsigned long windows;
+} stats;
+
+/* ---------------------------- exported variables (globals) --------------- */
+
+/* ---------------------------- local functions ---------------------------- */
+
+#ifdef HAVE_XCB
+static int fprop_compare_wins(const void *a, const void *b)
+{
+	Window wa = ((const fprop_win_t *)a)->w;
+	Window wb = ((const fprop_win_t *)b)->w;
+
+	return (wa < wb) ? -1 : (wa > wb) ? 1 : 0;
+}
+
+static fprop_win_t *fprop_find_win(Window w)
+{
+	fprop_win_t key;
+
+	if (n_wins == 0)
+	{
+		return NULL;
+	}
+	key.w = w;
+
+	return bsearch(
+		&key, wins, n_wins, sizeof(fprop_win_t), fprop_compare_wins);
+}
+
+static fprop_prop_t *fprop_find_prop(fprop_win_t *fw, Atom atom)
+{
+	int i;
+
+	for (i = 0; i < fw->n_props; i++)
+	{
+		if (fw->props[i].atom == atom)
+		{
+			return &fw->props[i];
+		}
+	}
+
+	return NULL;
+}
+
+static void fprop_free_win(fprop_win_t *fw)
+{
+	int i;
+
+	free(fw->attr);
+	free(fw->geom);
+	for (i = 0; i < fw->n_props; i++)
+	{
+		free(fw->props[i].reply);
+	}
+	free(fw->props);
+
+	return;
+}
+
+/* Looks up the visual like Xlib's _XVIDtoVisual. */
+static Visual *fprop_id_to_visual(Display *dpy, VisualID id)
+{
+	int i;
+	int j;
+	int k;
+
+	for (i = 0; i < ScreenCount(dpy); i++)
+	{
+		Screen *sp = ScreenOfDisplay(dpy, i);
+
+		for (j = 0; j < sp->ndepths; j++)
+		{
+			Depth *dp = &sp->depths[j];
+
+			for (k = 0; k < dp->nvisuals; k++)
+			{
+				if (dp->visuals[k].visualid == id)
+				{
+					return &dp->visuals[k];
+				}
+			}
+		}
+	}
+
+	return NULL;
+}
+
+/* Builds the return values of XGetWindowProperty from a reply that contains
+ * the complete property.  Returns 0 if Xlib has to be asked because the
+ * request would generate an error. */
+static int fprop_slice_reply(
+	xcb_get_property_reply_t *reply, long long_offset, long long_length,
+	Atom req_type, Atom *actual_type_return, int *actual_format_return,
+	unsigned long *nitems_return, unsigned long *bytes_after_return,
+	unsigned char **prop_return)
+{
+	unsigned char *value;
+	unsigned long total;
+	unsigned long start;
+	unsigned long len;
+	unsigned long nitems;
+	unsigned long nbytes;
+	int unit;
+
+	*prop_return = NULL;
+	if (reply->type == XCB_NONE)
+	{
+		*actual_type_return = None;
+		*actual_format_return = 0;
+		*nitems_return = 0;
+		*bytes_after_return = 0;
+
+		return 1;
+	}
+	switch (reply->format)
+	{
+	case 8:
+		unit = 1;
+		break;
+	case 16:
+		unit = 2;
+		break;
+	case 32:
+		unit = 4;
+		break;
+	default:
+		return 0;
+	}
+	value = xcb_get_property_value(reply);
+	total = xcb_get_property_value_length(reply);
+	if (req_type != AnyPropertyType && req_type != reply->type)
+	{
+		/* the server returns the type and size but no data */
+		start = 0;
+		len = 0;
+		*bytes_after_return = total;
+	}
+	else
+	{
+		if (long_offset < 0 || long_length < 0)
+		{
+			return 0;
+		}
+		start = 4 * (unsigned long)long_offset;
+		if (start > total)
+		{
+			/* BadValue */
+			return 0;
+		}
+		len = total - start;
+		if ((unsigned long)long_length <= len / 4)
+		{
+			len = 4 * (unsigned long)long_length;
+		}
+		*bytes_after_return = total - start - len;
+	}
+	nitems = len / unit;
+	/* Xlib stores 16 and 32 bit quantities as shorts and longs */
+	switch (unit)
+	{
+	case 2:
+		nbytes = nitems * sizeof(short);
+		break;
+	case 4:
+		nbytes = nitems * sizeof(long);
+		break;
+	default:
+		nbytes = nitems;
+		break;
+	}
+	*prop_return = fxmalloc(nbytes + 1);
+	switch (unit)
+	{
+	case 2:
+	{
+		unsigned long i;
+		int16_t *src = (int16_t *)(value + start);
+
+		for (i = 0; i < nitems; i++)
+		{
+			((short *)*prop_return)[i] = src[i];
+		}
+		break;
+	}
+	case 4:
+	{
+		unsigned long i;
+		int32_t *src = (int32_t *)(value + start);
+
+		/* sign extended like in _XRead32 */
+		for (i = 0; i < nitems; i++)
+		{
+			((long *)*prop_return)[i] = src[i];
+		}
+		break;
+	}
+	default:
+		memcpy(*prop_return, value + start, nbytes);
+		break;
+	}
+	(*prop_return)[nbytes] = 0;
+	*actual_type_return = reply->type;
+	*actual_format_return = reply->format;
+	*nitems_return = nitems;
+
+	return 1;
+}
+#endif
+
+/* ---------------------------- interface functions ------------------------ */
+
+int FPropertyPrefetch(
+	Display *dpy, Window *windows, int n_windows, Atom *atoms,
+	int n_atoms)
+{
+#ifdef HAVE_XCB
+	xcb_connection_t *c;
+	xcb_get_window_attributes_cookie_t *attr_cookies;
+	xcb_get_geometry_cookie_t *geom_cookies;
+	xcb_get_property_cookie_t *prop_cookies;
+	Window *todo;
+	int n_todo;
+	int i;
+	int j;
+
+	if (n_windows <= 0)
+	{
+		return 0;
+	}
+	todo = fxmalloc(n_windows * sizeof(Window));
+	for (i = 0, n_todo = 0; i < n_windows; i++)
+	{
+		if (windows[i] != None && fprop_find_win(windows[i]) == NULL)
+		{
+			todo[n_todo++] = windows[i];
+		}
+	}
+	if (n_todo == 0)
+	{
+		free(todo);
+		return 0;
+	}
+	c = XGetXCBConnection(dpy);
+	attr_cookies = fxmalloc(n_todo * sizeof(*attr_cookies));
+	geom_cookies = fxmalloc(n_todo * sizeof(*geom_cookies));
+	prop_cookies = fxmalloc(
+		(n_atoms > 0 ? n_todo * n_atoms : 1) * sizeof(*prop_cookies));
+	/* send all requests ... */
+	for (i = 0; i < n_todo; i++)
+	{
+		attr_cookies[i] = xcb_get_window_attributes(c, todo[i]);
+		geom_cookies[i] = xcb_get_geometry(c, todo[i]);
+		for (j = 0; j < n_atoms; j++)
+		{
+			prop_cookies[i * n_atoms + j] = xcb_get_property(
+				c, 0, todo[i], atoms[j], XCB_GET_PROPERTY_TYPE_ANY,
+				0, 0x7fffffff);
+		}
+	}
+	stats.batches++;
+	stats.pipelined += n_todo * (2 + n_atoms);
+	stats.windows += n_todo;
+	/* ... then collect the replies */
+	if (n_wins + n_todo > max_wins)
+	{
+		max_wins = n_wins + n_todo;
+		wins = fxrealloc(
+			(void *)wins, max_wins, sizeof(fprop_win_t));
+	}
+	for (i = 0; i < n_todo; i++)
+	{
+		fprop_win_t *fw = &wins[n_wins + i];
+		xcb_generic_error_t *err = NULL;
+
+		fw->w = todo[i];
+		/* errors are discarded here; Xlib repeats the request if the
+		 * reply is missing and reports them as usual */
+		fw->attr = xcb_get_window_attributes_reply(
+			c, attr_cookies[i], &err);
+		free(err);
+		err = NULL;
+		fw->geom = xcb_get_geometry_reply(c, geom_cookies[i], &err);
+		free(err);
+		fw->n_props = n_atoms;
+		fw->props = (n_atoms > 0) ?
+			fxmalloc(n_atoms * sizeof(fprop_prop_t)) : NULL;
+		for (j = 0; j < n_atoms; j++)
+		{
+			err = NULL;
+			fw->props[j].atom = atoms[j];
+			fw->props[j].reply = xcb_get_property_reply(
+				c, prop_cookies[i * n_atoms + j], &err);
+			free(err);
+		}
+	}
+	n_wins += n_todo;
+	qsort(wins, n_wins, sizeof(fprop_win_t), fprop_compare_wins);
+	free(attr_cookies);
+	free(geom_cookies);
+	free(prop_cookies);
+	free(todo);
+
+	return n_todo;
+#else
+	return 0;
+#endif
+}
+
+void FPropertyDrop(Window w)
+{
+#ifdef HAVE_XCB
+	fprop_win_t *fw;
+	int i;
+
+	fw = fprop_find_win(w);
+	if (fw == NULL)
+	{
+		return;
+	}
+	fprop_free_win(fw);
+	i = fw - wins;
+	memmove(fw, fw + 1, (n_wins - i - 1) * sizeof(fprop_win_t));
+	n_wins--;
+#endif
+
+	return;
+}
+
+void FPropertyDropAll(void)
+{
+#ifdef HAVE_XCB
+	int i;
+
+	for (i = 0; i < n_wins; i++)
+	{
+		fprop_free_win(&wins[i]);
+	}
+	n_wins = 0;
+#endif
+
+	return;
+}
+
+void FPropertyInvalidate(Window w, Atom property)
+{
+#ifdef HAVE_XCB
+	fprop_win_t *fw;
+	int i;
+
+	fw = fprop_find_win(w);
+	if (fw == NULL)
+	{
+		return;
+	}
+	if (property == None)
+	{
+		free(fw->attr);
+		fw->attr = NULL;
+
+		return;
+	}
+	for (i = 0; i < fw->n_props; i++)
+	{
+		if (fw->props[i].atom == property)
+		{
+			free(fw->props[i].reply);
+			fw->props[i].reply = NULL;
+		}
+	}
+#endif
+
+	return;
+}
+
+void FPropertyPrintInfo(int verbose)
+{
+	fflush(stderr);
+	fflush(stdout);
+	fprintf(stderr, "fvwm info on window property requests:\n");
+#ifdef HAVE_XCB
+	fprintf(stderr, "  pipelining: yes, %d windows cached\n", n_wins);
+#else
+	fprintf(stderr, "  pipelining: no (built without XCB)\n");
+#endif
+	fprintf(stderr,
+		"  %lu requests in %lu pipelined batches\n"
+		"  %lu requests answered from prefetched replies\n"
+		"  %lu synchronous requests\n",
+		stats.pipelined, stats.batches, stats.hits, stats.misses);
+	fprintf(stderr,
+		"  %lu round trips instead of %lu\n",
+		stats.batches + stats.misses, stats.hits + stats.misses);
+	if (stats.windows > 0)
+	{
+		fprintf(stderr,
+			"  %lu windows prefetched, %.2f round trips per window"
+			" instead of %.2f\n", stats.windows,
+			(double)(stats.batches + stats.misses) / stats.windows,
+			(double)(stats.hits + stats.misses) / stats.windows);
+	}
+	if (verbose > 0)
+	{
+		fprintf(stderr,
+			"  %lu prefetched replies were not used\n",
+			(stats.pipelined > stats.hits) ?
+			stats.pipelined - stats.hits : 0);
+	}
+	fflush(stderr);
+
+	return;
+}
+
+Status FGetWindowAttributes(
+	Display *dpy, Window w, XWindowAttributes *window_attributes_return)
+{
+#ifdef HAVE_XCB
+	fprop_win_t *fw;
+
+	fw = fprop_find_win(w);
+	if (fw != NULL && fw->attr != NULL && fw->geom != NULL)
+	{
+		XWindowAttributes *a = window_attributes_return;
+		xcb_get_window_attributes_reply_t *r = fw->attr;
+		int i;
+
+		stats.hits++;
+		a->class = r->_class;
+		a->bit_gravity = r->bit_gravity;
+		a->win_gravity = r->win_gravity;
+		a->backing_store = r->backing_store;
+		a->backing_planes = r->backing_planes;
+		a->backing_pixel = r->backing_pixel;
+		a->save_under = r->save_under;
+		a->colormap = r->colormap;
+		a->map_installed = r->map_is_installed;
+		a->map_state = r->map_state;
+		a->all_event_masks = r->all_event_masks;
+		a->your_event_mask = r->your_event_mask;
+		a->do_not_propagate_mask = r->do_not_propagate_mask;
+		a->override_redirect = r->override_redirect;
+		a->visual = fprop_id_to_visual(dpy, r->visual);
+		a->x = fw->geom->x;
+		a->y = fw->geom->y;
+		a->width = fw->geom->width;
+		a->height = fw->geom->height;
+		a->border_width = fw->geom->border_width;
+		a->depth = fw->geom->depth;
+		a->root = fw->geom->root;
+		a->screen = NULL;
+		for (i = 0; i < ScreenCount(dpy); i++)
+		{
+			if (RootWindow(dpy, i) == a->root)
+			{
+				a->screen = ScreenOfDisplay(dpy, i);
+				break;
+			}
+		}
+
+		return 1;
+	}
+#endif
+	stats.misses++;
+
+	return XGetWindowAttributes(dpy, w, window_attributes_return);
+}
+
+Status FGetGeometry(
+	Display *dpy, Drawable d, Window *root_return, int *x_return,
+	int *y_return, unsigned int *width_return,
+	unsigned int *height_return, unsigned int *border_width_return,
+	unsigned int *depth_return)
+{
+#ifdef HAVE_XCB
+	fprop_win_t *fw;
+
+	fw = fprop_find_win(d);
+	if (fw != NULL && fw->geom != NULL)
+	{
+		stats.hits++;
+		*root_return = fw->geom->root;
+		*x_return = fw->geom->x;
+		*y_return = fw->geom->y;
+		*width_return = fw->geom->width;
+		*height_return = fw->geom->height;
+		*border_width_return = fw->geom->border_width;
+		*depth_return = fw->geom->depth;
+
+		return 1;
+	}
+#endif
+	stats.misses++;
+
+	return XGetGeometry(
+		dpy, d, root_return, x_return, y_return, width_return,
+		height_return, border_width_return, depth_return);
+}
+
+int FGetWindowProperty(
+	Display *dpy, Window w, Atom property, long long_offset,
+	long long_length, Bool delete, Atom req_type,
+	Atom *actual_type_return, int *actual_format_return,
+	unsigned long *nitems_return, unsigned long *bytes_after_return,
+	unsigned char **prop_return)
+{
+#ifdef HAVE_XCB
+	fprop_win_t *fw;
+
+	fw = fprop_find_win(w);
+	if (fw != NULL)
+	{
+		fprop_prop_t *p;
+
+		p = fprop_find_prop(fw, property);
+		if (delete)
+		{
+			/* let the server do it and forget the old value */
+			if (p != NULL)
+			{
+				free(p->reply);
+				p->reply = NULL;
+			}
+		}
+		else if (
+			p != NULL && p->reply != NULL &&
+			fprop_slice_reply(
+				p->reply, long_offset, long_length, req_type,
+				actual_type_return, actual_format_return,
+				nitems_return, bytes_after_return,
+				prop_return))
+		{
+			stats.hits++;
+
+			return Success;
+		}
+	}
+#endif
+	stats.misses++;
+
+	return XGetWindowProperty(
+		dpy, w, property, long_offset, long_length, delete, req_type,
+		actual_type_return, actual_format_return, nitems_return,
+		bytes_after_return, prop_return);
+}
+
+/* The functions below are the Xlib implementations on top of
+ * FGetWindowProperty. */
+
+XWMHints *FGetWMHints(Display *dpy, Window w)
+{
+	XWMHints *hints;
+	long *prop = NULL;
+	Atom actual_type;
+	int actual_format;
+	unsigned long nitems;
+	unsigned long leftover;
+
+	if (FGetWindowProperty(
+		    dpy, w, XA_WM_HINTS, 0L, NUM_PROP_WM_HINTS_ELEMENTS, False,
+		    XA_WM_HINTS, &actual_type, &actual_format, &nitems,
+		    &leftover, (unsigned char **)&prop) != Success)
+	{
+		return NULL;
+	}
+	if (actual_type != XA_WM_HINTS ||
+	    nitems < NUM_PROP_WM_HINTS_ELEMENTS - 1 || actual_format != 32)
+	{
+		if (prop != NULL)
+		{
+			XFree(prop);
+		}
+		return NULL;
+	}
+	hints = fxcalloc(1, sizeof(XWMHints));
+	hints->flags = prop[0];
+	hints->input = (prop[1] ? True : False);
+	hints->initial_state = (int)prop[2];
+	hints->icon_pixmap = prop[3];
+	hints->icon_window = prop[4];
+	hints->icon_x = (int)prop[5];
+	hints->icon_y = (int)prop[6];
+	hints->icon_mask = prop[7];
+	if (nitems >= NUM_PROP_WM_HINTS_ELEMENTS)
+	{
+		hints->window_group = prop[8];
+	}
+	else
+	{
+		hints->window_group = 0;
+	}
+	XFree(prop);
+
+	return hints;
+}
+
+Status FGetClassHint(Display *dpy, Window w, XClassHint *class_hints_return)
+{
+	unsigned char *data = NULL;
+	Atom actual_type;
+	int actual_format;
+	unsigned long nitems;
+	unsigned long leftover;
+	int len_name;
+
+	if (FGetWindowProperty(
+		    dpy, w, XA_WM_CLASS, 0L, (long)BUFSIZ, False, XA_STRING,
+		    &actual_type, &actual_format, &nitems, &leftover,
+		    &data) != Success)
+	{
+		return 0;
+	}
+	if (actual_type == XA_STRING && actual_format == 8)
+	{
+		len_name = strlen((char *)data);
+		class_hints_return->res_name = fxstrdup((char *)data);
+		if (len_name == nitems)
+		{
+			len_name--;
+		}
+		class_hints_return->res_class =
+			fxstrdup((char *)(data + len_name + 1));
+		XFree(data);
+
+		return 1;
+	}
+	if (data != NULL)
+	{
+		XFree(data);
+	}
+
+	return 0;
+}
+
+Status FGetTransientForHint(
+	Display *dpy, Window w, Window *prop_window_return)
+{
+	long *data = NULL;
+	Atom actual_type;
+	int actual_format;
+	unsigned long nitems;
+	unsigned long leftover;
+
+	if (FGetWindowProperty(
+		    dpy, w, XA_WM_TRANSIENT_FOR, 0L, 1L, False, XA_WINDOW,
+		    &actual_type, &actual_format, &nitems, &leftover,
+		    (unsigned char **)&data) != Success)
+	{
+		*prop_window_return = None;
+		return 0;
+	}
+	if (actual_type == XA_WINDOW && actual_format == 32 && nitems != 0)
+	{
+		*prop_window_return = *data;
+		XFree(data);
+
+		return 1;
+	}
+	*prop_window_return = None;
+	if (data != NULL)
+	{
+		XFree(data);
+	}
+
+	return 0;
+}
+
+static Status fprop_get_atom_list(
+	Display *dpy, Window w, const char *name, Atom type,
+	unsigned long **list_return, int *count_return)
+{
+	Atom prop;
+	unsigned long *data = NULL;
+	Atom actual_type;
+	int actual_format;
+	unsigned long nitems;
+	unsigned long leftover;
+
+	/* Xlib caches the atoms, so this is no round trip */
+	prop = XInternAtom(dpy, name, False);
+	if (prop == None)
+	{
+		return False;
+	}
+	if (FGetWindowProperty(
+		    dpy, w, prop, 0L, 1000000L, False, type, &actual_type,
+		    &actual_format, &nitems, &leftover,
+		    (unsigned char **)&data) != Success)
+	{
+		return False;
+	}
+	if (actual_type != type || actual_format != 32)
+	{
+		if (data != NULL)
+		{
+			XFree(data);
+		}
+		return False;
+	}
+	*list_return = data;
+	*count_return = (int)nitems;
+
+	return True;
+}
+
+Status FGetWMProtocols(
+	Display *dpy, Window w, Atom **protocols_return, int *count_return)
+{
+	return fprop_get_atom_list(
+		dpy, w, "WM_PROTOCOLS", XA_ATOM,
+		(unsigned long **)protocols_return, count_return);
+}
+
+Status FGetWMColormapWindows(
+	Display *dpy, Window w, Window **windows_return, int *count_return)
+{
+	return fprop_get_atom_list(
+		dpy, w, "WM_COLORMAP_WINDOWS", XA_WINDOW,
+		(unsigned long **)windows_return, count_return);
+}
+
+Status FGetTextProperty(
+	Display *dpy, Window w, XTextProperty *text_prop_return,
+	Atom property)
+{
+	unsigned char *prop = NULL;
+	Atom actual_type;
+	int actual_format = 0;
+	unsigned long nitems = 0L;
+	unsigned long leftover;
+
+	if (FGetWindowProperty(
+		    dpy, w, property, 0L, 1000000L, False, AnyPropertyType,
+		    &actual_type, &actual_format, &nitems, &leftover,
+		    &prop) == Success && actual_type != None)
+	{
+		text_prop_return->value = prop;
+		text_prop_return->encoding = actual_type;
+		text_prop_return->format = actual_format;
+		text_prop_return->nitems = nitems;
+
+		return True;
+	}
+	text_prop_return->value = NULL;
+	text_prop_return->encoding = None;
+	text_prop_return->format = 0;
+	text_prop_return->nitems = 0;
+
+	return False;
+}
+
+Status FGetWMName(Display *dpy, Window w, XTextProperty *text_prop_return)
+{
+	return FGetTextProperty(dpy, w, text_prop_return, XA_WM_NAME);
+}
+
+Status FGetWMIconName(
+	Display *dpy, Window w, XTextProperty *text_prop_return)
+{
+	return FGetTextProperty(dpy, w, text_prop_return, XA_WM_ICON_NAME);
+}
+
+Status FGetCommand(
+	Display *dpy, Window w, char ***argv_return, int *argc_return)
+{
+	XTextProperty tp;
+	int argc;
+	char **argv;
+
+	if (!FGetTextProperty(dpy, w, &tp, XA_WM_COMMAND) ||
+	    tp.encoding != XA_STRING || tp.format != 8)
+	{
+		if (tp.value)
+		{
+			XFree(tp.value);
+		}
+		return 0;
+	}
+	if (tp.nitems && tp.value[tp.nitems - 1] == '\0')
+	{
+		tp.nitems--;
+	}
+	if (!XTextPropertyToStringList(&tp, &argv, &argc))
+	{
+		XFree(tp.value);
+		return 0;
+	}
+	XFree(tp.value);
+	*argv_return = argv;
+	*argc_return = argc;
+
+	return 1;
+}
+
+Status FGetWMSizeHints(
+	Display *dpy, Window w, XSizeHints *hints_return,
+	long *supplied_return, Atom property)
+{
+	long *prop = NULL;
+	Atom actual_type;
+	int actual_format;
+	unsigned long nitems;
+	unsigned long leftover;
+	XSizeHints *h = hints_return;
+
+	if (FGetWindowProperty(
+		    dpy, w, property, 0L, NUM_PROP_SIZE_ELEMENTS, False,
+		    XA_WM_SIZE_HINTS, &actual_type, &actual_format, &nitems,
+		    &leftover, (unsigned char **)&prop) != Success)
+	{
+		return False;
+	}
+	if (actual_type != XA_WM_SIZE_HINTS ||
+	    nitems < OLD_NUM_PROP_SIZE_ELEMENTS || actual_format != 32)
+	{
+		if (prop != NULL)
+		{
+			XFree(prop);
+		}
+		return False;
+	}
+	h->flags = prop[0];
+	h->x = (int)prop[1];
+	h->y = (int)prop[2];
+	h->width = (int)prop[3];
+	h->height = (int)prop[4];
+	h->min_width = (int)prop[5];
+	h->min_height = (int)prop[6];
+	h->max_width = (int)prop[7];
+	h->max_height = (int)prop[8];
+	h->width_inc = (int)prop[9];
+	h->height_inc = (int)prop[10];
+	h->min_aspect.x = (int)prop[11];
+	h->min_aspect.y = (int)prop[12];
+	h->max_aspect.x = (int)prop[13];
+	h->max_aspect.y = (int)prop[14];
+	*supplied_return = (USPosition | USSize | PAllHints);
+	if (nitems >= NUM_PROP_SIZE_ELEMENTS)
+	{
+		h->base_width = (int)prop[15];
+		h->base_height = (int)prop[16];
+		h->win_gravity = (int)prop[17];
+		*supplied_return |= (PBaseSize | PWinGravity);
+	}
+	h->flags &= (*supplied_return);
+	XFree(prop);
+	fev_sanitize_size_hints(hints_return);
+
+	return True;
+}
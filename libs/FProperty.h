@@ -0,0 +1,96 @@
+/* -*-c-*- */
+
+#ifndef FPROPERTY_H
+#define FPROPERTY_H
+
+/* Pipelined reading of window properties.
+ *
+ * Managing a window needs about twenty synchronous requests (attributes,
+ * geometry and one GetProperty per hint), each of which costs a full round
+ * trip to the X server while the server is grabbed.  FPropertyPrefetch()
+ * sends all these requests for a set of windows at once through XCB and
+ * collects the replies afterwards, so the whole set costs a single round
+ * trip.  The F* functions below are drop in replacements for the Xlib
+ * functions of the same name; they are answered from the prefetched replies
+ * if possible and call Xlib otherwise.
+ *
+ * The prefetched data is a snapshot.  It must be dropped with
+ * FPropertyDrop() or FPropertyDropAll() before events are handled that
+ * might report a change of the windows, i.e. once the server is ungrabbed
+ * and PropertyNotify events are processed.  Properties that are changed by
+ * the caller itself must be invalidated with FPropertyInvalidate().
+ *
+ * Without XCB support FPropertyPrefetch() does nothing and the F* functions
+ * simply call Xlib.
+ */
+
+/* ---------------------------- included header files ---------------------- */
+
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+
+/* ---------------------------- global definitions ------------------------- */
+
+/* ---------------------------- global macros ------------------------------ */
+
+/* ---------------------------- type definitions --------------------------- */
+
+/* ---------------------------- forward declarations ----------------------- */
+
+/* ---------------------------- exported variables (globals) --------------- */
+
+/* ---------------------------- interface functions ------------------------ */
+
+/* Fetch the attributes, the geometry and the given properties of all
+ * windows in one go.  Windows that are already cached are skipped.  Returns
+ * the number of windows that have been fetched. */
+int FPropertyPrefetch(
+	Display *dpy, Window *windows, int n_windows, Atom *atoms,
+	int n_atoms);
+/* Forget everything that is cached for the window. */
+void FPropertyDrop(Window w);
+/* Forget everything. */
+void FPropertyDropAll(void);
+/* Forget a single cached property; None forgets the window attributes
+ * instead, e.g. after mapping the window or selecting input on it. */
+void FPropertyInvalidate(Window w, Atom property);
+/* Print statistics about the requests saved so far. */
+void FPropertyPrintInfo(int verbose);
+
+/* Replacements for the Xlib functions. */
+Status FGetWindowAttributes(
+	Display *dpy, Window w, XWindowAttributes *window_attributes_return);
+Status FGetGeometry(
+	Display *dpy, Drawable d, Window *root_return, int *x_return,
+	int *y_return, unsigned int *width_return,
+	unsigned int *height_return, unsigned int *border_width_return,
+	unsigned int *depth_return);
+int FGetWindowProperty(
+	Display *dpy, Window w, Atom property, long long_offset,
+	long long_length, Bool delete, Atom req_type,
+	Atom *actual_type_return, int *actual_format_return,
+	unsigned long *nitems_return, unsigned long *bytes_after_return,
+	unsigned char **prop_return);
+XWMHints *FGetWMHints(Display *dpy, Window w);
+Status FGetClassHint(Display *dpy, Window w, XClassHint *class_hints_return);
+Status FGetTransientForHint(
+	Display *dpy, Window w, Window *prop_window_return);
+Status FGetWMProtocols(
+	Display *dpy, Window w, Atom **protocols_return, int *count_return);
+Status FGetWMColormapWindows(
+	Display *dpy, Window w, Window **windows_return, int *count_return);
+Status FGetTextProperty(
+	Display *dpy, Window w, XTextProperty *text_prop_return,
+	Atom property);
+Status FGetWMName(Display *dpy, Window w, XTextProperty *text_prop_return);
+Status FGetWMIconName(
+	Display *dpy, Window w, XTextProperty *text_prop_return);
+Status FGetCommand(
+	Display *dpy, Window w, char ***argv_return, int *argc_return);
+/* Like XGetWMSizeHints, but the hints are sanitized like with
+ * FGetWMNormalHints. */
+Status FGetWMSizeHints(
+	Display *dpy, Window w, XSizeHints *hints_return,
+	long *supplied_return, Atom property);
+
+#endif /* FPROPERTY_H */
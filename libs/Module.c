@@ -18,31 +18,322 @@
 */
 #include "config.h"
 #include <stdio.h>
+#include <string.h>
 #include <ctype.h>
+#include <errno.h>
 #include "libs/defaults.h"
 #include "Module.h"
 #include "Parse.h"
+#include "fring.h"
+
+/* shared memory ring, see InitFvwmRing() */
+static fring_t *module_ring = NULL;
+/* the descriptor numbers of the pipes the ring replaces */
+static int module_ring_fd = -1;
+static int module_ring_alive_fd = -1;
+static Bool is_module_ring_in_use = False;
+
+/* the buffer of ReadFvwmPackets(); packets start at a multiple of
+ * sizeof(unsigned long) because their sizes are */
+#define READER_SIZE_BYTE (32 * FvwmPacketMaxSize_byte)
+#define READER_MAX_PACKETS (READER_SIZE_BYTE / FvwmPacketHeaderSize_byte)
+static struct
+{
+	unsigned long buffer[READER_SIZE_BYTE / sizeof(unsigned long)];
+	/* byte offsets of the first unused and the first free byte */
+	int start;
+	int end;
+	FvwmPacket *packets[READER_MAX_PACKETS];
+} reader;
+
+/* a snapshot being received, see FvwmSnapshotAddPacket() */
+#define SNAPSHOT_MAX_WORDS (1 << 22)
+typedef struct
+{
+	unsigned long *data;
+	/* total words, words received and words handed out */
+	unsigned long size;
+	unsigned long have;
+	unsigned long pos;
+	unsigned long time;
+	unsigned long buffer[FvwmPacketMaxSize];
+} snapshot_t;
+
+/* the window list and the configuration lines may be received at the
+ * same time, e.g. if a module reads its configuration again while it still
+ * handles the window list */
+static snapshot_t window_snapshot;
+static snapshot_t config_snapshot;
 
 /*
  * Loop until count bytes are read, unless an error or end-of-file
- * condition occurs.
+ * condition occurs.  Returns 1 on end-of-file before the first byte.
  */
 inline
 static int positive_read(int fd, char *buf, int count)
 {
+	int is_first = 1;
+
 	while (count > 0)
 	{
 		int n_read = read(fd, buf, count);
 		if (n_read <= 0)
 		{
-			return -1;
+			return (n_read == 0 && is_first) ? 1 : -1;
 		}
+		is_first = 0;
 		buf += n_read;
 		count -= n_read;
 	}
 	return 0;
 }
 
+/*
+ * Reads the next packet from the shared memory ring, waiting for it if
+ * necessary.
+ */
+static FvwmPacket *read_ring_packet(unsigned long *buffer)
+{
+	FvwmPacket *packet = (FvwmPacket *)buffer;
+	int n;
+
+	while ((n = fring_read(
+			module_ring, buffer, FvwmPacketMaxSize_byte)) == 0)
+	{
+		if (!fring_wait(module_ring, module_ring_alive_fd))
+		{
+			return NULL;
+		}
+	}
+	if (
+		n < (int)FvwmPacketHeaderSize_byte ||
+		packet->start_pattern != START_FLAG)
+	{
+		return NULL;
+	}
+
+	return packet;
+}
+
+/*
+ * Switches to the shared memory ring after fvwm has closed the pipe fd.
+ * Returns False if the end of the pipe means that fvwm has gone.
+ */
+static Bool switch_to_ring(int fd)
+{
+	if (
+		module_ring == NULL || fd != module_ring_fd ||
+		!fring_is_active(module_ring))
+	{
+		return False;
+	}
+	/* the doorbell takes over the descriptor number so the caller's
+	 * select() keeps working */
+	fring_move_doorbell(module_ring, fd);
+	is_module_ring_in_use = True;
+
+	return True;
+}
+
+/*
+ * Returns the size in bytes of the packet at the start of the reader
+ * buffer, 0 if its header is not complete yet and -1 if it is too long.
+ * Words before the start flag are dropped.
+ */
+static int reader_packet_size(void)
+{
+	FvwmPacket *packet;
+	int size;
+
+	while (
+		reader.end - reader.start >= (int)sizeof(unsigned long) &&
+		reader.buffer[reader.start / sizeof(unsigned long)] !=
+		START_FLAG)
+	{
+		reader.start += sizeof(unsigned long);
+	}
+	if (reader.end - reader.start < (int)FvwmPacketHeaderSize_byte)
+	{
+		return 0;
+	}
+	packet = (FvwmPacket *)&reader.buffer[
+		reader.start / sizeof(unsigned long)];
+	if (
+		packet->size < FvwmPacketHeaderSize ||
+		packet->size > FvwmPacketMaxSize)
+	{
+		return -1;
+	}
+	size = packet->size * sizeof(unsigned long);
+
+	return size;
+}
+
+/*
+ * Takes the packet at the start of the reader buffer if it is complete.
+ * Returns NULL otherwise; *is_bad is set if the data is garbage.
+ */
+static FvwmPacket *reader_take_packet(Bool *is_bad)
+{
+	FvwmPacket *packet;
+	int size;
+
+	size = reader_packet_size();
+	*is_bad = (size < 0);
+	if (size <= 0 || reader.end - reader.start < size)
+	{
+		return NULL;
+	}
+	packet = (FvwmPacket *)&reader.buffer[
+		reader.start / sizeof(unsigned long)];
+	reader.start += size;
+
+	return packet;
+}
+
+/*
+ * Reads the rest of the packet that has been read partially by
+ * ReadFvwmPackets(), without reading beyond it.  ReadFvwmPackets() leaves
+ * enough room behind the partial packet.
+ */
+static FvwmPacket *reader_finish_packet(int fd)
+{
+	FvwmPacket *packet;
+	Bool is_bad;
+
+	while ((packet = reader_take_packet(&is_bad)) == NULL)
+	{
+		int size;
+		int n;
+
+		if (is_bad)
+		{
+			return NULL;
+		}
+		size = reader_packet_size();
+		n = (size == 0) ?
+			(int)FvwmPacketHeaderSize_byte -
+			(reader.end - reader.start) :
+			size - (reader.end - reader.start);
+		if (positive_read(
+			    fd, (char *)reader.buffer + reader.end, n) != 0)
+		{
+			return NULL;
+		}
+		reader.end += n;
+	}
+
+	return packet;
+}
+
+/*
+ * Reads as many packets from the shared memory ring as the reader buffer
+ * can take, waiting for the first one.  Returns the number of packets.
+ */
+static int reader_read_ring(void)
+{
+	int count = 0;
+
+	while (READER_SIZE_BYTE - reader.end >= (int)FvwmPacketMaxSize_byte)
+	{
+		FvwmPacket *packet;
+		int n;
+
+		packet = (FvwmPacket *)&reader.buffer[
+			reader.end / sizeof(unsigned long)];
+		n = fring_read(module_ring, (unsigned long *)packet,
+			       FvwmPacketMaxSize_byte);
+		if (n < 0)
+		{
+			return 0;
+		}
+		if (n == 0)
+		{
+			if (count > 0)
+			{
+				break;
+			}
+			if (!fring_wait(module_ring, module_ring_alive_fd))
+			{
+				return 0;
+			}
+			continue;
+		}
+		if (
+			n < (int)FvwmPacketHeaderSize_byte ||
+			packet->start_pattern != START_FLAG)
+		{
+			return 0;
+		}
+		reader.end += n;
+		reader.start = reader.end;
+		reader.packets[count++] = packet;
+	}
+
+	return count;
+}
+
+/*
+ * Reads all packets fvwm has sent so far, at least one.
+ */
+int ReadFvwmPackets(int fd, FvwmPacket ***ret_packets)
+{
+	int count;
+	Bool is_bad;
+
+	*ret_packets = reader.packets;
+	/* the packets of the last call are no longer in use */
+	if (reader.start > 0)
+	{
+		memmove(
+			reader.buffer, (char *)reader.buffer + reader.start,
+			reader.end - reader.start);
+		reader.end -= reader.start;
+		reader.start = 0;
+	}
+	if (is_module_ring_in_use && fd == module_ring_fd)
+	{
+		return reader_read_ring();
+	}
+	for (count = 0; count == 0; )
+	{
+		int n;
+		FvwmPacket *packet;
+
+		while ((packet = reader_take_packet(&is_bad)) != NULL)
+		{
+			reader.packets[count++] = packet;
+		}
+		if (is_bad)
+		{
+			return 0;
+		}
+		if (count > 0)
+		{
+			break;
+		}
+		/* keep room for completing a partial packet in place, see
+		 * reader_finish_packet() */
+		n = read(
+			fd, (char *)reader.buffer + reader.end,
+			READER_SIZE_BYTE - FvwmPacketMaxSize_byte - reader.end);
+		if (n == 0 && reader.end == 0 && switch_to_ring(fd))
+		{
+			return reader_read_ring();
+		}
+		if (n < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if (n <= 0)
+		{
+			return 0;
+		}
+		reader.end += n;
+	}
+
+	return count;
+}
 
 /*
  * Reads a single packet of info from fvwm.
@@ -56,6 +347,16 @@ FvwmPacket *ReadFvwmPacket(int fd)
 	FvwmPacket *packet = (FvwmPacket *)buffer;
 	unsigned long length;
 
+	if (reader.end > reader.start)
+	{
+		/* packets left by ReadFvwmPackets() come first */
+		return reader_finish_packet(fd);
+	}
+	if (is_module_ring_in_use && fd == module_ring_fd)
+	{
+		return read_ring_packet(buffer);
+	}
+
 	/* The `start flag' value supposedly exists to synchronize the
 	 * fvwm -> module communication.  However, the communication goes
 	 * through a pipe.  I don't see how any data could ever get lost,
@@ -63,8 +364,16 @@ FvwmPacket *ReadFvwmPacket(int fd)
 	 */
 	do
 	{
-		if (positive_read(fd, (char *)buffer, sizeof(unsigned long))
-			< 0)
+		int rc;
+
+		rc = positive_read(fd, (char *)buffer, sizeof(unsigned long));
+		if (rc == 1 && switch_to_ring(fd))
+		{
+			/* fvwm has closed the pipe after switching to the
+			 * ring */
+			return read_ring_packet(buffer);
+		}
+		if (rc != 0)
 		{
 			return NULL;
 		}
@@ -72,7 +381,7 @@ FvwmPacket *ReadFvwmPacket(int fd)
 
 	/* Now read the rest of the header */
 	if (positive_read(fd, (char *)(&buffer[1]), 3 * sizeof(unsigned long))
-		< 0)
+		!= 0)
 	{
 		return NULL;
 	}
@@ -83,14 +392,133 @@ FvwmPacket *ReadFvwmPacket(int fd)
 		return NULL;
 	}
 	/* Finally, read the body, and we're done */
-	if (positive_read(fd, (char *)(&buffer[4]), length) < 0)
+	if (positive_read(fd, (char *)(&buffer[4]), length) != 0)
+	{
+		return NULL;
+	}
+
+	return packet;
+}
+
+static void snapshot_free(snapshot_t *snapshot)
+{
+	if (snapshot->data != NULL)
+	{
+		free(snapshot->data);
+	}
+	snapshot->data = NULL;
+	snapshot->size = 0;
+	snapshot->have = 0;
+	snapshot->pos = 0;
+
+	return;
+}
+
+static int snapshot_add_packet(snapshot_t *snapshot, FvwmPacket *packet)
+{
+	unsigned long n;
+	unsigned long total;
+	unsigned long offset;
+
+	if (
+		FvwmPacketBodySize(*packet) < MX_WINDOW_SNAPSHOT_HEADER_SIZE ||
+		packet->body[0] != MX_WINDOW_SNAPSHOT_VERSION)
+	{
+		return -1;
+	}
+	n = FvwmPacketBodySize(*packet) - MX_WINDOW_SNAPSHOT_HEADER_SIZE;
+	total = packet->body[1];
+	offset = packet->body[2];
+	if (offset == 0)
+	{
+		snapshot_free(snapshot);
+		if (total > SNAPSHOT_MAX_WORDS)
+		{
+			return -1;
+		}
+		snapshot->size = total;
+		snapshot->data = fxmalloc(
+			(total + 1) * sizeof(unsigned long));
+	}
+	if (
+		snapshot->data == NULL || total != snapshot->size ||
+		offset != snapshot->have || n > total - offset)
+	{
+		/* a chunk is missing */
+		snapshot_free(snapshot);
+		return -1;
+	}
+	memcpy(
+		&snapshot->data[offset],
+		&packet->body[MX_WINDOW_SNAPSHOT_HEADER_SIZE],
+		n * sizeof(unsigned long));
+	snapshot->have += n;
+	snapshot->time = packet->timestamp;
+
+	return (snapshot->have == snapshot->size) ? 1 : 0;
+}
+
+static FvwmPacket *snapshot_next_packet(snapshot_t *snapshot)
+{
+	FvwmPacket *packet = (FvwmPacket *)snapshot->buffer;
+	unsigned long n;
+
+	if (snapshot->data == NULL || snapshot->have != snapshot->size)
+	{
+		return NULL;
+	}
+	if (snapshot->size - snapshot->pos < 2)
+	{
+		snapshot_free(snapshot);
+		return NULL;
+	}
+	n = snapshot->data[snapshot->pos];
+	if (
+		n > FvwmPacketBodyMaxSize ||
+		n > snapshot->size - snapshot->pos - 2)
 	{
+		/* bad record */
+		snapshot_free(snapshot);
 		return NULL;
 	}
+	packet->start_pattern = START_FLAG;
+	packet->type = snapshot->data[snapshot->pos + 1];
+	packet->size = n + FvwmPacketHeaderSize;
+	packet->timestamp = snapshot->time;
+	memcpy(
+		packet->body, &snapshot->data[snapshot->pos + 2],
+		n * sizeof(unsigned long));
+	snapshot->pos += n + 2;
 
 	return packet;
 }
 
+/*
+ * Collects the chunks of a window list snapshot.  A chunk with offset 0
+ * starts a new snapshot and drops what is left of the old one.  The chunks
+ * of the configuration lines go to a snapshot of their own.
+ */
+int FvwmSnapshotAddPacket(FvwmPacket *packet)
+{
+	switch (packet->type)
+	{
+	case MX_WINDOW_SNAPSHOT:
+		return snapshot_add_packet(&window_snapshot, packet);
+	case M_CONFIG_INFO:
+		return snapshot_add_packet(&config_snapshot, packet);
+	default:
+		return -1;
+	}
+}
+
+/*
+ * Rebuilds the next packet of a complete window list snapshot.
+ */
+FvwmPacket *FvwmSnapshotNextPacket(void)
+{
+	return snapshot_next_packet(&window_snapshot);
+}
+
 
 /*
  *
@@ -221,6 +649,14 @@ void SetSyncMask(int *fd, unsigned long mask)
 	SendText(fd, set_syncmask_mesg, 0);
 }
 
+void SetSyncTimeout(int *fd, int msecs)
+{
+	char set_synctimeout_mesg[50];
+
+	sprintf(set_synctimeout_mesg, "SET_SYNC_TIMEOUT %d", msecs);
+	SendText(fd, set_synctimeout_mesg, 0);
+}
+
 void SetNoGrabMask(int *fd, unsigned long mask)
 {
 	char set_nograbmask_mesg[50];
@@ -229,6 +665,59 @@ void SetNoGrabMask(int *fd, unsigned long mask)
 	SendText(fd, set_nograbmask_mesg, 0);
 }
 
+void SetCoalesceMask(int *fd, unsigned long mask)
+{
+	char set_coalescemask_mesg[50];
+
+	sprintf(set_coalescemask_mesg, "SET_COALESCE_MASK %lu", mask);
+	SendText(fd, set_coalescemask_mesg, 0);
+}
+
+void SetMessageFilter(int *fd, const char *conditions)
+{
+	char *mesg;
+
+	if (conditions == NULL)
+	{
+		conditions = "";
+	}
+	mesg = fxmalloc(strlen(conditions) + 12);
+	sprintf(mesg, "SET_FILTER %s", conditions);
+	SendText(fd, mesg, 0);
+	free(mesg);
+}
+
+/*
+ * Asks fvwm to send packets through a shared memory ring instead of the
+ * pipe.  The ring is created here and fvwm copies its descriptors from the
+ * module.  fvwm first flushes what is queued for the pipe and then closes it;
+ * ReadFvwmPacket() switches over when it reaches the end of the pipe.
+ * Returns 1 if the ring was requested.
+ */
+int InitFvwmRing(int *fd)
+{
+	char msg[64];
+
+	if (module_ring != NULL)
+	{
+		return 1;
+	}
+	module_ring = fring_create(FRING_DEFAULT_SIZE);
+	if (module_ring == NULL)
+	{
+		return 0;
+	}
+	module_ring_fd = fd[1];
+	module_ring_alive_fd = fd[0];
+	sprintf(
+		msg, "SET_RING %d %d %d", fring_get_mem_fd(module_ring),
+		fring_get_doorbell_fd(module_ring),
+		fring_get_space_fd(module_ring));
+	SendText(fd, msg, 0);
+
+	return 1;
+}
+
 /*
  * Optional routine that sets the matching criteria for config lines
  * that should be sent to a module by way of the GetConfigLine function.
@@ -241,7 +730,9 @@ void InitGetConfigLine(int *fd, char *match)
 {
 	char *buffer = (char *)alloca(strlen(match) + 32);
 	first_pass = 0;              /* make sure get wont do this */
-	sprintf(buffer, "Send_ConfigInfo %s", match);
+	/* lines left over from the last time must not be returned */
+	snapshot_free(&config_snapshot);
+	sprintf(buffer, "Send_ConfigInfo Bulk %s", match);
 	SendText(fd, buffer, 0);
 }
 
@@ -263,13 +754,28 @@ void GetConfigLine(int *fd, char **tline)
 
 	if (first_pass)
 	{
-		SendText(fd, "Send_ConfigInfo", 0);
+		snapshot_free(&config_snapshot);
+		SendText(fd, "Send_ConfigInfo Bulk", 0);
 		first_pass = 0;
 	}
 
 	do
 	{
-		packet = ReadFvwmPacket(fd[1]);
+		/* fvwm sends all lines at once in a snapshot */
+		packet = snapshot_next_packet(&config_snapshot);
+		if (packet == NULL)
+		{
+			packet = ReadFvwmPacket(fd[1]);
+			if (
+				packet != NULL &&
+				packet->type == M_CONFIG_INFO &&
+				FvwmPacketBodySize(*packet) > 0 &&
+				packet->body[0] != 0)
+			{
+				snapshot_add_packet(&config_snapshot, packet);
+				continue;
+			}
+		}
 		if (packet == NULL || packet->type == M_END_CONFIG_INFO)
 		{
 			*tline = NULL;
@@ -119,9 +119,10 @@ typedef struct
 #define MX_LEAVE_WINDOW           ((1<<2) | M_EXTENDED_MSG)
 #define MX_PROPERTY_CHANGE        ((1<<3) | M_EXTENDED_MSG)
 #define MX_REPLY		  ((1<<4) | M_EXTENDED_MSG)
-#define MAX_EXTENDED_MESSAGES     5
+#define MX_WINDOW_SNAPSHOT        ((1<<5) | M_EXTENDED_MSG)
+#define MAX_EXTENDED_MESSAGES     6
 #define DEFAULT_XMSG_MASK         0x00000000
-#define MAX_XMSG_MASK             0x0000001f
+#define MAX_XMSG_MASK             0x0000003f
 
 #define MAX_TOTAL_MESSAGES   (MAX_MESSAGES + MAX_EXTENDED_MESSAGES)
 
@@ -130,6 +131,16 @@ typedef struct
 #define MX_PROPERTY_CHANGE_BACKGROUND  1
 #define MX_PROPERTY_CHANGE_SWALLOW     2
 
+/* for MX_WINDOW_SNAPSHOT; the body starts with the version, the total
+ * number of words in the snapshot and the offset of this chunk, followed by
+ * the chunk.  The snapshot is a sequence of records, one per packet that
+ * Send_WindowList would have sent, made of the number of body words, the
+ * packet type and the packet body.  "Send_ConfigInfo Bulk" sends the
+ * configuration lines the same way in M_CONFIG_INFO packets; these have the
+ * version where a normal M_CONFIG_INFO packet has zero. */
+#define MX_WINDOW_SNAPSHOT_VERSION     1
+#define MX_WINDOW_SNAPSHOT_HEADER_SIZE 3
+
 /**
  * Reads a single packet of info from fvwm.
  * The packet is stored into static memory that is reused during
@@ -138,6 +149,34 @@ typedef struct
  **/
 FvwmPacket* ReadFvwmPacket( int fd );
 
+/**
+ * Reads all packets that fvwm has sent so far, waiting for the first one,
+ * with as few read() calls as possible.  Stores a pointer to an array of
+ * the packets in *ret_packets and returns their number, or 0 if fvwm has
+ * gone.  The packets stay valid until the next call to ReadFvwmPackets, so
+ * a module can keep several of them.  Reads all packets from fvwm, so use
+ * it in place of ReadFvwmPacket in a module's select() loop; it is safe to
+ * call ReadFvwmPacket (e.g. through GetConfigLine) while the packets are
+ * in use.  Only one descriptor can be read this way.
+ **/
+int ReadFvwmPackets(int fd, FvwmPacket ***ret_packets);
+
+/**
+ * A module that has MX_WINDOW_SNAPSHOT in its message mask can ask for the
+ * window list with "Send_WindowList Snapshot".  Instead of about ten packets
+ * per window, fvwm then sends the packets as records of a snapshot that
+ * comes in a few MX_WINDOW_SNAPSHOT packets, once per monitor.  Pass each of
+ * them to FvwmSnapshotAddPacket.  It returns 1 when the snapshot is
+ * complete, 0 if more packets are needed and -1 if the packet can not be
+ * used.  Then FvwmSnapshotNextPacket returns the packets of the snapshot
+ * one by one, as ReadFvwmPacket would have, and NULL after the last one.
+ * The packet is stored into static memory that is reused during the next
+ * call.  GetConfigLine does all this for the configuration lines, in a
+ * snapshot of its own that does not disturb the window list.
+ **/
+int FvwmSnapshotAddPacket(FvwmPacket *packet);
+FvwmPacket *FvwmSnapshotNextPacket(void);
+
 
 /*
  *
@@ -198,6 +237,16 @@ void SetMessageMask(int *fd, unsigned long mask);
  */
 void SetSyncMask(int *fd, unsigned long mask);
 
+/*
+ *
+ * Sets how many milliseconds fvwm waits for the unlock after a message in
+ * the sync mask.  When the time is over, fvwm carries on without killing
+ * the module.  With 0, the default, fvwm waits ModuleTimeout seconds and
+ * then kills the module.
+ *
+ */
+void SetSyncTimeout(int *fd, int msecs);
+
 /*
  *
  * Sets the which-message-types-I-do-not-want while the server is grabbed
@@ -206,6 +255,41 @@ void SetSyncMask(int *fd, unsigned long mask);
  */
 void SetNoGrabMask(int *fd, unsigned long mask);
 
+/*
+ *
+ * Sets the message types of which the module only needs the latest one per
+ * window.  While the module lags behind, fvwm drops a queued packet of such
+ * a type when a newer one for the same window comes (for M_FOCUS_CHANGE,
+ * for any window).  Only M_CONFIGURE_WINDOW, M_WINDOW_NAME, M_ICON_NAME,
+ * M_VISIBLE_NAME, MX_VISIBLE_ICON_NAME, M_RES_CLASS, M_RES_NAME,
+ * M_MINI_ICON and M_FOCUS_CHANGE can be coalesced; other bits are ignored.
+ *
+ */
+void SetCoalesceMask(int *fd, unsigned long mask);
+
+/*
+ *
+ * Sets conditions as for the Next command, e.g. "Desk 2, !Iconic, Monitor
+ * DP-1", that a window must match for the module to get messages about
+ * it.  A window that stops matching gets one more message, so the module
+ * sees it e.g. leave the desk; M_DESTROY_WINDOW comes only for windows the
+ * module has been told about.  Set the filter before asking for the window
+ * list.  NULL or an empty string removes the filter.
+ *
+ */
+void SetMessageFilter(int *fd, const char *conditions);
+
+/*
+ * Asks fvwm to send further packets through shared memory instead of the
+ * pipe fd[1].  The module creates the ring and fvwm takes it over.  The
+ * module must read all packets with ReadFvwmPacket(fd[1]) or
+ * ReadFvwmPackets(fd[1]) and may select() on fd[1] as before.  Returns 1 if
+ * the ring has been requested and 0 if it is not available.  Packets keep
+ * coming through the pipe until fvwm has switched, and for good if fvwm can
+ * not use the ring.
+ */
+int InitFvwmRing(int *fd);
+
 /*
  * Used to ask for subset of module configuration lines.
  * Allows modules to get configuration lines more than once.
@@ -215,6 +299,8 @@ void InitGetConfigLine(int *fd, char *match);
 /**
  * Gets a module configuration line from fvwm. Returns NULL if there are
  * no more lines to be had. "line" is a pointer to a char *.
+ * fvwm sends all lines at once as a snapshot (see FvwmSnapshotAddPacket),
+ * so reading the configuration does not take a round trip per line.
  **/
 void GetConfigLine(int *fd, char **line);
 
@@ -157,6 +157,9 @@
 #define GEOMETRY_WINDOW_STRING             " +8888 x +8888 "
 #define GEOMETRY_WINDOW_POS_STRING         " %+-4d %+-4d "
 #define GEOMETRY_WINDOW_SIZE_STRING        " %4d x %-4d "
+/* appended with BugOpts DebugFrameRate */
+#define GEOMETRY_WINDOW_RATE_STRING        " 8888 / 888.8 ms "
+#define GEOMETRY_WINDOW_RATE_FMT_STRING    " %4d / %5.1f ms "
 
 /*
  * window title layout
@@ -248,6 +251,7 @@
 
 /*** movement ***/
 #define DEFAULT_OPAQUE_MOVE_SIZE           5 /* percent of window area */
+#define DEFAULT_OPAQUE_FRAME_RATE          0 /* frames per second */
 #define DEFAULT_SNAP_ATTRACTION            0 /* snap nothing */
 #define DEFAULT_SNAP_ATTRACTION_MODE     0x3 /* snap all */
 #define DEFAULT_SNAP_GRID_X                1 /* pixels */
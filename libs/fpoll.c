@@ -0,0 +1,702 @@
+/* -*-c-*- */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see: <http://www.gnu.org/licenses/>
+ */
+
+/* ---------------------------- included header files ---------------------- */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#ifdef HAVE_EPOLL
+#include <time.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#endif
+
+#include "safemalloc.h"
+#include "ftime.h"
+#include "System.h"
+#include "fvwmsignal.h"
+#include "fpoll.h"
+
+/* ---------------------------- local definitions -------------------------- */
+
+#define FPOLL_MAX_EPOLL_EVENTS 64
+
+/* ---------------------------- local macros ------------------------------- */
+
+/* ---------------------------- imports ------------------------------------ */
+
+/* ---------------------------- included code files ------------------------ */
+
+/* ---------------------------- local types -------------------------------- */
+
+typedef struct
+{
+	void *data;
+	unsigned int events;
+	unsigned is_registered : 1;
+} fpoll_reg_t;
+
+/* ---------------------------- forward declarations ----------------------- */
+
+/* ---------------------------- local variables ---------------------------- */
+
+static fpoll_backend_t backend = FPOLL_BACKEND_NONE;
+/* registered descriptors, indexed by descriptor number */
+static fpoll_reg_t *regs = NULL;
+static int n_regs = 0;
+/* one more than the highest registered descriptor */
+static int regs_end = 0;
+/* select backend: absolute timer deadline */
+static struct timeval timer_deadline;
+static int is_timer_armed = 0;
+#ifdef HAVE_EPOLL
+static int epoll_fd = -1;
+static int signal_fd = -1;
+static int timer_fd = -1;
+static sigset_t routed_signals;
+/* absolute CLOCK_MONOTONIC deadline the timerfd is armed with */
+static struct timespec timer_fd_deadline;
+#endif
+
+/* ---------------------------- exported variables (globals) --------------- */
+
+/* ---------------------------- local functions ---------------------------- */
+
+static fpoll_reg_t *fpoll_get_reg(int fd)
+{
+	if (fd < 0 || fd >= n_regs || !regs[fd].is_registered)
+	{
+		return NULL;
+	}
+
+	return &regs[fd];
+}
+
+static void fpoll_grow_regs(int fd)
+{
+	int n;
+
+	if (fd < n_regs)
+	{
+		return;
+	}
+	for (n = (n_regs > 0) ? n_regs : 64; n <= fd; n *= 2)
+	{
+		/* nothing */
+	}
+	regs = fxrealloc(regs, n, sizeof(fpoll_reg_t));
+	memset(regs + n_regs, 0, (n - n_regs) * sizeof(fpoll_reg_t));
+	n_regs = n;
+
+	return;
+}
+
+static void fpoll_get_now(struct timeval *tv)
+{
+	gettimeofday(tv, NULL);
+
+	return;
+}
+
+/* returns the milliseconds until the select backend's timer fires, -1 if it
+ * is not armed */
+static int fpoll_select_timer_ms(void)
+{
+	struct timeval now;
+	long ms;
+
+	if (!is_timer_armed)
+	{
+		return -1;
+	}
+	fpoll_get_now(&now);
+	ms = (timer_deadline.tv_sec - now.tv_sec) * 1000 +
+		(timer_deadline.tv_usec - now.tv_usec + 999) / 1000;
+
+	return (ms < 0) ? 0 : (int)ms;
+}
+
+static int fpoll_select_wait(
+	fpoll_event_t *ret_events, int max_events, int timeout_ms)
+{
+	fd_set in_fdset;
+	fd_set out_fdset;
+	struct timeval timeout;
+	struct timeval *timeoutP;
+	int timer_ms;
+	int is_timer_timeout = 0;
+	int num_fd;
+	int fd;
+	int n;
+
+	timer_ms = fpoll_select_timer_ms();
+	if (timer_ms >= 0 && (timeout_ms < 0 || timer_ms <= timeout_ms))
+	{
+		timeout_ms = timer_ms;
+		is_timer_timeout = 1;
+	}
+	if (timeout_ms >= 0)
+	{
+		timeout.tv_sec = timeout_ms / 1000;
+		timeout.tv_usec = 1000 * (timeout_ms % 1000);
+		timeoutP = &timeout;
+	}
+	else
+	{
+		timeoutP = NULL;
+	}
+	FD_ZERO(&in_fdset);
+	FD_ZERO(&out_fdset);
+	for (fd = 0; fd < regs_end; fd++)
+	{
+		if (!regs[fd].is_registered)
+		{
+			continue;
+		}
+		if (regs[fd].events & FPOLL_IN)
+		{
+			FD_SET(fd, &in_fdset);
+		}
+		if (regs[fd].events & FPOLL_OUT)
+		{
+			FD_SET(fd, &out_fdset);
+		}
+	}
+	num_fd = fvwmSelect(regs_end, &in_fdset, &out_fdset, 0, timeoutP);
+	if (num_fd < 0)
+	{
+		return -1;
+	}
+	n = 0;
+	if (num_fd == 0 && is_timer_timeout)
+	{
+		is_timer_armed = 0;
+		ret_events[n].fd = -1;
+		ret_events[n].events = FPOLL_TIMER;
+		n++;
+	}
+	for (fd = 0; num_fd > 0 && fd < regs_end && n < max_events; fd++)
+	{
+		unsigned int events = 0;
+
+		if (!regs[fd].is_registered)
+		{
+			continue;
+		}
+		if (FD_ISSET(fd, &in_fdset))
+		{
+			events |= FPOLL_IN;
+		}
+		if (FD_ISSET(fd, &out_fdset))
+		{
+			events |= FPOLL_OUT;
+		}
+		if (events != 0)
+		{
+			ret_events[n].fd = fd;
+			ret_events[n].events = events;
+			n++;
+		}
+	}
+
+	return n;
+}
+
+#ifdef HAVE_EPOLL
+static int fpoll_epoll_init(void)
+{
+	epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if (epoll_fd < 0)
+	{
+		return -1;
+	}
+	timer_fd = timerfd_create(
+		CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if (timer_fd < 0)
+	{
+		close(epoll_fd);
+		epoll_fd = -1;
+
+		return -1;
+	}
+	{
+		struct epoll_event ev;
+
+		memset(&ev, 0, sizeof(ev));
+		ev.events = EPOLLIN;
+		ev.data.fd = timer_fd;
+		if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, timer_fd, &ev) < 0)
+		{
+			close(timer_fd);
+			close(epoll_fd);
+			timer_fd = -1;
+			epoll_fd = -1;
+
+			return -1;
+		}
+	}
+	sigemptyset(&routed_signals);
+
+	return 0;
+}
+
+static void fpoll_dispatch_signals(void)
+{
+	struct signalfd_siginfo si;
+	struct sigaction sa;
+
+	while (read(signal_fd, &si, sizeof(si)) == sizeof(si))
+	{
+		int sig = (int)si.ssi_signo;
+
+		/* call the handler exactly as the kernel would have done */
+		if (sigaction(sig, NULL, &sa) == 0 &&
+		    sa.sa_handler != SIG_DFL && sa.sa_handler != SIG_IGN)
+		{
+			sa.sa_handler(sig);
+		}
+	}
+
+	return;
+}
+
+static void fpoll_epoll_set_timer(int ms)
+{
+	struct itimerspec its;
+	struct timespec deadline;
+
+	memset(&its, 0, sizeof(its));
+	if (ms >= 0)
+	{
+		clock_gettime(CLOCK_MONOTONIC, &deadline);
+		deadline.tv_sec += ms / 1000;
+		deadline.tv_nsec += (long)(ms % 1000) * 1000000;
+		if (deadline.tv_nsec >= 1000000000)
+		{
+			deadline.tv_sec++;
+			deadline.tv_nsec -= 1000000000;
+		}
+		/* The schedule queue is queried before every wait, but the
+		 * deadline rarely changes; avoid rearming the timer if it
+		 * differs by less than a millisecond. */
+		if (
+			deadline.tv_sec == timer_fd_deadline.tv_sec &&
+			labs(deadline.tv_nsec - timer_fd_deadline.tv_nsec) <
+			1000000)
+		{
+			return;
+		}
+		its.it_value = deadline;
+		/* a zero it_value would disarm the timer */
+		if (its.it_value.tv_sec == 0 && its.it_value.tv_nsec == 0)
+		{
+			its.it_value.tv_nsec = 1;
+		}
+	}
+	else if (
+		timer_fd_deadline.tv_sec == 0 && timer_fd_deadline.tv_nsec == 0)
+	{
+		/* already disarmed */
+		return;
+	}
+	timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &its, NULL);
+	timer_fd_deadline = its.it_value;
+
+	return;
+}
+
+static int fpoll_epoll_wait(
+	fpoll_event_t *ret_events, int max_events, int timeout_ms)
+{
+	struct epoll_event evs[FPOLL_MAX_EPOLL_EVENTS];
+	int num_fd;
+	int i;
+	int n;
+
+	if (isTerminated)
+	{
+		return -1;
+	}
+	if (max_events > FPOLL_MAX_EPOLL_EVENTS)
+	{
+		max_events = FPOLL_MAX_EPOLL_EVENTS;
+	}
+	num_fd = epoll_wait(epoll_fd, evs, max_events, timeout_ms);
+	if (num_fd < 0)
+	{
+		return -1;
+	}
+	for (i = 0, n = 0; i < num_fd; i++)
+	{
+		int fd = evs[i].data.fd;
+		unsigned int events = 0;
+
+		if (fd == timer_fd)
+		{
+			uint64_t expirations;
+
+			if (read(timer_fd, &expirations, sizeof(expirations)) < 0)
+			{
+				continue;
+			}
+			memset(&timer_fd_deadline, 0, sizeof(timer_fd_deadline));
+			ret_events[n].fd = -1;
+			ret_events[n].events = FPOLL_TIMER;
+			n++;
+			continue;
+		}
+		if (fd == signal_fd)
+		{
+			fpoll_dispatch_signals();
+			ret_events[n].fd = -1;
+			ret_events[n].events = FPOLL_SIGNAL;
+			n++;
+			continue;
+		}
+		if (evs[i].events & EPOLLIN)
+		{
+			events |= FPOLL_IN;
+		}
+		if (evs[i].events & EPOLLOUT)
+		{
+			events |= FPOLL_OUT;
+		}
+		if (evs[i].events & (EPOLLERR | EPOLLHUP))
+		{
+			/* let the owner find out about the problem when it
+			 * accesses the descriptor */
+			events |= (regs[fd].events & (FPOLL_IN | FPOLL_OUT));
+		}
+		ret_events[n].fd = fd;
+		ret_events[n].events = events;
+		n++;
+	}
+
+	return n;
+}
+#endif
+
+/* ---------------------------- interface functions ------------------------ */
+
+fpoll_backend_t fpoll_init(void)
+{
+	if (backend != FPOLL_BACKEND_NONE)
+	{
+		return backend;
+	}
+	backend = FPOLL_BACKEND_SELECT;
+#ifdef HAVE_EPOLL
+	if (fpoll_epoll_init() == 0)
+	{
+		backend = FPOLL_BACKEND_EPOLL;
+	}
+#endif
+
+	return backend;
+}
+
+fpoll_backend_t fpoll_get_backend(void)
+{
+	return backend;
+}
+
+const char *fpoll_get_backend_name(void)
+{
+	switch (backend)
+	{
+	case FPOLL_BACKEND_SELECT:
+		return "select";
+	case FPOLL_BACKEND_EPOLL:
+		return "epoll";
+	default:
+		return "none";
+	}
+}
+
+int fpoll_get_max_fd(void)
+{
+	if (backend == FPOLL_BACKEND_EPOLL)
+	{
+		return INT_MAX;
+	}
+
+	return fvwmlib_max_fd;
+}
+
+int fpoll_add(int fd, unsigned int events, void *data)
+{
+	fpoll_reg_t *reg;
+
+	if (fd < 0 || fd >= fpoll_get_max_fd())
+	{
+		return -1;
+	}
+	fpoll_grow_regs(fd);
+	reg = &regs[fd];
+#ifdef HAVE_EPOLL
+	if (backend == FPOLL_BACKEND_EPOLL)
+	{
+		struct epoll_event ev;
+		int op;
+
+		memset(&ev, 0, sizeof(ev));
+		ev.events = ((events & FPOLL_IN) ? EPOLLIN : 0) |
+			((events & FPOLL_OUT) ? EPOLLOUT : 0);
+		ev.data.fd = fd;
+		op = (reg->is_registered) ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+		if (
+			(!reg->is_registered || reg->events != events) &&
+			epoll_ctl(epoll_fd, op, fd, &ev) < 0)
+		{
+			return -1;
+		}
+	}
+#endif
+	reg->data = data;
+	reg->events = events;
+	reg->is_registered = 1;
+	if (fd >= regs_end)
+	{
+		regs_end = fd + 1;
+	}
+
+	return 0;
+}
+
+void fpoll_remove(int fd)
+{
+	fpoll_reg_t *reg;
+
+	reg = fpoll_get_reg(fd);
+	if (reg == NULL)
+	{
+		return;
+	}
+#ifdef HAVE_EPOLL
+	if (backend == FPOLL_BACKEND_EPOLL)
+	{
+		/* may fail if the descriptor is already closed */
+		epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+	}
+#endif
+	memset(reg, 0, sizeof(*reg));
+	while (regs_end > 0 && !regs[regs_end - 1].is_registered)
+	{
+		regs_end--;
+	}
+
+	return;
+}
+
+void *fpoll_get_data(int fd)
+{
+	fpoll_reg_t *reg;
+
+	reg = fpoll_get_reg(fd);
+
+	return (reg != NULL) ? reg->data : NULL;
+}
+
+void fpoll_add_signals(const sigset_t *signals)
+{
+#ifdef HAVE_EPOLL
+	struct epoll_event ev;
+	int sig;
+	int fd;
+
+	if (backend != FPOLL_BACKEND_EPOLL)
+	{
+		return;
+	}
+	for (sig = 1; sig < NSIG; sig++)
+	{
+		if (sigismember(signals, sig) == 1)
+		{
+			sigaddset(&routed_signals, sig);
+		}
+	}
+	fd = signalfd(
+		signal_fd, &routed_signals, SFD_NONBLOCK | SFD_CLOEXEC);
+	if (fd < 0)
+	{
+		return;
+	}
+	if (signal_fd < 0)
+	{
+		memset(&ev, 0, sizeof(ev));
+		ev.events = EPOLLIN;
+		ev.data.fd = fd;
+		if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0)
+		{
+			close(fd);
+			sigemptyset(&routed_signals);
+
+			return;
+		}
+		signal_fd = fd;
+	}
+	sigprocmask(SIG_BLOCK, &routed_signals, NULL);
+#endif
+
+	return;
+}
+
+void fpoll_restore_signals(void)
+{
+#ifdef HAVE_EPOLL
+	if (signal_fd >= 0)
+	{
+		sigprocmask(SIG_UNBLOCK, &routed_signals, NULL);
+	}
+#endif
+
+	return;
+}
+
+void fpoll_block_signals(void)
+{
+#ifdef HAVE_EPOLL
+	if (signal_fd >= 0)
+	{
+		sigprocmask(SIG_BLOCK, &routed_signals, NULL);
+	}
+#endif
+
+	return;
+}
+
+void fpoll_set_timer(int ms)
+{
+#ifdef HAVE_EPOLL
+	if (backend == FPOLL_BACKEND_EPOLL)
+	{
+		fpoll_epoll_set_timer(ms);
+
+		return;
+	}
+#endif
+	if (ms < 0)
+	{
+		is_timer_armed = 0;
+
+		return;
+	}
+	fpoll_get_now(&timer_deadline);
+	timer_deadline.tv_sec += ms / 1000;
+	timer_deadline.tv_usec += 1000 * (ms % 1000);
+	if (timer_deadline.tv_usec >= 1000000)
+	{
+		timer_deadline.tv_sec++;
+		timer_deadline.tv_usec -= 1000000;
+	}
+	is_timer_armed = 1;
+
+	return;
+}
+
+int fpoll_wait(fpoll_event_t *ret_events, int max_events, int timeout_ms)
+{
+	if (max_events <= 0)
+	{
+		return -1;
+	}
+#ifdef HAVE_EPOLL
+	if (backend == FPOLL_BACKEND_EPOLL)
+	{
+		return fpoll_epoll_wait(ret_events, max_events, timeout_ms);
+	}
+#endif
+
+	return fpoll_select_wait(ret_events, max_events, timeout_ms);
+}
+
+int fpoll_wait_fd(int fd, unsigned int events, int timeout_ms)
+{
+#ifdef HAVE_EPOLL
+	if (backend == FPOLL_BACKEND_EPOLL)
+	{
+		struct pollfd pfd[2];
+		int n = 1;
+		int rc;
+
+		if (isTerminated)
+		{
+			return -1;
+		}
+		pfd[0].fd = fd;
+		pfd[0].events = ((events & FPOLL_IN) ? POLLIN : 0) |
+			((events & FPOLL_OUT) ? POLLOUT : 0);
+		pfd[0].revents = 0;
+		/* the blocked signals only show up on the signalfd */
+		if (signal_fd >= 0)
+		{
+			pfd[1].fd = signal_fd;
+			pfd[1].events = POLLIN;
+			pfd[1].revents = 0;
+			n = 2;
+		}
+		rc = poll(pfd, n, timeout_ms);
+		if (rc < 0)
+		{
+			return -1;
+		}
+		if (n == 2 && pfd[1].revents != 0)
+		{
+			fpoll_dispatch_signals();
+			if (isTerminated || pfd[0].revents == 0)
+			{
+				/* interrupted as select() would have been */
+				errno = EINTR;
+				return -1;
+			}
+			rc--;
+		}
+
+		return rc;
+	}
+#endif
+	{
+		fd_set in_fdset;
+		fd_set out_fdset;
+		struct timeval timeout;
+
+		FD_ZERO(&in_fdset);
+		FD_ZERO(&out_fdset);
+		if (events & FPOLL_IN)
+		{
+			FD_SET(fd, &in_fdset);
+		}
+		if (events & FPOLL_OUT)
+		{
+			FD_SET(fd, &out_fdset);
+		}
+		timeout.tv_sec = timeout_ms / 1000;
+		timeout.tv_usec = 1000 * (timeout_ms % 1000);
+
+		return fvwmSelect(
+			fd + 1, &in_fdset, &out_fdset, NULL,
+			(timeout_ms < 0) ? NULL : &timeout);
+	}
+}
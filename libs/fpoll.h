@@ -0,0 +1,102 @@
+/* -*-c-*- */
+
+#ifndef FPOLL_H
+#define FPOLL_H
+
+/* Descriptor polling for fvwm's main loop.
+ *
+ * Descriptors are registered once and stay registered until they are
+ * removed, so the caller does not have to rebuild its interest set on every
+ * wakeup.  Two backends are available:
+ *
+ *  - epoll(7), together with a signalfd(2) for the signals passed to
+ *    fpoll_add_signals() and a timerfd(2) for fpoll_set_timer().  The signal
+ *    handlers installed with sigaction() are then called synchronously from
+ *    fpoll_wait() instead of interrupting fvwm at random places.  There is
+ *    no limit on the descriptor numbers.
+ *  - select(2) through fvwmSelect().  Signals are delivered asynchronously
+ *    as usual and the timer is emulated with the select timeout.
+ *    Descriptors must be below fpoll_get_max_fd().
+ *
+ * The epoll backend is used if fvwm was configured with it and the kernel
+ * supports it, select() otherwise.
+ */
+
+/* ---------------------------- included header files ---------------------- */
+
+#include <signal.h>
+
+/* ---------------------------- global definitions ------------------------- */
+
+#define FPOLL_IN     0x1
+#define FPOLL_OUT    0x2
+/* reported with fd == -1 */
+#define FPOLL_TIMER  0x4
+/* reported with fd == -1 after the signal handlers have run */
+#define FPOLL_SIGNAL 0x8
+
+/* ---------------------------- global macros ------------------------------ */
+
+/* ---------------------------- type definitions --------------------------- */
+
+typedef enum
+{
+	FPOLL_BACKEND_NONE = 0,
+	FPOLL_BACKEND_SELECT,
+	FPOLL_BACKEND_EPOLL
+} fpoll_backend_t;
+
+typedef struct
+{
+	int fd;
+	unsigned int events;
+} fpoll_event_t;
+
+/* ---------------------------- forward declarations ----------------------- */
+
+/* ---------------------------- exported variables (globals) --------------- */
+
+/* ---------------------------- interface functions ------------------------ */
+
+/* Initialise the event loop; call after the last fork() of the process that
+ * is going to use it.  Returns the backend in use. */
+fpoll_backend_t fpoll_init(void);
+fpoll_backend_t fpoll_get_backend(void);
+const char *fpoll_get_backend_name(void);
+/* Descriptors at or above this number can not be registered. */
+int fpoll_get_max_fd(void);
+
+/* Register a descriptor or change the events and data of a registered one.
+ * Returns 0 on success and -1 on failure. */
+int fpoll_add(int fd, unsigned int events, void *data);
+/* Unregister a descriptor.  Unknown descriptors are silently ignored. */
+void fpoll_remove(int fd);
+/* Returns the data registered with the descriptor or NULL if it is not
+ * registered (any more). */
+void *fpoll_get_data(int fd);
+
+/* Route the given signals through the event loop.  Does nothing with the
+ * select backend. */
+void fpoll_add_signals(const sigset_t *signals);
+/* Unblock the signals routed through the event loop; for child processes
+ * between fork() and exec(). */
+void fpoll_restore_signals(void);
+/* Block them again.  Around popen() and system(), whose children would
+ * otherwise inherit the blocked signals. */
+void fpoll_block_signals(void);
+
+/* Report an FPOLL_TIMER event in ms milliseconds; a negative value disarms
+ * the timer. */
+void fpoll_set_timer(int ms);
+
+/* Wait up to timeout_ms milliseconds (forever if negative) for events.
+ * Returns the number of events stored in ret_events, 0 on timeout and -1 if
+ * interrupted. */
+int fpoll_wait(fpoll_event_t *ret_events, int max_events, int timeout_ms);
+
+/* Wait for a single descriptor that need not be registered.  Returns a
+ * positive number if the descriptor is ready, 0 on timeout and -1 if
+ * interrupted. */
+int fpoll_wait_fd(int fd, unsigned int events, int timeout_ms);
+
+#endif /* FPOLL_H */
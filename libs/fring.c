@@ -0,0 +1,630 @@
+/* -*-c-*- */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see: <http://www.gnu.org/licenses/>
+ */
+
+/* ---------------------------- included header files ---------------------- */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#ifdef HAVE_SHM_RING
+#include <stdint.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#endif
+
+#include "safemalloc.h"
+#include "fring.h"
+
+/* ---------------------------- local definitions -------------------------- */
+
+#define FRING_MAGIC 0x46524e47
+#define FRING_VERSION 1
+#define FRING_CACHE_LINE 64
+
+/* shared flags */
+#define FRING_ACTIVE 0x1
+#define FRING_CLOSED 0x2
+
+/* a record length of zero sends the consumer back to the start of the ring
+ */
+#define FRING_WRAP 0
+
+/* ---------------------------- local macros ------------------------------- */
+
+#define FRING_LOAD(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define FRING_STORE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define FRING_FENCE() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define FRING_CLEAR(p) __atomic_exchange_n((p), 0, __ATOMIC_SEQ_CST)
+
+/* ---------------------------- imports ------------------------------------ */
+
+/* ---------------------------- included code files ------------------------ */
+
+/* ---------------------------- local types -------------------------------- */
+
+#ifdef HAVE_SHM_RING
+/* The start of the shared mapping, followed by the data.  Positions count
+ * unsigned longs and are never wrapped; the fields written by the producer
+ * and the consumer live on separate cache lines. */
+typedef struct
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t size;
+	uint32_t flags;
+	char pad0[FRING_CACHE_LINE - 4 * sizeof(uint32_t)];
+	/* written by the producer */
+	unsigned long head;
+	/* set by the producer when the ring is full, cleared by the consumer
+	 */
+	uint32_t need_space;
+	char pad1[FRING_CACHE_LINE - sizeof(unsigned long) - sizeof(uint32_t)];
+	/* written by the consumer */
+	unsigned long tail;
+	/* set by the consumer when the ring is empty, cleared by the producer
+	 */
+	uint32_t need_doorbell;
+	char pad2[FRING_CACHE_LINE - sizeof(unsigned long) - sizeof(uint32_t)];
+} fring_shared_t;
+
+struct fring
+{
+	fring_shared_t *shm;
+	unsigned long *data;
+	size_t map_size;
+	unsigned long size;
+	unsigned long mask;
+	/* head for the producer, tail for the consumer */
+	unsigned long pos;
+	/* producer: the tail seen by the last failed write */
+	unsigned long full_tail;
+	int mem_fd;
+	int doorbell_fd;
+	int space_fd;
+	unsigned is_producer : 1;
+	unsigned is_unsignalled : 1;
+};
+#endif
+
+/* ---------------------------- forward declarations ----------------------- */
+
+/* ---------------------------- local variables ---------------------------- */
+
+/* ---------------------------- exported variables (globals) --------------- */
+
+/* ---------------------------- local functions ---------------------------- */
+
+#ifdef HAVE_SHM_RING
+static void fring_kick(int fd)
+{
+	uint64_t v = 1;
+
+	if (write(fd, &v, sizeof(v)) < 0)
+	{
+		/* the counter can not overflow in practice */
+	}
+
+	return;
+}
+
+static void fring_drain(int fd)
+{
+	uint64_t v;
+
+	if (read(fd, &v, sizeof(v)) < 0)
+	{
+		/* EAGAIN, nothing to drain */
+	}
+
+	return;
+}
+
+static void fring_close_fds(fring_t *ring)
+{
+	close(ring->mem_fd);
+	close(ring->doorbell_fd);
+	close(ring->space_fd);
+
+	return;
+}
+
+/* The consumer ran out of packets; ask for the doorbell and clear it.
+ * Returns 1 if packets arrived in the mean time; the doorbell is then made
+ * readable again so that a select() on it does not miss them. */
+static int fring_arm(fring_t *ring)
+{
+	FRING_STORE(&ring->shm->need_doorbell, 1);
+	FRING_FENCE();
+	fring_drain(ring->doorbell_fd);
+	if (FRING_LOAD(&ring->shm->head) != ring->pos)
+	{
+		fring_kick(ring->doorbell_fd);
+		return 1;
+	}
+
+	return 0;
+}
+
+/* Returns a copy of the descriptor fd of the process pid_fd refers to, or
+ * -1. */
+static int fring_take_fd(int pid_fd, int fd)
+{
+#ifdef SYS_pidfd_getfd
+	return syscall(SYS_pidfd_getfd, pid_fd, fd, 0);
+#else
+	return -1;
+#endif
+}
+#endif
+
+/* ---------------------------- interface functions ------------------------ */
+
+#ifdef HAVE_SHM_RING
+
+fring_t *fring_create(int size)
+{
+	fring_t *ring;
+	size_t map_size;
+	void *map;
+	int mem_fd;
+	int doorbell_fd = -1;
+	int space_fd = -1;
+
+	if (size <= 0 || (size & (size - 1)) != 0)
+	{
+		return NULL;
+	}
+	map_size = sizeof(fring_shared_t) + size * sizeof(unsigned long);
+	mem_fd = memfd_create("fvwm-module-ring", MFD_CLOEXEC);
+	if (mem_fd < 0)
+	{
+		return NULL;
+	}
+	if (ftruncate(mem_fd, map_size) != 0)
+	{
+		goto err;
+	}
+	doorbell_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	space_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (doorbell_fd < 0 || space_fd < 0)
+	{
+		goto err;
+	}
+	map = mmap(
+		NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, mem_fd, 0);
+	if (map == MAP_FAILED)
+	{
+		goto err;
+	}
+	ring = fxcalloc(1, sizeof(fring_t));
+	ring->shm = map;
+	ring->data = (unsigned long *)(ring->shm + 1);
+	ring->map_size = map_size;
+	ring->size = size;
+	ring->mask = size - 1;
+	ring->mem_fd = mem_fd;
+	ring->doorbell_fd = doorbell_fd;
+	ring->space_fd = space_fd;
+	ring->shm->magic = FRING_MAGIC;
+	ring->shm->version = FRING_VERSION;
+	ring->shm->size = size;
+	/* the consumer starts out waiting */
+	ring->shm->need_doorbell = 1;
+
+	return ring;
+
+  err:
+	close(mem_fd);
+	if (doorbell_fd >= 0)
+	{
+		close(doorbell_fd);
+	}
+	if (space_fd >= 0)
+	{
+		close(space_fd);
+	}
+
+	return NULL;
+}
+
+fring_t *fring_attach(int pid, int mem_fd, int doorbell_fd, int space_fd)
+{
+	fring_t *ring;
+	fring_shared_t *shm;
+	struct stat st;
+	void *map;
+	int pid_fd = -1;
+
+#ifdef SYS_pidfd_open
+	pid_fd = syscall(SYS_pidfd_open, pid, 0);
+#endif
+	if (pid_fd < 0)
+	{
+		return NULL;
+	}
+	/* the copies are close-on-exec */
+	mem_fd = fring_take_fd(pid_fd, mem_fd);
+	doorbell_fd = fring_take_fd(pid_fd, doorbell_fd);
+	space_fd = fring_take_fd(pid_fd, space_fd);
+	close(pid_fd);
+	if (mem_fd < 0 || doorbell_fd < 0 || space_fd < 0)
+	{
+		goto err;
+	}
+	if (
+		fstat(mem_fd, &st) != 0 ||
+		st.st_size < (off_t)sizeof(fring_shared_t))
+	{
+		goto err;
+	}
+	map = mmap(
+		NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, mem_fd,
+		0);
+	if (map == MAP_FAILED)
+	{
+		goto err;
+	}
+	shm = map;
+	/* the module may have written anything into the mapping */
+	if (
+		shm->magic != FRING_MAGIC || shm->version != FRING_VERSION ||
+		shm->size == 0 || (shm->size & (shm->size - 1)) != 0 ||
+		shm->head != 0 ||
+		sizeof(fring_shared_t) + shm->size * sizeof(unsigned long) !=
+		(size_t)st.st_size)
+	{
+		munmap(map, st.st_size);
+		goto err;
+	}
+	ring = fxcalloc(1, sizeof(fring_t));
+	ring->shm = shm;
+	ring->data = (unsigned long *)(shm + 1);
+	ring->map_size = st.st_size;
+	ring->size = shm->size;
+	ring->mask = shm->size - 1;
+	ring->mem_fd = mem_fd;
+	ring->doorbell_fd = doorbell_fd;
+	ring->space_fd = space_fd;
+	ring->is_producer = 1;
+
+	return ring;
+
+  err:
+	if (mem_fd >= 0)
+	{
+		close(mem_fd);
+	}
+	if (doorbell_fd >= 0)
+	{
+		close(doorbell_fd);
+	}
+	if (space_fd >= 0)
+	{
+		close(space_fd);
+	}
+
+	return NULL;
+}
+
+int fring_write(fring_t *ring, const unsigned long *data, int size)
+{
+	unsigned long head = ring->pos;
+	unsigned long tail;
+	unsigned long offset;
+	unsigned long to_end;
+	unsigned long n;
+	unsigned long needed;
+
+	if (size <= 0)
+	{
+		return 1;
+	}
+	/* length word plus the packet */
+	n = 1 + (size + sizeof(unsigned long) - 1) / sizeof(unsigned long);
+	offset = head & ring->mask;
+	to_end = ring->size - offset;
+	needed = (n <= to_end) ? n : to_end + n;
+	tail = FRING_LOAD(&ring->shm->tail);
+	if (ring->size - (head - tail) < needed)
+	{
+		ring->full_tail = tail;
+		return 0;
+	}
+	if (n > to_end)
+	{
+		ring->data[offset] = FRING_WRAP;
+		head += to_end;
+		offset = 0;
+	}
+	ring->data[offset] = size;
+	memcpy(&ring->data[offset + 1], data, size);
+	head += n;
+	ring->pos = head;
+	FRING_STORE(&ring->shm->head, head);
+	ring->is_unsignalled = 1;
+
+	return 1;
+}
+
+int fring_has_unsignalled(fring_t *ring)
+{
+	return ring->is_unsignalled;
+}
+
+int fring_signal(fring_t *ring)
+{
+	if (!ring->is_unsignalled)
+	{
+		return 0;
+	}
+	ring->is_unsignalled = 0;
+	/* pairs with the fence in fring_arm() */
+	FRING_FENCE();
+	if (
+		FRING_LOAD(&ring->shm->need_doorbell) &&
+		FRING_CLEAR(&ring->shm->need_doorbell))
+	{
+		fring_kick(ring->doorbell_fd);
+
+		return 1;
+	}
+
+	return 0;
+}
+
+int fring_wait_for_space(fring_t *ring)
+{
+	fring_drain(ring->space_fd);
+	FRING_STORE(&ring->shm->need_space, 1);
+	FRING_FENCE();
+	if (FRING_LOAD(&ring->shm->tail) != ring->full_tail)
+	{
+		FRING_CLEAR(&ring->shm->need_space);
+		return 1;
+	}
+
+	return 0;
+}
+
+int fring_get_space_fd(fring_t *ring)
+{
+	return ring->space_fd;
+}
+
+int fring_get_doorbell_fd(fring_t *ring)
+{
+	return ring->doorbell_fd;
+}
+
+void fring_activate(fring_t *ring)
+{
+	__atomic_or_fetch(&ring->shm->flags, FRING_ACTIVE, __ATOMIC_SEQ_CST);
+
+	return;
+}
+
+int fring_get_mem_fd(fring_t *ring)
+{
+	return ring->mem_fd;
+}
+
+int fring_is_active(fring_t *ring)
+{
+	return (FRING_LOAD(&ring->shm->flags) & FRING_ACTIVE) ? 1 : 0;
+}
+
+void fring_move_doorbell(fring_t *ring, int fd)
+{
+	if (fd == ring->doorbell_fd || fd < 0)
+	{
+		return;
+	}
+	if (dup2(ring->doorbell_fd, fd) < 0)
+	{
+		return;
+	}
+	close(ring->doorbell_fd);
+	ring->doorbell_fd = fd;
+	fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+	return;
+}
+
+int fring_read(fring_t *ring, unsigned long *buf, int max_size)
+{
+	unsigned long tail = ring->pos;
+	unsigned long head;
+	unsigned long offset;
+	unsigned long len;
+	unsigned long n;
+
+	head = FRING_LOAD(&ring->shm->head);
+	if (head == tail)
+	{
+		return (FRING_LOAD(&ring->shm->flags) & FRING_CLOSED) ? -1 : 0;
+	}
+	offset = tail & ring->mask;
+	if (ring->data[offset] == FRING_WRAP)
+	{
+		tail += ring->size - offset;
+		offset = 0;
+	}
+	len = ring->data[offset];
+	n = 1 + (len + sizeof(unsigned long) - 1) / sizeof(unsigned long);
+	if (len > (unsigned long)max_size || head - tail < n)
+	{
+		return -1;
+	}
+	memcpy(buf, &ring->data[offset + 1], len);
+	tail += n;
+	ring->pos = tail;
+	FRING_STORE(&ring->shm->tail, tail);
+	/* pairs with the fence in fring_wait_for_space() */
+	FRING_FENCE();
+	if (
+		FRING_LOAD(&ring->shm->need_space) &&
+		FRING_CLEAR(&ring->shm->need_space))
+	{
+		fring_kick(ring->space_fd);
+	}
+	if (tail == head)
+	{
+		fring_arm(ring);
+	}
+
+	return (int)len;
+}
+
+int fring_wait(fring_t *ring, int alive_fd)
+{
+	struct pollfd fds[2];
+
+	for (;;)
+	{
+		if (FRING_LOAD(&ring->shm->head) != ring->pos)
+		{
+			return 1;
+		}
+		if (FRING_LOAD(&ring->shm->flags) & FRING_CLOSED)
+		{
+			return 0;
+		}
+		if (fring_arm(ring))
+		{
+			return 1;
+		}
+		fds[0].fd = ring->doorbell_fd;
+		fds[0].events = POLLIN;
+		fds[0].revents = 0;
+		/* only errors are reported for the write end of a pipe */
+		fds[1].fd = alive_fd;
+		fds[1].events = 0;
+		fds[1].revents = 0;
+		if (poll(fds, (alive_fd >= 0) ? 2 : 1, -1) < 0 && errno != EINTR)
+		{
+			return 0;
+		}
+		if (fds[1].revents & (POLLERR | POLLHUP | POLLNVAL))
+		{
+			return 0;
+		}
+	}
+}
+
+void fring_destroy(fring_t *ring)
+{
+	if (ring == NULL)
+	{
+		return;
+	}
+	if (ring->is_producer)
+	{
+		__atomic_or_fetch(
+			&ring->shm->flags, FRING_CLOSED, __ATOMIC_SEQ_CST);
+		fring_kick(ring->doorbell_fd);
+	}
+	munmap(ring->shm, ring->map_size);
+	fring_close_fds(ring);
+	free(ring);
+
+	return;
+}
+
+#else /* !HAVE_SHM_RING */
+
+fring_t *fring_create(int size)
+{
+	return NULL;
+}
+
+fring_t *fring_attach(int pid, int mem_fd, int doorbell_fd, int space_fd)
+{
+	return NULL;
+}
+
+int fring_write(fring_t *ring, const unsigned long *data, int size)
+{
+	return 0;
+}
+
+int fring_has_unsignalled(fring_t *ring)
+{
+	return 0;
+}
+
+int fring_signal(fring_t *ring)
+{
+	return 0;
+}
+
+int fring_wait_for_space(fring_t *ring)
+{
+	return 0;
+}
+
+int fring_get_space_fd(fring_t *ring)
+{
+	return -1;
+}
+
+int fring_get_doorbell_fd(fring_t *ring)
+{
+	return -1;
+}
+
+void fring_activate(fring_t *ring)
+{
+	return;
+}
+
+int fring_get_mem_fd(fring_t *ring)
+{
+	return -1;
+}
+
+int fring_is_active(fring_t *ring)
+{
+	return 0;
+}
+
+void fring_move_doorbell(fring_t *ring, int fd)
+{
+	return;
+}
+
+int fring_read(fring_t *ring, unsigned long *buf, int max_size)
+{
+	return -1;
+}
+
+int fring_wait(fring_t *ring, int alive_fd)
+{
+	return 0;
+}
+
+void fring_destroy(fring_t *ring)
+{
+	return;
+}
+
+#endif /* HAVE_SHM_RING */
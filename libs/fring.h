@@ -0,0 +1,104 @@
+/* -*-c-*- */
+
+#ifndef FRING_H
+#define FRING_H
+
+/* Shared memory ring for packets from fvwm to a module.
+ *
+ * A single producer (fvwm) and a single consumer (the module) share a
+ * memfd(2) mapping that holds the read and write positions and the packet
+ * data.  Packets are copied into the ring without a system call.  An
+ * eventfd(2) doorbell wakes the consumer, but only if the consumer has
+ * asked for it because it ran out of packets, so a burst of packets costs a
+ * single wakeup.  A second eventfd tells the producer that space was freed
+ * after it found the ring full.
+ *
+ * A module that wants a ring creates it and sends the numbers of the
+ * descriptors to fvwm (see InitFvwmRing() in Module.h), which copies them
+ * from the module with pidfd_getfd(2).  Until fvwm has switched over, and if
+ * it can not take the ring, the module pipe is used as before.
+ *
+ * Without HAVE_SHM_RING fring_create() and fring_attach() return NULL.
+ */
+
+/* ---------------------------- included header files ---------------------- */
+
+/* ---------------------------- global definitions ------------------------- */
+
+/* default ring size in unsigned longs; must be a power of two */
+#define FRING_DEFAULT_SIZE 16384
+
+/* ---------------------------- global macros ------------------------------ */
+
+/* ---------------------------- type definitions --------------------------- */
+
+typedef struct fring fring_t;
+
+/* ---------------------------- forward declarations ----------------------- */
+
+/* ---------------------------- exported variables (globals) --------------- */
+
+/* ---------------------------- interface functions ------------------------ */
+
+/*
+ * producer side (fvwm)
+ */
+
+/* Map the ring the process pid has created with the given descriptors.
+ * Returns NULL if the descriptors can not be copied or do not describe a new
+ * ring. */
+fring_t *fring_attach(int pid, int mem_fd, int doorbell_fd, int space_fd);
+/* Append a packet of size bytes.  Returns 1 on success and 0 if it does not
+ * fit at the moment.  The consumer is not woken up before the next call to
+ * fring_signal(). */
+int fring_write(fring_t *ring, const unsigned long *data, int size);
+/* Returns non zero if packets have been written since the last call to
+ * fring_signal(). */
+int fring_has_unsignalled(fring_t *ring);
+/* Wake up the consumer if it waits for packets.  Returns 1 if that took a
+ * system call. */
+int fring_signal(fring_t *ring);
+/* Called after fring_write() failed; returns 1 if the consumer has freed
+ * space meanwhile.  Otherwise the consumer will make the descriptor
+ * returned by fring_get_space_fd() readable when it frees space. */
+int fring_wait_for_space(fring_t *ring);
+/* Tell the consumer that packets are now sent through the ring. */
+void fring_activate(fring_t *ring);
+
+/*
+ * consumer side (module)
+ */
+
+/* Create a ring of the given size in unsigned longs.  The descriptors are
+ * close-on-exec.  Returns NULL if shared memory rings are not available. */
+fring_t *fring_create(int size);
+/* The shared memory descriptor to pass to fring_attach(), together with the
+ * doorbell and space descriptors. */
+int fring_get_mem_fd(fring_t *ring);
+/* Returns non zero once the producer has called fring_activate(). */
+int fring_is_active(fring_t *ring);
+/* Move the doorbell descriptor to the number fd, closing whatever fd was
+ * before; the consumer may then select() on fd as on the pipe. */
+void fring_move_doorbell(fring_t *ring, int fd);
+/* Copy the next packet into buf.  Returns its size in bytes, 0 if the ring
+ * is empty and -1 if the producer has gone or the packet is larger than
+ * max_size bytes.  Leaves the doorbell readable while more packets are
+ * waiting. */
+int fring_read(fring_t *ring, unsigned long *buf, int max_size);
+/* Wait until the ring is not empty.  Returns 1 when it is, 0 if the
+ * producer has gone.  The wait also ends if the descriptor alive_fd (which
+ * may be -1) reports an error, e.g. because fvwm died. */
+int fring_wait(fring_t *ring, int alive_fd);
+
+/*
+ * both sides
+ */
+
+int fring_get_space_fd(fring_t *ring);
+int fring_get_doorbell_fd(fring_t *ring);
+
+/* Unmap the ring and close the descriptors.  The producer also tells the
+ * consumer that no more packets will come. */
+void fring_destroy(fring_t *ring);
+
+#endif /* FRING_H */
@@ -17,8 +17,29 @@
 
 #include <stdio.h>
 
+#include "safemalloc.h"
 #include "wild.h"
 
+typedef enum
+{
+	WILD_LITERAL,
+	WILD_ANY,
+	WILD_PREFIX,
+	WILD_SUFFIX,
+	WILD_SUBSTRING,
+	WILD_GENERAL
+} wild_kind_t;
+
+struct wild_pattern
+{
+	wild_kind_t kind;
+	/* the original pattern */
+	char *pattern;
+	/* the pattern without the leading and trailing '*' */
+	char *fixed;
+	int len;
+};
+
 /*
  *      Does `string' match `pattern'? '*' in pattern matches any sub-string
  *      (including the null string) '?' matches any single char. For use
@@ -91,3 +112,126 @@ int matchWildcards(const char *pattern, const char *string)
 	return 0;
 }
 
+
+/*
+ * Compiled patterns.
+ */
+wild_pattern_t *wild_compile(const char *pattern)
+{
+	wild_pattern_t *p;
+	int len;
+	int n_stars;
+	int i;
+	int has_other;
+
+	p = fxcalloc(1, sizeof(wild_pattern_t));
+	p->pattern = fxstrdup(pattern);
+	len = strlen(pattern);
+	for (i = 0, n_stars = 0, has_other = 0; i < len; i++)
+	{
+		if (pattern[i] == '*')
+		{
+			n_stars++;
+		}
+		else if (pattern[i] == '?' || pattern[i] == '\\')
+		{
+			has_other = 1;
+		}
+	}
+	if (has_other)
+	{
+		p->kind = WILD_GENERAL;
+	}
+	else if (n_stars == 0)
+	{
+		p->kind = WILD_LITERAL;
+		p->fixed = p->pattern;
+		p->len = len;
+	}
+	else if (len == 1)
+	{
+		p->kind = WILD_ANY;
+	}
+	else if (n_stars == 1 && pattern[len - 1] == '*')
+	{
+		p->kind = WILD_PREFIX;
+		p->fixed = fxstrdup(pattern);
+		p->len = len - 1;
+		p->fixed[p->len] = 0;
+	}
+	else if (n_stars == 1 && pattern[0] == '*')
+	{
+		p->kind = WILD_SUFFIX;
+		p->fixed = fxstrdup(pattern + 1);
+		p->len = len - 1;
+	}
+	else if (
+		n_stars == 2 && len > 2 && pattern[0] == '*' &&
+		pattern[len - 1] == '*')
+	{
+		p->kind = WILD_SUBSTRING;
+		p->fixed = fxstrdup(pattern + 1);
+		p->len = len - 2;
+		p->fixed[p->len] = 0;
+	}
+	else
+	{
+		p->kind = WILD_GENERAL;
+	}
+
+	return p;
+}
+
+int wild_match(const wild_pattern_t *p, const char *string)
+{
+	int len;
+
+	if (p == NULL)
+	{
+		return 1;
+	}
+	if (string == NULL)
+	{
+		return (p->kind == WILD_ANY);
+	}
+	switch (p->kind)
+	{
+	case WILD_LITERAL:
+		return (strcmp(p->fixed, string) == 0);
+	case WILD_ANY:
+		return 1;
+	case WILD_PREFIX:
+		return (strncmp(p->fixed, string, p->len) == 0);
+	case WILD_SUFFIX:
+		len = strlen(string);
+		return (
+			len >= p->len &&
+			memcmp(p->fixed, string + len - p->len, p->len) == 0);
+	case WILD_SUBSTRING:
+		return (strstr(string, p->fixed) != NULL);
+	case WILD_GENERAL:
+	default:
+		return matchWildcards(p->pattern, string);
+	}
+}
+
+void wild_free(wild_pattern_t *p)
+{
+	if (p == NULL)
+	{
+		return;
+	}
+	if (p->fixed != NULL && p->fixed != p->pattern)
+	{
+		free(p->fixed);
+	}
+	free(p->pattern);
+	free(p);
+
+	return;
+}
+
+const char *wild_pattern_string(const wild_pattern_t *p)
+{
+	return p->pattern;
+}
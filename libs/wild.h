@@ -1,5 +1,8 @@
 /* -*-c-*- */
 
+#ifndef FVWMLIB_WILD_H
+#define FVWMLIB_WILD_H
+
 /*
  *      Does `string' match `pattern'? '*' in pattern matches any sub-string
  *      (including the null string) '?' matches any single char. For use
@@ -10,3 +13,19 @@
  *
  */
 int matchWildcards(const char *pattern, const char *string);
+
+/*
+ * A pattern that is matched against many strings can be compiled once with
+ * wild_compile().  wild_match() gives the same result as matchWildcards(),
+ * but patterns without wildcards, and patterns of the form "foo*", "*foo"
+ * and "*foo*" are matched with a single string comparison.
+ */
+typedef struct wild_pattern wild_pattern_t;
+
+wild_pattern_t *wild_compile(const char *pattern);
+int wild_match(const wild_pattern_t *pattern, const char *string);
+void wild_free(wild_pattern_t *pattern);
+/* The original pattern string. */
+const char *wild_pattern_string(const wild_pattern_t *pattern);
+
+#endif /* FVWMLIB_WILD_H */
@@ -0,0 +1,267 @@
+/* -*-c-*- */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see: <http://www.gnu.org/licenses/>
+ */
+
+/* ---------------------------- included header files ---------------------- */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "safemalloc.h"
+#include "wintable.h"
+
+/* ---------------------------- local definitions -------------------------- */
+
+/* must be a power of two */
+#define WINTABLE_MIN_SIZE 256
+
+/* ---------------------------- local macros ------------------------------- */
+
+/* Fibonacci hashing; window ids are mostly sequential within a client, the
+ * multiplication spreads them over the whole table */
+#define WINTABLE_HASH(t, w) \
+	((unsigned int)(((uint32_t)(w) * 2654435769u) >> (32 - (t)->bits)))
+
+/* ---------------------------- imports ------------------------------------ */
+
+/* ---------------------------- included code files ------------------------ */
+
+/* ---------------------------- local types -------------------------------- */
+
+typedef struct
+{
+	/* None marks an empty slot */
+	Window w;
+	void *data;
+} wintable_entry_t;
+
+struct wintable
+{
+	wintable_entry_t *entries;
+	unsigned int size;
+	unsigned int mask;
+	unsigned int bits;
+	unsigned int count;
+	/* statistics */
+	unsigned long lookups;
+	unsigned long probes;
+};
+
+/* ---------------------------- forward declarations ----------------------- */
+
+/* ---------------------------- local variables ---------------------------- */
+
+/* ---------------------------- exported variables (globals) --------------- */
+
+/* ---------------------------- local functions ---------------------------- */
+
+static void wintable_alloc(wintable_t *table, unsigned int bits)
+{
+	table->bits = bits;
+	table->size = 1u << bits;
+	table->mask = table->size - 1;
+	table->entries = fxcalloc(table->size, sizeof(wintable_entry_t));
+
+	return;
+}
+
+static void wintable_store(wintable_t *table, Window w, void *data)
+{
+	unsigned int i;
+
+	for (i = WINTABLE_HASH(table, w); ; i = (i + 1) & table->mask)
+	{
+		wintable_entry_t *e = &table->entries[i];
+
+		if (e->w == w)
+		{
+			e->data = data;
+			return;
+		}
+		if (e->w == None)
+		{
+			e->w = w;
+			e->data = data;
+			table->count++;
+			return;
+		}
+	}
+}
+
+static void wintable_grow(wintable_t *table)
+{
+	wintable_entry_t *old = table->entries;
+	unsigned int old_size = table->size;
+	unsigned int i;
+
+	wintable_alloc(table, table->bits + 1);
+	table->count = 0;
+	for (i = 0; i < old_size; i++)
+	{
+		if (old[i].w != None)
+		{
+			wintable_store(table, old[i].w, old[i].data);
+		}
+	}
+	free(old);
+
+	return;
+}
+
+/* ---------------------------- interface functions ------------------------ */
+
+wintable_t *wintable_create(void)
+{
+	wintable_t *table;
+	unsigned int bits;
+
+	table = fxcalloc(1, sizeof(wintable_t));
+	for (bits = 0; (1u << bits) < WINTABLE_MIN_SIZE; bits++)
+	{
+		/* nothing */
+	}
+	wintable_alloc(table, bits);
+
+	return table;
+}
+
+void wintable_destroy(wintable_t *table)
+{
+	if (table == NULL)
+	{
+		return;
+	}
+	free(table->entries);
+	free(table);
+
+	return;
+}
+
+void wintable_insert(wintable_t *table, Window w, void *data)
+{
+	if (w == None)
+	{
+		return;
+	}
+	/* keep the load factor below one half */
+	if (2 * (table->count + 1) > table->size)
+	{
+		wintable_grow(table);
+	}
+	wintable_store(table, w, data);
+
+	return;
+}
+
+int wintable_find(wintable_t *table, Window w, void **ret_data)
+{
+	unsigned int i;
+
+	table->lookups++;
+	if (w == None)
+	{
+		return 0;
+	}
+	for (i = WINTABLE_HASH(table, w); ; i = (i + 1) & table->mask)
+	{
+		wintable_entry_t *e = &table->entries[i];
+
+		table->probes++;
+		if (e->w == w)
+		{
+			*ret_data = e->data;
+			return 1;
+		}
+		if (e->w == None)
+		{
+			return 0;
+		}
+	}
+}
+
+int wintable_remove(wintable_t *table, Window w)
+{
+	unsigned int i;
+	unsigned int j;
+
+	if (w == None)
+	{
+		return 0;
+	}
+	for (i = WINTABLE_HASH(table, w); ; i = (i + 1) & table->mask)
+	{
+		if (table->entries[i].w == w)
+		{
+			break;
+		}
+		if (table->entries[i].w == None)
+		{
+			return 0;
+		}
+	}
+	/* backward shift deletion: move entries that would not be found
+	 * anymore into the hole, so no tombstones are needed */
+	for (j = (i + 1) & table->mask; table->entries[j].w != None;
+	     j = (j + 1) & table->mask)
+	{
+		unsigned int home;
+
+		home = WINTABLE_HASH(table, table->entries[j].w);
+		/* move the entry unless its home lies cyclically in (i, j] */
+		if (((j - home) & table->mask) >= ((j - i) & table->mask))
+		{
+			table->entries[i] = table->entries[j];
+			i = j;
+		}
+	}
+	table->entries[i].w = None;
+	table->entries[i].data = NULL;
+	table->count--;
+
+	return 1;
+}
+
+void wintable_print_info(wintable_t *table, const char *name, int verbose)
+{
+	fprintf(stderr,
+		"%s: %u windows in %u slots, %lu lookups", name,
+		table->count, table->size, table->lookups);
+	if (table->lookups > 0)
+	{
+		fprintf(stderr, " (%.2f probes per lookup)",
+			(double)table->probes / table->lookups);
+	}
+	fprintf(stderr, "\n");
+	if (verbose > 0)
+	{
+		unsigned int i;
+		unsigned int run = 0;
+		unsigned int max_run = 0;
+
+		for (i = 0; i < table->size; i++)
+		{
+			run = (table->entries[i].w != None) ? run + 1 : 0;
+			if (run > max_run)
+			{
+				max_run = run;
+			}
+		}
+		fprintf(stderr, "  longest probe sequence: %u\n", max_run);
+	}
+
+	return;
+}
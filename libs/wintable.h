@@ -0,0 +1,43 @@
+/* -*-c-*- */
+
+#ifndef WINTABLE_H
+#define WINTABLE_H
+
+/* Maps X window ids to a pointer.
+ *
+ * A replacement for the Xlib context manager (XSaveContext, XFindContext,
+ * XDeleteContext) for lookups that are done on every event.  The table uses
+ * open addressing with linear probing and grows as needed, so a lookup is
+ * normally a single hash and compare.  It is not thread safe.
+ */
+
+/* ---------------------------- included header files ---------------------- */
+
+#include <X11/Xlib.h>
+
+/* ---------------------------- global definitions ------------------------- */
+
+/* ---------------------------- global macros ------------------------------ */
+
+/* ---------------------------- type definitions --------------------------- */
+
+typedef struct wintable wintable_t;
+
+/* ---------------------------- exported variables (globals) --------------- */
+
+/* ---------------------------- interface functions ------------------------ */
+
+wintable_t *wintable_create(void);
+void wintable_destroy(wintable_t *table);
+/* Store data for the window, replacing any old value.  None can not be
+ * stored. */
+void wintable_insert(wintable_t *table, Window w, void *data);
+/* Returns 1 and the data in *ret_data if the window is in the table.
+ * Returns 0 and leaves *ret_data alone otherwise. */
+int wintable_find(wintable_t *table, Window w, void **ret_data);
+/* Removes the window from the table.  Returns 0 if it was not there. */
+int wintable_remove(wintable_t *table, Window w);
+/* Print size and probe statistics. */
+void wintable_print_info(wintable_t *table, const char *name, int verbose);
+
+#endif /* WINTABLE_H */
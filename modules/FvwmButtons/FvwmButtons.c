@@ -2395,14 +2395,19 @@ int My_FNextEvent(Display *Dpy, XEvent *event)
 
 		if (FD_ISSET(fd[1], &in_fdset))
 		{
-			FvwmPacket* packet = ReadFvwmPacket(fd[1]);
-			if ( packet == NULL )
+			FvwmPacket **packets;
+			int i;
+			int n;
+
+			n = ReadFvwmPackets(fd[1], &packets);
+			if (n == 0)
 			{
 				DeadPipe(0);
 			}
-			else
+			for (i = 0; i < n; i++)
 			{
-				process_message( packet->type, packet->body );
+				process_message(
+					packets[i]->type, packets[i]->body);
 			}
 		}
 
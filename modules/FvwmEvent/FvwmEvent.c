@@ -152,6 +152,7 @@ static event_entry extended_message_event_table[] =
 	EVENT_ENTRY( "leave_window", 0 ),
 	EVENT_ENTRY( "property_change", 0),
 	EVENT_ENTRY( "reply", 0), /* FvwmEvent will never receive MX_REPLY */
+	EVENT_ENTRY( "window_snapshot", -1),
 	EVENT_ENTRY(NULL,0)
 };
 static event_entry builtin_event_table[] =
@@ -218,9 +219,7 @@ void unlock_event(unsigned long evtype)
 int main(int argc, char **argv)
 {
 	char *s;
-	unsigned long header[FvwmPacketHeaderSize];
-	unsigned long body[FvwmPacketBodyMaxSize];
-	int total, remaining, count, event;
+	int event;
 	int is_extended_msg;
 
 	cmd_line = fxmalloc(1);
@@ -304,6 +303,8 @@ int main(int argc, char **argv)
 	{
 		last_time = time(0);
 	}
+	/* packets are read with ReadFvwmPacket() only */
+	InitFvwmRing(fd);
 	/* tell fvwm we're running */
 	SetMessageMask(fd, m_selected);
 	SetMessageMask(fd, mx_selected | M_EXTENDED_MSG);
@@ -328,46 +329,21 @@ int main(int argc, char **argv)
 	{
 		unsigned long msg_bit;
 		event_entry *event_table;
+		FvwmPacket *packet;
 
-		if ((count = read(fd[1], header, FvwmPacketHeaderSize_byte)) <=
-		    0)
+		packet = ReadFvwmPacket(fd[1]);
+		if (packet == NULL)
 		{
 			isTerminated = 1;
 			continue;
 		}
-		/* if this read is interrrupted EINTR, the wrong event is
-		 * triggered! */
-
-		if (header[0] != START_FLAG)
-		{
-			/* should find something better for resyncing */
-			unlock_event(header[1]);
-			continue;
-		}
 
 		/* Ignore events that occur during the delay period. */
 		now = time(0);
-
-		/* junk the event body */
-		total=0;
-		remaining = (header[2] - FvwmPacketHeaderSize) *
-			sizeof(unsigned long);
-		while (remaining)
-		{
-			if ((count=read(fd[1],&body[total],remaining)) < 0)
-			{
-				isTerminated = 1;
-				unlock_event(header[1]);
-				continue;
-			}
-			remaining -= count;
-			total +=count;
-		}
-
 		if (now < last_time + audio_delay + start_audio_delay)
 		{
 			/* quash event */
-			unlock_event(header[1]);
+			unlock_event(packet->type);
 			continue;
 		}
 		else
@@ -376,10 +352,10 @@ int main(int argc, char **argv)
 		}
 
 		/* event will equal the number of shifts in the base-2
-		 * header[1] number.  Could use log here but this should be
+		 * packet type.  Could use log here but this should be
 		 * fast enough. */
 		event = -1;
-		msg_bit = header[1];
+		msg_bit = packet->type;
 		is_extended_msg = (msg_bit & M_EXTENDED_MSG);
 		msg_bit &= ~M_EXTENDED_MSG;
 		while (msg_bit)
@@ -403,8 +379,8 @@ int main(int argc, char **argv)
 		{
 			event_table = message_event_table;
 		}
-		execute_event(event_table, event, body);
-		unlock_event(header[1]);
+		execute_event(event_table, event, packet->body);
+		unlock_event(packet->type);
 	} /* while */
 	execute_event(builtin_event_table, BUILTIN_SHUTDOWN, NULL);
 
@@ -310,6 +310,8 @@ main(int argc, char **argv)
 
 	assert(globals.managers);
 
+	/* packets are read with ReadFvwmPacket() only */
+	InitFvwmRing(fvwm_fd);
 	SetMessageMask(
 		fvwm_fd, M_CONFIGURE_WINDOW | M_RES_CLASS | M_RES_NAME |
 		M_ADD_WINDOW | M_DESTROY_WINDOW | M_ICON_NAME |
@@ -319,6 +321,12 @@ main(int argc, char **argv)
 		M_MINI_ICON | M_STRING | M_WINDOWSHADE | M_DEWINDOWSHADE);
   /* extended messages */
   SetMessageMask(fvwm_fd, MX_VISIBLE_ICON_NAME | MX_PROPERTY_CHANGE);
+  /* only the latest state of each window is shown */
+  SetCoalesceMask(
+	  fvwm_fd, M_CONFIGURE_WINDOW | M_RES_CLASS | M_RES_NAME |
+	  M_ICON_NAME | M_FOCUS_CHANGE | M_WINDOW_NAME | M_VISIBLE_NAME |
+	  M_MINI_ICON);
+  SetCoalesceMask(fvwm_fd, MX_VISIBLE_ICON_NAME);
 
   SendText(fvwm_fd, "Send_WindowList", 0);
 
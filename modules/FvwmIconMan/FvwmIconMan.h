@@ -22,6 +22,7 @@
 #include "fvwm/fvwm.h"
 #include "libs/vpacket.h"
 #include "libs/FTips.h"
+#include "libs/wild.h"
 
 #ifndef DEFAULT_ACTION
 #define DEFAULT_ACTION "Iconify"
@@ -121,6 +122,7 @@ typedef struct win_list {
 typedef struct string_list {
 	NameType type;
 	char *string;
+	wild_pattern_t *pattern;
 	struct string_list *next;
 } StringEl;
 
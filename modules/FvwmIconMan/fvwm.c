@@ -849,18 +849,22 @@ static void ProcessMessage(Ulong type, FvwmPacketBody *body)
 
 void ReadFvwmPipe(void)
 {
-	FvwmPacket* packet;
+	FvwmPacket **packets;
+	int i;
+	int n;
 
 	PrintMemuse();
 	ConsoleDebug(FVWM, "DEBUG: entering ReadFvwmPipe\n");
 
-	if ((packet = ReadFvwmPacket(fvwm_fd[1])) == NULL)
+	n = ReadFvwmPackets(fvwm_fd[1], &packets);
+	if (n == 0)
 	{
 		exit(0);
 	}
-	else
+	for (i = 0; i < n; i++)
 	{
-		ProcessMessage(packet->type, (FvwmPacketBody *)packet->body);
+		ProcessMessage(
+			packets[i]->type, (FvwmPacketBody *)packets[i]->body);
 	}
 
 	ConsoleDebug(FVWM, "DEBUG: leaving ReadFvwmPipe\n");
@@ -96,6 +96,7 @@ void add_to_stringlist (StringList *list, char *s)
   new->type = type;
 
   strcpy (new->string, pat);
+  new->pattern = wild_compile (pat);
   new->next = list->list;
   if (list->list)
     list->mask |= type;
@@ -106,27 +107,27 @@ void add_to_stringlist (StringList *list, char *s)
   ConsoleDebug (WINLIST, "Exiting add_to_stringlist\n");
 }
 
-static int matches_string (NameType type, char *pattern, char *tname,
-			   char *iname, char *rname, char *cname)
+static int matches_string (NameType type, wild_pattern_t *pattern,
+			   char *tname, char *iname, char *rname, char *cname)
 {
   int ans = 0;
 
   ConsoleDebug (WINLIST, "matches_string: type: 0x%x pattern: %s\n",
-		type, pattern);
+		type, wild_pattern_string (pattern));
   ConsoleDebug (WINLIST, "\tstrings: %s:%s %s:%s\n", tname, iname,
 		rname, cname);
 
   if (tname && (type == ALL_NAME || type == TITLE_NAME)) {
-    ans |= matchWildcards (pattern, tname);
+    ans |= wild_match (pattern, tname);
   }
   if (iname && (type == ALL_NAME || type == ICON_NAME)) {
-    ans |= matchWildcards (pattern, iname);
+    ans |= wild_match (pattern, iname);
   }
   if (rname && (type == ALL_NAME || type == RESOURCE_NAME)) {
-    ans |= matchWildcards (pattern, rname);
+    ans |= wild_match (pattern, rname);
   }
   if (cname && (type == ALL_NAME || type == CLASS_NAME)) {
-    ans |= matchWildcards (pattern, cname);
+    ans |= wild_match (pattern, cname);
   }
 
   ConsoleDebug (WINLIST, "\tmatches_string: %d\n", ans);
@@ -211,7 +212,7 @@ static int iconmanager_show (WinManager *man, char *tname, char *iname,
 
   for (string = man->dontshow.list; string; string = string->next) {
     ConsoleDebug (WINLIST, "Matching: %s\n", string->string);
-    if (matches_string (string->type, string->string, tname, iname,
+    if (matches_string (string->type, string->pattern, tname, iname,
 			rname, cname)) {
       ConsoleDebug (WINLIST, "Don't show\n");
       in_dontshowlist = 1;
@@ -226,7 +227,7 @@ static int iconmanager_show (WinManager *man, char *tname, char *iname,
     else {
       for (string = man->show.list; string; string = string->next) {
 	ConsoleDebug (WINLIST, "Matching: %s\n", string->string);
-	if (matches_string (string->type, string->string, tname, iname,
+	if (matches_string (string->type, string->pattern, tname, iname,
 			    rname, cname)) {
 	  ConsoleDebug (WINLIST, "Show\n");
 	  in_showlist = 1;
@@ -318,6 +318,8 @@ int main(int argc, char **argv)
   /* make a temp window for any pixmaps, deleted later */
   initialize_viz_pager();
 
+  /* packets are read with ReadFvwmPacket() and ReadFvwmPackets() only */
+  InitFvwmRing(fd);
   SetMessageMask(fd,
 		 M_VISIBLE_NAME |
 		 M_ADD_WINDOW|
@@ -341,7 +343,17 @@ int main(int argc, char **argv)
   SetMessageMask(fd,
 		 MX_VISIBLE_ICON_NAME|
 		 MX_PROPERTY_CHANGE|
-		 MX_REPLY);
+		 MX_REPLY|
+		 MX_WINDOW_SNAPSHOT);
+  /* the pager only draws the latest state of each window */
+  SetCoalesceMask(fd,
+		  M_VISIBLE_NAME|
+		  M_CONFIGURE_WINDOW|
+		  M_FOCUS_CHANGE|
+		  M_RES_NAME|
+		  M_RES_CLASS|
+		  M_MINI_ICON);
+  SetCoalesceMask(fd, MX_VISIBLE_ICON_NAME);
   ParseOptions();
   if (is_transient)
   {
@@ -388,7 +400,17 @@ int main(int argc, char **argv)
   /* Create a list of all windows */
   /* Request a list of all windows,
    * wait for ConfigureWindow packets */
-  SendInfo(fd,"Send_WindowList",0);
+  /* windows on other monitors are never shown */
+  if (monitor_to_track != NULL)
+  {
+    char *filter;
+
+    filter = fxmalloc(strlen(monitor_to_track) + 9);
+    sprintf(filter, "Monitor %s", monitor_to_track);
+    SetMessageFilter(fd, filter);
+    free(filter);
+  }
+  SendInfo(fd,"Send_WindowList Snapshot",0);
 
   if (is_transient)
   {
@@ -547,6 +569,15 @@ void process_message( FvwmPacket* packet )
     case MX_REPLY:
 	    list_reply(body);
 	    break;
+    case MX_WINDOW_SNAPSHOT:
+      if (FvwmSnapshotAddPacket(packet) == 1)
+      {
+	FvwmPacket *p;
+
+	while ((p = FvwmSnapshotNextPacket()) != NULL)
+	  process_message(p);
+      }
+      break;
     default:
       /* ignore unknown packet */
       break;
@@ -1513,10 +1544,15 @@ int My_XNextEvent(Display *dpy, XEvent *event)
 
   if(FD_ISSET(fd[1], &in_fdset))
     {
-      FvwmPacket* packet = ReadFvwmPacket(fd[1]);
-      if ( packet == NULL )
+      FvwmPacket **packets;
+      int i;
+      int n;
+
+      n = ReadFvwmPackets(fd[1], &packets);
+      if (n == 0)
 	  exit(0);
-      process_message( packet );
+      for (i = 0; i < n; i++)
+	process_message( packets[i] );
     }
   }
   return 0;
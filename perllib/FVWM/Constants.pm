@@ -42,11 +42,12 @@ use constant MX_ENTER_WINDOW => ((1<<1)|M_EXTENDED_MSG);
 use constant MX_LEAVE_WINDOW => ((1<<2)|M_EXTENDED_MSG);
 use constant MX_PROPERTY_CHANGE => ((1<<3)|M_EXTENDED_MSG);
 use constant MX_REPLY => ((1<<4)|M_EXTENDED_MSG);
+use constant MX_WINDOW_SNAPSHOT => ((1<<5)|M_EXTENDED_MSG);
 use constant MX_PROPERTY_CHANGE_NONE => 0;
 use constant MX_PROPERTY_CHANGE_BACKGROUND => 1;
 use constant MX_PROPERTY_CHANGE_SWALLOW => 2;
 use constant MAX_MSG_MASK => 0x7fffffff;
-use constant MAX_XMSG_MASK => 0x0000001f;
+use constant MAX_XMSG_MASK => 0x0000003f;
 use constant HEADER_SIZE => 4;
 use constant START_FLAG => 0xffffffff;
 use constant RESPONSE_READY => "NOP FINISHED STARTUP";
@@ -91,6 +92,7 @@ use constant INTSIZE => $Config{longsize};
   MX_LEAVE_WINDOW
   MX_PROPERTY_CHANGE
   MX_REPLY
+  MX_WINDOW_SNAPSHOT
   MX_PROPERTY_CHANGE_NONE
   MX_PROPERTY_CHANGE_BACKGROUND
   MX_PROPERTY_CHANGE_SWALLOW
@@ -165,6 +167,7 @@ For more information, see L<FVWM::Module>.
   MX_LEAVE_WINDOW
   MX_PROPERTY_CHANGE
   MX_REPLY
+  MX_WINDOW_SNAPSHOT
   MX_PROPERTY_CHANGE_NONE
   MX_PROPERTY_CHANGE_BACKGROUND
   MX_PROPERTY_CHANGE_SWALLOW
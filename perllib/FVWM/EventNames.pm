@@ -450,6 +450,20 @@ $EVENTS_INFO = {
 		],
 	},
 
+	&MX_WINDOW_SNAPSHOT     => {
+		format => "L!3a*",
+		fields => [
+			version      => number,
+			total_words  => number,
+			offset_words => number,
+			words        => looped,
+		],
+		loop_format => "L!a*",
+		loop_fields => [
+			word         => number,
+		],
+	},
+
 	"faked"                 => {
 		format => "",
 		fields => [